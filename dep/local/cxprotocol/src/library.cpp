@@ -1,4 +1,5 @@
 #include "library.h"
+#include "schema.h"
 // cx-ipc
 
 namespace cx::ipc
@@ -6,104 +7,50 @@ namespace cx::ipc
     using u64 = std::uint64_t;
     using uchar = unsigned char;
 
-    template <>
-    auto deserialize_payload_length<std::endian::big>(const unsigned char data[2]) -> uint16_t {
-        std::uint16_t payload_size = 0;
-        std::memcpy(&payload_size, data, 2);
-        return payload_size;
+    // The length field is big-endian on the wire, and the header value has the 'c' of "cxwm-ipc" as its most significant byte, on every
+    // host. The loads & stores see to that, so the Endian parameter no longer picks an implementation; it's kept for the sake of callers
+    template <std::endian Endian>
+    auto deserialize_payload_length(const unsigned char data[2]) -> uint16_t {
+        return schema::load_be<std::uint16_t>(reinterpret_cast<const std::byte*>(data));
     }
 
-    template <>
-    auto deserialize_payload_length<std::endian::little>(const unsigned char data[2]) -> uint16_t {
-        char little_end_buf[2];
-        little_end_buf[0] = data[1];
-        little_end_buf[1] = data[0];
-        std::uint16_t payload_size = 0;
-        std::memcpy(&payload_size, little_end_buf, 2);
-        return payload_size;
-    }
-
-    template <>
-    auto serialize_payload_length<std::endian::big>(std::uint16_t payload_len) -> std::array<char, 2> {
+    template <std::endian Endian>
+    auto serialize_payload_length(std::uint16_t payload_len) -> std::array<char, 2> {
         std::array<char, 2> serialized{};
-        std::memcpy(serialized.data(), &payload_len, 2);
+        schema::store_be(reinterpret_cast<std::byte*>(serialized.data()), payload_len);
         return serialized;
     }
 
-    template <>
-    auto serialize_payload_length<std::endian::little>(std::uint16_t payload_len) -> std::array<char, 2> {
-        std::array<char, 2> serialized{};
-        std::memcpy(serialized.data(), &payload_len, 2);
-        char hi = serialized[1];
-        char lo = serialized[0];
-        serialized[0] = hi;
-        serialized[1] = lo;
-        return serialized;
+    template <std::endian Endian>
+    auto header_value() -> unsigned long {
+        return schema::load_be<std::uint64_t>(reinterpret_cast<const std::byte*>(HEADER_IDENTIFIER.data()));
     }
 
-
-    template <>
-    auto header_value<std::endian::big>() -> unsigned long {
-        unsigned long headerValue = 0;
-        std::memcpy(&headerValue, HEADER_IDENTIFIER.data(), 8);
-        return headerValue;
+    template <std::endian Endian>
+    std::size_t message_payload_length(const Message& message) {
+        return deserialize_payload_length(message.buffer.data() + HEADER_IDENTIFIER.size());
     }
 
-    template <>
-    auto header_value<std::endian::little>() -> unsigned long {
-        char little_endianed[HEADER_IDENTIFIER.size()];
-        std::copy(HEADER_IDENTIFIER.rbegin(), HEADER_IDENTIFIER.rend(), little_endianed);
-        unsigned long headerValue = 0;
-        std::memcpy(&headerValue, HEADER_IDENTIFIER.data(), 8);
-        return headerValue;
-    }
-
-        
-    template <>
-    std::size_t message_payload_length<std::endian::big>(const Message& message) {
-        unsigned char payload_field[2]{message.buffer[HEADER_IDENTIFIER.size()], message.buffer[HEADER_IDENTIFIER.size() + 1]};
-        return deserialize_payload_length(payload_field);
-    }
-
-    template <>
-    std::size_t message_payload_length<std::endian::little>(const Message& message) {
-        unsigned char payload_field[2]{message.buffer[HEADER_IDENTIFIER.size()], message.buffer[HEADER_IDENTIFIER.size() + 1]};
-        return deserialize_payload_length(payload_field);
-    }
+    template auto deserialize_payload_length<std::endian::big>(const unsigned char data[2]) -> uint16_t;
+    template auto deserialize_payload_length<std::endian::little>(const unsigned char data[2]) -> uint16_t;
+    template auto serialize_payload_length<std::endian::big>(std::uint16_t payload_len) -> std::array<char, 2>;
+    template auto serialize_payload_length<std::endian::little>(std::uint16_t payload_len) -> std::array<char, 2>;
+    template auto header_value<std::endian::big>() -> unsigned long;
+    template auto header_value<std::endian::little>() -> unsigned long;
+    template std::size_t message_payload_length<std::endian::big>(const Message& message);
+    template std::size_t message_payload_length<std::endian::little>(const Message& message);
 
     bool payload_ok(const char* data, std::size_t size) {
-        std::string_view view{data, size};
-        auto pay_load_size = 0;
-        if(view.substr(0, HEADER_IDENTIFIER.size()) != HEADER_IDENTIFIER) {
+        if(size < FIXED_FIELDS_SIZE || !starts_with_marker(data, HEADER_IDENTIFIER))
             return false;
-        } else {
-            view.remove_prefix(HEADER_IDENTIFIER.size());
-            uchar pl[2]{(uchar)view.at(0), (uchar)view.at(1)};
-            auto payload_size = deserialize_payload_length(pl);
-            auto supposed_full_size = HEADER_SIZE + PACKAGE_END.size() + pay_load_size;
-            view.remove_prefix(2);
-            view.remove_suffix(PACKAGE_END.size());
-            assert(view.size() == pay_load_size && "Payload size not computed correctly");
-            assert(size == supposed_full_size && "Data packet and extracted payload size does not match");
-            view.remove_prefix(2);
-            try {
-                if(payload_size + HEADER_SIZE > size) throw std::out_of_range{"Decoded payload size larger than provided data"};
-                view.remove_prefix(payload_size);
-                if(view.substr(0, PACKAGE_END.size()) == PACKAGE_END) {
-                    return true;
-                } else {
-                    return false;
-                }
-            } catch(std::exception& e) {
-                return false;
-            }
-        }
+        const unsigned char length_field[2]{(uchar)data[HEADER_IDENTIFIER.size()], (uchar)data[HEADER_IDENTIFIER.size() + 1]};
+        auto payload_size = deserialize_payload_length(length_field);
+        return payload_size <= MAX_PAYLOAD_LENGTH && size == FIXED_FIELDS_SIZE + payload_size &&
+               starts_with_marker(data + HEADER_SIZE + payload_size, PACKAGE_END);
     }
 
     bool payload_ok(const Message& msg) {
-        unsigned char header_field[HEADER_IDENTIFIER.size()];
-        unsigned char payload_size_field[2];
-
+        return payload_ok(reinterpret_cast<const char*>(msg.buffer.data()), msg.message_size);
     }
 
     std::optional<std::string> extract_payload(const std::array<std::byte, 2048>& buf, std::size_t data_in_buffer) {
@@ -144,27 +91,27 @@ namespace cx::ipc
     std::optional<std::vector<std::string>> extract_payloads(const std::array<std::byte, 2048>& buf, std::size_t data_in_buffer)
     {
         std::vector<std::string> payloads{};
-        std::string_view strViewBuf{(const char*)buf.data(), data_in_buffer};
-        std::vector<std::pair<std::size_t, std::size_t>> messages_ranges{};
-        auto sub_range_begin = 0;
-        auto sub_range_end = PACKAGE_END.size();
-        auto range_start = 0;
-        while(sub_range_end <= strViewBuf.size()) {
-            if(strViewBuf.substr(sub_range_begin, sub_range_end) == PACKAGE_END) {
-                messages_ranges.emplace_back(range_start, sub_range_end);
-                range_start = sub_range_end+1;
-            }
-            sub_range_begin++; sub_range_end++;
-        }
-
-        std::array<std::byte, 2048> tmp_buf{};
-        for(const auto& [begin, end] : messages_ranges) {
-            auto length = end - begin;
-            std::copy(buf.begin() + begin, buf.begin() + end, tmp_buf.begin());
-            auto possible_payload = extract_payload(tmp_buf, length);
-            if(possible_payload) {
-                payloads.push_back(possible_payload.value());
+        std::string_view rest{(const char*)buf.data(), data_in_buffer};
+        for(auto header = find_header(rest); header != std::string_view::npos; header = find_header(rest)) {
+            rest.remove_prefix(header);
+            if(rest.size() < FIXED_FIELDS_SIZE)
+                break;
+            const unsigned char length_field[2]{(uchar)rest[HEADER_IDENTIFIER.size()], (uchar)rest[HEADER_IDENTIFIER.size() + 1]};
+            const std::size_t frame_size = FIXED_FIELDS_SIZE + deserialize_payload_length(length_field);
+            if(frame_size <= rest.size() && payload_ok(rest.data(), frame_size)) {
+                payloads.emplace_back(rest.substr(HEADER_SIZE, frame_size - FIXED_FIELDS_SIZE));
+                rest.remove_prefix(frame_size);
+                continue;
             }
+            // The length field is off. The broken frame ends at the next footer, unless another header comes first
+            auto footer = find_footer(rest);
+            auto next_header = find_header(rest.substr(1));
+            if(footer != std::string_view::npos && (next_header == std::string_view::npos || footer < next_header + 1))
+                rest.remove_prefix(footer + PACKAGE_END.size());
+            else if(next_header != std::string_view::npos)
+                rest.remove_prefix(next_header + 1);
+            else
+                break;
         }
 
         if(payloads.empty()) return {};
@@ -196,6 +143,107 @@ namespace cx::ipc
         return Message{buffer, FIXED_FIELDS_SIZE + payload_len};
     }
 
+    auto encode_iovec(std::string_view payload, FrameHeaderBytes& header) -> std::optional<std::array<iovec, 3>> {
+        if(payload.size() > MAX_PAYLOAD_LENGTH)
+            return {};
+        auto length = serialize_payload_length(static_cast<std::uint16_t>(payload.size()));
+        std::copy(length.begin(), length.end(), std::copy(HEADER_IDENTIFIER.begin(), HEADER_IDENTIFIER.end(), header.begin()));
+        return std::array<iovec, 3>{iovec{header.data(), header.size()},
+                                    iovec{const_cast<char*>(payload.data()), payload.size()},
+                                    iovec{const_cast<char*>(PACKAGE_END.data()), PACKAGE_END.size()}};
+    }
+
+    auto encode_into(std::string_view payload, std::span<std::byte> out) -> std::optional<std::size_t> {
+        const auto frame_size = FIXED_FIELDS_SIZE + payload.size();
+        if(payload.size() > MAX_PAYLOAD_LENGTH || out.size() < frame_size)
+            return {};
+        auto length = serialize_payload_length(static_cast<std::uint16_t>(payload.size()));
+        auto* data = reinterpret_cast<char*>(out.data());
+        data = std::copy(HEADER_IDENTIFIER.begin(), HEADER_IDENTIFIER.end(), data);
+        data = std::copy(length.begin(), length.end(), data);
+        data = std::copy(payload.begin(), payload.end(), data);
+        std::copy(PACKAGE_END.begin(), PACKAGE_END.end(), data);
+        return frame_size;
+    }
+
+    namespace {
+        auto read_u32(const char* data) -> std::uint32_t {
+            return schema::load_be<std::uint32_t>(reinterpret_cast<const std::byte*>(data));
+        }
+
+        void write_u32(uchar* out, std::uint32_t value) {
+            schema::store_be(reinterpret_cast<std::byte*>(out), value);
+        }
+    }
+
+    auto is_v2_frame(std::string_view data) -> bool {
+        return static_cast<uchar>(data[HEADER_IDENTIFIER.size()]) == 0xFF && static_cast<uchar>(data[HEADER_IDENTIFIER.size() + 1]) == 0xFF;
+    }
+
+    auto encode_header(const FrameHeader& header) -> std::array<unsigned char, V2_HEADER_SIZE> {
+        std::array<unsigned char, V2_HEADER_SIZE> encoded{};
+        auto out = std::copy(HEADER_IDENTIFIER.begin(), HEADER_IDENTIFIER.end(), encoded.begin());
+        *out++ = 0xFF;
+        *out++ = 0xFF;
+        *out++ = PROTOCOL_VERSION;
+        *out++ = static_cast<uchar>(header.type);
+        write_u32(&*out, header.length);
+        write_u32(&*out + 4, header.request_id);
+        write_u32(&*out + 8, header.count);
+        return encoded;
+    }
+
+    auto decode_header(std::string_view data) -> std::optional<FrameHeader> {
+        if(data.size() < V2_HEADER_SIZE || !starts_with_marker(data.data(), HEADER_IDENTIFIER) || !is_v2_frame(data))
+            return {};
+        if(static_cast<uchar>(data[HEADER_SIZE]) != PROTOCOL_VERSION)
+            return {};
+        auto type = static_cast<uchar>(data[HEADER_SIZE + 1]);
+        if(type < static_cast<uchar>(MessageType::Request) || type > static_cast<uchar>(MessageType::Typed))
+            return {};
+        const auto* fields = data.data() + HEADER_SIZE + 2;
+        return FrameHeader{static_cast<MessageType>(type), read_u32(fields), read_u32(fields + 4), read_u32(fields + 8)};
+    }
+
+    Batch::Batch(MessageType type, std::uint32_t request_id) : buffer(V2_HEADER_SIZE, '\0'), type(type), request_id(request_id), records(0) {}
+
+    void Batch::add(std::string_view record) {
+        uchar length[RECORD_LENGTH_SIZE];
+        write_u32(length, static_cast<std::uint32_t>(record.size()));
+        buffer.append(reinterpret_cast<const char*>(length), RECORD_LENGTH_SIZE);
+        buffer.append(record);
+        ++records;
+    }
+
+    auto Batch::count() const -> std::uint32_t { return records; }
+
+    auto Batch::frame() -> std::string_view {
+        auto header = encode_header(FrameHeader{type, static_cast<std::uint32_t>(buffer.size() - V2_HEADER_SIZE), request_id, records});
+        std::copy(header.begin(), header.end(), buffer.begin());
+        return buffer;
+    }
+
+    RecordReader::RecordReader(std::string_view body) : rest(body), broken(false) {}
+
+    auto RecordReader::next() -> std::optional<std::string_view> {
+        if(broken || rest.empty())
+            return {};
+        if(rest.size() < RECORD_LENGTH_SIZE) {
+            broken = true;
+            return {};
+        }
+        auto length = read_u32(rest.data());
+        rest.remove_prefix(RECORD_LENGTH_SIZE);
+        if(length > rest.size()) {
+            broken = true;
+            return {};
+        }
+        auto record = rest.substr(0, length);
+        rest.remove_prefix(length);
+        return record;
+    }
+
+    auto RecordReader::malformed() const -> bool { return broken; }
 
 } // namespace cx::ipc
 
@@ -1,5 +1,6 @@
 #pragma once
 #include <cstring>
+#include <cstdint>
 #include <array>
 #include <bit>
 #include <string_view>
@@ -7,6 +8,10 @@
 #include <iostream>
 #include <cassert>
 #include <optional>
+#include <span>
+#include <string>
+#include <vector>
+#include <sys/uio.h>
 
 using namespace std::literals;
 
@@ -44,8 +49,8 @@ namespace cx::ipc {
         assert(a == b);
     }
 
-    /// Template overload resolution will make sure (hopefully) that the correct value is computed
-    /// These are just function declarations - they will declare for whatever endianness host computer has. Definitions are in the .cpp file
+    /// The payload length is big-endian on the wire, whatever the host is. Endian is the host's byte order, and makes no difference any more;
+    /// the definitions, in the .cpp file, are instantiated for both
     template <std::endian Endian = std::endian::native>
     auto header_value() -> unsigned long;
     template <std::endian Endian = std::endian::native>
@@ -64,10 +69,101 @@ namespace cx::ipc {
     Message from_payload(const char* payload, std::uint16_t payload_len);
     Message from_payload(std::string_view payload);
 
+    /// The part of a v1 frame that has to be written out for it; the footer is the same for every frame
+    using FrameHeaderBytes = std::array<unsigned char, HEADER_SIZE>;
+    /// Encodes the header into header & returns header, payload & footer as iovecs for writev/sendmsg. The payload is not copied, so it and
+    /// header must stay alive until the write is done. Nothing, if the payload is longer than MAX_PAYLOAD_LENGTH
+    auto encode_iovec(std::string_view payload, FrameHeaderBytes& header) -> std::optional<std::array<iovec, 3>>;
+    /// Writes the frame for payload into the front of out, touching nothing but those bytes. Returns how many that is, or nothing, if the
+    /// payload is longer than MAX_PAYLOAD_LENGTH or the frame doesn't fit in out
+    auto encode_into(std::string_view payload, std::span<std::byte> out) -> std::optional<std::size_t>;
+
     std::optional<std::string> extract_payload(const std::array<std::byte, 2048>& buf, std::size_t data_in_buffer);
     std::optional<std::string> extract_payload(const Message& msg);
     std::optional<std::vector<std::string>> extract_payloads(const std::array<std::byte, 2048>& buf, std::size_t data_in_buffer);
 
-    [[no_discard]] bool payload_ok(const char* data, std::size_t size);
-    [[no_discard]] bool payload_ok(const Message& msg);
+    [[nodiscard]] bool payload_ok(const char* data, std::size_t size);
+    [[nodiscard]] bool payload_ok(const Message& msg);
+
+    /// Delimiter scanning. Both markers are 8 bytes; candidates are positions where the first & last byte of the marker line up, which the
+    /// SSE2 and AVX2 kernels test for at 16 or 32 positions at a time, before comparing all 8 bytes of each one with a single load
+    enum class ScanKernel { Scalar, SSE2, AVX2 };
+    /// Where marker (8 bytes) first occurs in data, or std::string_view::npos, using the best kernel this CPU runs
+    auto find_marker(std::string_view data, std::string_view marker) -> std::size_t;
+    /// find_marker, with a specific kernel, for tests & benchmarks. One the CPU can't run, falls back to the one scan_kernel() picked
+    auto find_marker(std::string_view data, std::string_view marker, ScanKernel kernel) -> std::size_t;
+    /// The kernel picked for this CPU, at startup
+    auto scan_kernel() -> ScanKernel;
+    inline auto find_header(std::string_view data) -> std::size_t { return find_marker(data, HEADER_IDENTIFIER); }
+    inline auto find_footer(std::string_view data) -> std::size_t { return find_marker(data, PACKAGE_END); }
+    /// Whether data, which must hold at least 8 bytes, starts with marker. One 8-byte compare, not a byte-wise one
+    inline auto starts_with_marker(const char* data, std::string_view marker) -> bool {
+        std::uint64_t value, expected;
+        std::memcpy(&value, data, sizeof(value));
+        std::memcpy(&expected, marker.data(), sizeof(expected));
+        return value == expected;
+    }
+
+    /// Protocol v2. Frames start with the same identifier as v1, followed by V2_MARKER where v1 has its payload length. No v1 payload is
+    /// that long, so the first HEADER_SIZE bytes tell the two versions apart. Every field is big-endian, whatever the host is:
+    ///     "cxwm-ipc" | u16 0xFFFF | u8 version | u8 type | u32 body length | u32 request id | u32 record count | body
+    /// The body is record count records, each one a u32 length followed by that many bytes. The length in the header is all the reader needs
+    /// to find the end of a frame, so there's no footer
+    constexpr std::uint16_t V2_MARKER = 0xFFFF;
+    constexpr std::uint8_t PROTOCOL_VERSION = 2;
+    constexpr auto V2_HEADER_SIZE = HEADER_SIZE + 1 + 1 + 4 + 4 + 4;
+    constexpr auto RECORD_LENGTH_SIZE = 4;
+    /// Largest body a reader accepts. Plenty for restoring a layout of hundreds of commands in one frame
+    constexpr std::uint32_t MAX_FRAME_BODY = 1 << 20;
+
+    enum class MessageType : std::uint8_t {
+        Request = 1,
+        /// Answers a request, carrying its request id & one record per record in the request
+        Reply = 2,
+        /// Sent to subscribers, request id 0
+        Event = 3,
+        /// A request whose records are schema messages (see schema.h) instead of text commands. Answered with a Reply, like any request
+        Typed = 4
+    };
+
+    struct FrameHeader {
+        MessageType type;
+        std::uint32_t length;
+        std::uint32_t request_id;
+        std::uint32_t count;
+    };
+
+    /// Whether data, which must hold at least HEADER_SIZE bytes, starts a v2 frame
+    auto is_v2_frame(std::string_view data) -> bool;
+    auto encode_header(const FrameHeader& header) -> std::array<unsigned char, V2_HEADER_SIZE>;
+    /// Nothing, if data is shorter than a header, or the header is not a v2 one of a known type
+    auto decode_header(std::string_view data) -> std::optional<FrameHeader>;
+
+    /// Builds a v2 frame, one record at a time
+    class Batch {
+    public:
+        Batch(MessageType type, std::uint32_t request_id);
+        void add(std::string_view record);
+        [[nodiscard]] auto count() const -> std::uint32_t;
+        /// The frame, with everything added so far. Adding more afterwards is fine; the header is brought up to date on every call
+        auto frame() -> std::string_view;
+    private:
+        std::string buffer;
+        MessageType type;
+        std::uint32_t request_id;
+        std::uint32_t records;
+    };
+
+    /// Walks the records in the body of a v2 frame
+    class RecordReader {
+    public:
+        explicit RecordReader(std::string_view body);
+        /// Nothing, once the records run out or the body turns out to be malformed
+        auto next() -> std::optional<std::string_view>;
+        /// A record claimed to be longer than what's left of the body
+        [[nodiscard]] auto malformed() const -> bool;
+    private:
+        std::string_view rest;
+        bool broken;
+    };
 }
\ No newline at end of file
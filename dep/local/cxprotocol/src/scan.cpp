@@ -0,0 +1,115 @@
+#include "library.h"
+// Delimiter scanning kernels
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CX_SCAN_X86 1
+#endif
+
+namespace cx::ipc
+{
+    namespace {
+        constexpr auto MARKER_SIZE = 8;
+
+        auto load_u64(const char* data) -> std::uint64_t {
+            std::uint64_t value;
+            std::memcpy(&value, data, sizeof(value));
+            return value;
+        }
+
+        /// One position at a time, checking the first & last byte before the whole marker
+        auto find_scalar(std::string_view data, std::size_t from, std::string_view marker) -> std::size_t {
+            if(data.size() < MARKER_SIZE)
+                return std::string_view::npos;
+            const auto* p = data.data();
+            const auto bits = load_u64(marker.data());
+            const auto first = marker.front();
+            const auto last = marker.back();
+            for(auto i = from; i + MARKER_SIZE <= data.size(); ++i) {
+                if(p[i] == first && p[i + MARKER_SIZE - 1] == last && load_u64(p + i) == bits)
+                    return i;
+            }
+            return std::string_view::npos;
+        }
+
+#ifdef CX_SCAN_X86
+        /// Tests the candidates in mask, lowest position first. Returns the offset of the first real match, or -1
+        inline auto verify(unsigned mask, const char* p, std::uint64_t bits) -> int {
+            while(mask != 0) {
+                auto bit = __builtin_ctz(mask);
+                if(load_u64(p + bit) == bits)
+                    return bit;
+                mask &= mask - 1;
+            }
+            return -1;
+        }
+
+        auto find_sse2(std::string_view data, std::string_view marker) -> std::size_t {
+            const auto* p = data.data();
+            const auto n = data.size();
+            const auto bits = load_u64(marker.data());
+            const auto first = _mm_set1_epi8(marker.front());
+            const auto last = _mm_set1_epi8(marker.back());
+            std::size_t i = 0;
+            for(; i + 16 + MARKER_SIZE - 1 <= n; i += 16) {
+                auto block_first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+                auto block_last = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i + MARKER_SIZE - 1));
+                auto mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(block_first, first),
+                                                                                  _mm_cmpeq_epi8(block_last, last))));
+                if(auto hit = verify(mask, p + i, bits); hit >= 0)
+                    return i + hit;
+            }
+            return find_scalar(data, i, marker);
+        }
+
+        __attribute__((target("avx2")))
+        auto find_avx2(std::string_view data, std::string_view marker) -> std::size_t {
+            const auto* p = data.data();
+            const auto n = data.size();
+            const auto bits = load_u64(marker.data());
+            const auto first = _mm256_set1_epi8(marker.front());
+            const auto last = _mm256_set1_epi8(marker.back());
+            std::size_t i = 0;
+            for(; i + 32 + MARKER_SIZE - 1 <= n; i += 32) {
+                auto block_first = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+                auto block_last = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i + MARKER_SIZE - 1));
+                auto mask = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(block_first, first),
+                                                                                       _mm256_cmpeq_epi8(block_last, last))));
+                if(auto hit = verify(mask, p + i, bits); hit >= 0)
+                    return i + hit;
+            }
+            return find_scalar(data, i, marker);
+        }
+#endif
+
+        auto pick_kernel() -> ScanKernel {
+#ifdef CX_SCAN_X86
+            __builtin_cpu_init();
+            if(__builtin_cpu_supports("avx2"))
+                return ScanKernel::AVX2;
+            if(__builtin_cpu_supports("sse2"))
+                return ScanKernel::SSE2;
+#endif
+            return ScanKernel::Scalar;
+        }
+
+        const ScanKernel best_kernel = pick_kernel();
+    }
+
+    auto scan_kernel() -> ScanKernel { return best_kernel; }
+
+    auto find_marker(std::string_view data, std::string_view marker, ScanKernel kernel) -> std::size_t {
+        assert(marker.size() == MARKER_SIZE);
+        if(kernel > best_kernel)
+            kernel = best_kernel;
+        switch(kernel) {
+#ifdef CX_SCAN_X86
+            case ScanKernel::AVX2: return find_avx2(data, marker);
+            case ScanKernel::SSE2: return find_sse2(data, marker);
+#endif
+            default: return find_scalar(data, 0, marker);
+        }
+    }
+
+    auto find_marker(std::string_view data, std::string_view marker) -> std::size_t { return find_marker(data, marker, best_kernel); }
+} // namespace cx::ipc
@@ -0,0 +1,161 @@
+#pragma once
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <type_traits>
+
+namespace cx::ipc::schema {
+
+    /// Big-endian, whatever the host is. Shifts, not memcpy, so they work in constant expressions too
+    template <typename Int>
+    constexpr void store_be(std::byte* out, Int value) {
+        using U = std::make_unsigned_t<Int>;
+        auto bits = static_cast<U>(value);
+        for(auto i = sizeof(U); i > 0; --i) {
+            out[i - 1] = static_cast<std::byte>(bits & 0xFF);
+            bits = static_cast<U>(bits >> 8);
+        }
+    }
+
+    template <typename Int>
+    constexpr auto load_be(const std::byte* in) -> Int {
+        using U = std::make_unsigned_t<Int>;
+        U bits = 0;
+        for(auto i = 0u; i < sizeof(U); ++i)
+            bits = static_cast<U>((bits << 8) | static_cast<U>(in[i]));
+        return static_cast<Int>(bits);
+    }
+
+    template <typename T>
+    concept FieldType = std::is_integral_v<T> || std::is_enum_v<T>;
+
+    template <typename T>
+    struct member_traits;
+    template <typename Class, typename Type>
+    struct member_traits<Type Class::*> {
+        using message = Class;
+        using type = Type;
+    };
+
+    /// One field of a message, at a fixed offset in its encoding
+    template <auto Member>
+    struct Field {
+        using type = typename member_traits<decltype(Member)>::type;
+        static_assert(FieldType<type>, "Message fields are integers or enums");
+        static constexpr std::size_t size = sizeof(type);
+
+        template <typename Message>
+        static constexpr void store(const Message& message, std::byte* out) {
+            if constexpr(std::is_enum_v<type>)
+                store_be(out, static_cast<std::underlying_type_t<type>>(message.*Member));
+            else if constexpr(std::is_same_v<type, bool>)
+                store_be(out, static_cast<std::uint8_t>(message.*Member));
+            else
+                store_be(out, message.*Member);
+        }
+
+        template <typename Message>
+        static constexpr void load(Message& message, const std::byte* in) {
+            if constexpr(std::is_enum_v<type>)
+                message.*Member = static_cast<type>(load_be<std::underlying_type_t<type>>(in));
+            else if constexpr(std::is_same_v<type, bool>)
+                message.*Member = load_be<std::uint8_t>(in) != 0;
+            else
+                message.*Member = load_be<type>(in);
+        }
+    };
+
+    /// The fields of a message, in the order they go on the wire
+    template <auto... Members>
+    struct Fields {
+        static constexpr std::size_t size = (Field<Members>::size + ... + 0);
+
+        template <typename Message>
+        static constexpr void store(const Message& message, std::byte* out) {
+            ((Field<Members>::store(message, out), out += Field<Members>::size), ...);
+        }
+
+        template <typename Message>
+        static constexpr void load(Message& message, const std::byte* in) {
+            ((Field<Members>::load(message, in), in += Field<Members>::size), ...);
+        }
+    };
+
+    using MessageId = std::uint16_t;
+    constexpr std::size_t ID_SIZE = sizeof(MessageId);
+
+    /// A message describes itself once: `static constexpr MessageId id` & `using fields = Fields<&Message::a, &Message::b, ...>`. Encoded,
+    /// it's the id, followed by every field, big-endian, back to back
+    template <typename T>
+    concept Message = std::is_default_constructible_v<T> && requires {
+        { T::id } -> std::convertible_to<MessageId>;
+        T::fields::size;
+    };
+
+    template <Message T>
+    constexpr std::size_t encoded_size = ID_SIZE + T::fields::size;
+
+    template <Message T>
+    constexpr auto encode(const T& message) -> std::array<std::byte, encoded_size<T>> {
+        std::array<std::byte, encoded_size<T>> encoded{};
+        store_be(encoded.data(), T::id);
+        T::fields::store(message, encoded.data() + ID_SIZE);
+        return encoded;
+    }
+
+    /// Nothing, if data is not exactly one T
+    template <Message T>
+    constexpr auto decode(std::span<const std::byte> data) -> std::optional<T> {
+        if(data.size() != encoded_size<T> || load_be<MessageId>(data.data()) != T::id)
+            return {};
+        T message{};
+        T::fields::load(message, data.data() + ID_SIZE);
+        return message;
+    }
+
+    /// Decodes data as whichever of Ts it is & calls on_message with it. Returns false if it's none of them
+    template <Message... Ts, typename Fn>
+    constexpr auto visit(std::span<const std::byte> data, Fn&& on_message) -> bool {
+        if(data.size() < ID_SIZE)
+            return false;
+        const auto id = load_be<MessageId>(data.data());
+        auto try_one = [&]<typename T>() {
+            if(id != T::id)
+                return false;
+            auto message = decode<T>(data);
+            if(message)
+                on_message(*message);
+            return message.has_value();
+        };
+        return (try_one.template operator()<Ts>() || ...);
+    }
+
+    // The messages the window manager understands. Ids are for life; add new ones at the end
+
+    enum class Direction : std::uint8_t { Left, Right, Up, Down };
+
+    /// Moves the focused window
+    struct WindowMove {
+        static constexpr MessageId id = 1;
+        Direction direction;
+        using fields = Fields<&WindowMove::direction>;
+    };
+
+    /// Grows or shrinks the focused window by step pixels
+    struct WindowResize {
+        static constexpr MessageId id = 2;
+        Direction direction;
+        bool grow;
+        std::uint16_t step;
+        using fields = Fields<&WindowResize::direction, &WindowResize::grow, &WindowResize::step>;
+    };
+
+    struct WorkspaceFocus {
+        static constexpr MessageId id = 3;
+        std::uint32_t index;
+        using fields = Fields<&WorkspaceFocus::index>;
+    };
+}
@@ -0,0 +1,193 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// The layout the window manager publishes into shared memory, for bars, pagers & scripts to read at whatever rate they like, without
+/// asking. The file descriptor comes with the reply to a "snapshot" message (SCM_RIGHTS); map it read-only, and read() it as often as you
+/// want. No system calls, and nothing the window manager notices.
+///
+/// Unlike the wire protocol, everything here is in host byte order; the mapping never leaves the machine. The mapping is a Header,
+/// followed by the body: a Layout, Layout::workspace_count Workspaces, Layout::window_count Windows & the strings they point into.
+namespace cx::ipc::snapshot {
+
+    constexpr std::uint32_t MAGIC = 0x73777863; // "cxws"
+    constexpr std::uint32_t VERSION = 1;
+
+    struct Header {
+        std::uint32_t magic;
+        std::uint32_t version;
+        /// A seqlock. Odd while the window manager is writing; read() copies the body out & checks that it's still the same, even number
+        /// afterwards. Halved, it's the generation: how many layouts have been published
+        std::uint64_t sequence;
+        /// Bytes of body
+        std::uint32_t size;
+        /// Bytes there's room for, after the header
+        std::uint32_t capacity;
+    };
+
+    struct Layout {
+        std::uint32_t workspace_count;
+        std::uint32_t window_count;
+        std::uint32_t focused_workspace;
+        /// Client id of the focused window, 0 if there is none
+        std::uint32_t focused_window;
+    };
+
+    struct Workspace {
+        std::uint32_t id;
+        /// Its windows follow those of the workspaces before it
+        std::uint32_t window_count;
+        /// Into the strings, at the end of the body
+        std::uint32_t name_offset;
+        std::uint32_t name_length;
+    };
+
+    struct Window {
+        std::uint32_t client;
+        std::uint32_t frame;
+        std::uint32_t workspace;
+        std::int32_t x, y, width, height;
+        std::uint32_t title_offset;
+        std::uint32_t title_length;
+    };
+
+    /// Puts a body together. Workspaces go in order; each window belongs to the workspace added last
+    class Builder {
+    public:
+        void clear() {
+            layout = Layout{};
+            workspaces.clear();
+            windows.clear();
+            strings.clear();
+        }
+        void add_workspace(std::uint32_t id, std::string_view name) {
+            workspaces.push_back(Workspace{id, 0, add_string(name), static_cast<std::uint32_t>(name.size())});
+            ++layout.workspace_count;
+        }
+        /// window's title_offset & title_length are filled in here
+        void add_window(Window window, std::string_view title) {
+            window.title_offset = add_string(title);
+            window.title_length = static_cast<std::uint32_t>(title.size());
+            windows.push_back(window);
+            ++layout.window_count;
+            if(!workspaces.empty())
+                ++workspaces.back().window_count;
+        }
+        void focus(std::uint32_t workspace, std::uint32_t window) {
+            layout.focused_workspace = workspace;
+            layout.focused_window = window;
+        }
+        /// Writes the body into out, which is resized to fit it. Reusing out (and the builder) allocates nothing, once they've grown
+        void finish(std::vector<std::byte>& out) const {
+            const auto workspace_bytes = workspaces.size() * sizeof(Workspace);
+            const auto window_bytes = windows.size() * sizeof(Window);
+            out.resize(sizeof(Layout) + workspace_bytes + window_bytes + strings.size());
+            auto* at = out.data();
+            std::memcpy(at, &layout, sizeof(Layout));
+            std::memcpy(at += sizeof(Layout), workspaces.data(), workspace_bytes);
+            std::memcpy(at += workspace_bytes, windows.data(), window_bytes);
+            std::memcpy(at += window_bytes, strings.data(), strings.size());
+        }
+
+    private:
+        auto add_string(std::string_view text) -> std::uint32_t {
+            const auto offset = static_cast<std::uint32_t>(strings.size());
+            strings.append(text);
+            return offset;
+        }
+        Layout layout{};
+        std::vector<Workspace> workspaces{};
+        std::vector<Window> windows{};
+        std::string strings{};
+    };
+
+    /// Makes sense of a body read() copied out
+    class View {
+    public:
+        /// Nothing, if body doesn't hold what its Layout says it does
+        static auto parse(std::span<const std::byte> body) -> std::optional<View> {
+            if(body.size() < sizeof(Layout))
+                return {};
+            View view{};
+            std::memcpy(&view.layout, body.data(), sizeof(Layout));
+            const auto records = sizeof(Layout) + std::size_t{view.layout.workspace_count} * sizeof(Workspace) +
+                                 std::size_t{view.layout.window_count} * sizeof(Window);
+            if(records > body.size())
+                return {};
+            view.body = body;
+            view.strings = std::string_view{reinterpret_cast<const char*>(body.data()) + records, body.size() - records};
+            return view;
+        }
+        [[nodiscard]] auto focused_workspace() const -> std::uint32_t { return layout.focused_workspace; }
+        [[nodiscard]] auto focused_window() const -> std::uint32_t { return layout.focused_window; }
+        [[nodiscard]] auto workspaces() const -> std::span<const Workspace> {
+            return {reinterpret_cast<const Workspace*>(body.data() + sizeof(Layout)), layout.workspace_count};
+        }
+        [[nodiscard]] auto windows() const -> std::span<const Window> {
+            return {reinterpret_cast<const Window*>(body.data() + sizeof(Layout) + layout.workspace_count * sizeof(Workspace)),
+                    layout.window_count};
+        }
+        /// Empty, for a string that isn't there
+        [[nodiscard]] auto name(const Workspace& workspace) const -> std::string_view {
+            return string(workspace.name_offset, workspace.name_length);
+        }
+        [[nodiscard]] auto title(const Window& window) const -> std::string_view { return string(window.title_offset, window.title_length); }
+
+    private:
+        [[nodiscard]] auto string(std::uint32_t offset, std::uint32_t length) const -> std::string_view {
+            if(offset > strings.size() || length > strings.size() - offset)
+                return {};
+            return strings.substr(offset, length);
+        }
+        Layout layout{};
+        std::span<const std::byte> body{};
+        std::string_view strings{};
+    };
+
+    /// How many layouts have been published into mapping. Cheap enough to poll; read() only when it's changed
+    inline auto generation(const std::byte* mapping) -> std::uint64_t {
+        return __atomic_load_n(&reinterpret_cast<const Header*>(mapping)->sequence, __ATOMIC_ACQUIRE) / 2;
+    }
+
+    /// Copies the latest body out of mapping (mapped_size bytes, header included) into out. Waits out a write in progress, if it catches
+    /// one. Returns the generation it copied, or nothing, if mapping doesn't hold a snapshot this reader understands
+    inline auto read(const std::byte* mapping, std::size_t mapped_size, std::vector<std::byte>& out) -> std::optional<std::uint64_t> {
+        const auto* header = reinterpret_cast<const Header*>(mapping);
+        if(mapped_size < sizeof(Header) || header->magic != MAGIC || header->version != VERSION)
+            return {};
+        for(;;) {
+            const auto before = __atomic_load_n(&header->sequence, __ATOMIC_ACQUIRE);
+            if(before & 1)
+                continue;
+            // Whatever size says, mid-write it may be garbage; only trust it as far as the mapping goes
+            const auto size = std::min<std::size_t>(__atomic_load_n(&header->size, __ATOMIC_RELAXED), mapped_size - sizeof(Header));
+            out.resize(size);
+            std::memcpy(out.data(), mapping + sizeof(Header), size);
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+            if(__atomic_load_n(&header->sequence, __ATOMIC_RELAXED) == before)
+                return before / 2;
+        }
+    }
+
+    /// The writer's side of read(). Nothing but the window manager calls this. Returns false, with nothing written, if body doesn't fit
+    inline auto write(std::byte* mapping, std::span<const std::byte> body) -> bool {
+        auto* header = reinterpret_cast<Header*>(mapping);
+        if(body.size() > header->capacity)
+            return false;
+        const auto sequence = __atomic_load_n(&header->sequence, __ATOMIC_RELAXED);
+        __atomic_store_n(&header->sequence, sequence + 1, __ATOMIC_RELAXED);
+        // Readers that see any of the body we're about to write, see the odd sequence too
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+        __atomic_store_n(&header->size, static_cast<std::uint32_t>(body.size()), __ATOMIC_RELAXED);
+        std::memcpy(mapping + sizeof(Header), body.data(), body.size());
+        __atomic_store_n(&header->sequence, sequence + 2, __ATOMIC_RELEASE);
+        return true;
+    }
+}
@@ -0,0 +1,76 @@
+/* Encoding a v1 frame three ways: from_payload (a 2048-byte Message, returned by value), encode_into (the frame, written into the caller's
+ * buffer) & encode_iovec (just the header; payload & footer go out straight from where they are). Each one is timed on its own, and then
+ * together with handing the frame to writev on /dev/null, which is where an encoded frame goes next.
+ *      ./encode_bench [messages = 5000000] */
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <string>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <library.h>
+
+using namespace std::chrono;
+
+/// Keeps the compiler from throwing away work whose result nothing looks at
+template<typename T>
+inline void keep(const T& value) { asm volatile("" : : "r,m"(value) : "memory"); }
+
+template<typename Fn>
+auto messages_per_second(long messages, Fn&& encode) -> double {
+    auto start = steady_clock::now();
+    for(auto i = 0L; i < messages; ++i)
+        encode();
+    auto elapsed = duration_cast<nanoseconds>(steady_clock::now() - start).count();
+    return static_cast<double>(messages) * 1e9 / static_cast<double>(elapsed);
+}
+
+int main(int argc, char* argv[]) {
+    const long messages = argc > 1 ? std::atol(argv[1]) : 5000000;
+    auto dev_null = open("/dev/null", O_WRONLY);
+
+    std::printf("%-8s %-14s %16s %16s %18s\n", "payload", "encoder", "bytes touched", "encode msg/s", "encode+writev msg/s");
+    for(auto payload_size : {16, 128, 1024}) {
+        const std::string payload(payload_size, 'x');
+        const auto frame_size = cx::ipc::FIXED_FIELDS_SIZE + payload.size();
+
+        // The Message is zeroed on construction, zeroed again by fill, and copied once more on its way out
+        auto from_payload = [&] {
+            auto message = cx::ipc::from_payload(payload);
+            keep(message);
+            return message;
+        };
+        auto from_payload_write = [&] {
+            auto message = from_payload();
+            keep(write(dev_null, message.buffer.data(), message.message_size));
+        };
+        std::printf("%-8d %-14s %16zu %16.0f %18.0f\n", payload_size, "from_payload", 3 * cx::ipc::MAX_MESSAGE_SIZE + frame_size,
+                    messages_per_second(messages, from_payload), messages_per_second(messages, from_payload_write));
+
+        std::array<std::byte, cx::ipc::MAX_MESSAGE_SIZE> buffer{};
+        auto encode_into = [&] {
+            auto size = cx::ipc::encode_into(payload, buffer);
+            keep(buffer);
+            return *size;
+        };
+        auto encode_into_write = [&] { keep(write(dev_null, buffer.data(), encode_into())); };
+        std::printf("%-8d %-14s %16zu %16.0f %18.0f\n", payload_size, "encode_into", frame_size, messages_per_second(messages, encode_into),
+                    messages_per_second(messages, encode_into_write));
+
+        cx::ipc::FrameHeaderBytes header{};
+        auto encode_iovec = [&] {
+            auto frame = cx::ipc::encode_iovec(payload, header);
+            keep(header);
+            return *frame;
+        };
+        auto encode_iovec_write = [&] {
+            auto frame = encode_iovec();
+            keep(writev(dev_null, frame.data(), static_cast<int>(frame.size())));
+        };
+        std::printf("%-8d %-14s %16zu %16.0f %18.0f\n", payload_size, "encode_iovec", header.size(), messages_per_second(messages, encode_iovec),
+                    messages_per_second(messages, encode_iovec_write));
+    }
+    close(dev_null);
+    return 0;
+}
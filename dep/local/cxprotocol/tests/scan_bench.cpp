@@ -0,0 +1,88 @@
+/* Throughput of finding every "cxwm-ipc" header & "cxwm-end" footer in a multi-megabyte buffer of v1 frames, as a burst of IPC traffic looks
+ * when it is read in one go. Payloads are of mixed length, made up of the same characters the markers are, so that most of the positions the
+ * kernels look at are candidates that turn out not to be markers. Every kernel is checked against the others for the number of markers.
+ *      ./scan_bench [megabytes = 16] [rounds = 10] */
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <library.h>
+
+using namespace std::chrono;
+
+auto make_burst(std::size_t bytes) -> std::string {
+    std::mt19937 rng{1234};
+    std::uniform_int_distribution<int> length{4, 400};
+    constexpr std::string_view alphabet = "cxwm-ipcend 0123456789abcdefghijklmnopqrstuvwxyz";
+    std::uniform_int_distribution<std::size_t> letter{0, alphabet.size() - 1};
+    std::string burst;
+    std::string payload;
+    while(burst.size() < bytes) {
+        payload.clear();
+        for(auto i = length(rng); i > 0; --i)
+            payload.push_back(alphabet[letter(rng)]);
+        auto offset = burst.size();
+        burst.resize(offset + cx::ipc::FIXED_FIELDS_SIZE + payload.size());
+        cx::ipc::encode_into(payload, std::as_writable_bytes(std::span{burst}.subspan(offset)));
+    }
+    return burst;
+}
+
+/// The way the footer used to be looked for: an 8-byte compare at every offset
+auto count_substr(std::string_view data, std::string_view marker) -> std::size_t {
+    std::size_t count = 0;
+    for(std::size_t i = 0; i + marker.size() <= data.size(); ++i)
+        count += data.substr(i, marker.size()) == marker;
+    return count;
+}
+
+auto count_find(std::string_view data, std::string_view marker) -> std::size_t {
+    std::size_t count = 0;
+    for(auto at = data.find(marker); at != std::string_view::npos; at = data.find(marker, at + 1))
+        ++count;
+    return count;
+}
+
+auto count_kernel(std::string_view data, std::string_view marker, cx::ipc::ScanKernel kernel) -> std::size_t {
+    std::size_t count = 0;
+    for(auto at = cx::ipc::find_marker(data, marker, kernel); at != std::string_view::npos; ++count) {
+        data.remove_prefix(at + 1);
+        at = cx::ipc::find_marker(data, marker, kernel);
+    }
+    return count;
+}
+
+template<typename Fn>
+auto run(const char* name, std::string_view burst, int rounds, Fn&& count) {
+    std::size_t headers = 0, footers = 0;
+    auto start = steady_clock::now();
+    for(auto i = 0; i < rounds; ++i) {
+        headers = count(burst, cx::ipc::HEADER_IDENTIFIER);
+        footers = count(burst, cx::ipc::PACKAGE_END);
+    }
+    auto seconds = duration_cast<duration<double>>(steady_clock::now() - start).count();
+    auto scanned = 2.0 * static_cast<double>(burst.size()) * rounds;
+    std::printf("%-16s %10.0f MB/s %10zu headers %10zu footers\n", name, scanned / seconds / 1e6, headers, footers);
+    return headers + footers;
+}
+
+int main(int argc, char* argv[]) {
+    const auto megabytes = argc > 1 ? std::atoi(argv[1]) : 16;
+    const auto rounds = argc > 2 ? std::atoi(argv[2]) : 10;
+    const auto burst = make_burst(static_cast<std::size_t>(megabytes) << 20);
+    const char* kernel_names[]{"scalar", "sse2", "avx2"};
+    std::printf("%zu bytes, %d rounds. This CPU runs the %s kernel\n", burst.size(), rounds, kernel_names[static_cast<int>(cx::ipc::scan_kernel())]);
+
+    auto expected = run("substr per byte", burst, rounds, count_substr);
+    auto ok = run("string_view find", burst, rounds, count_find) == expected;
+    for(auto kernel : {cx::ipc::ScanKernel::Scalar, cx::ipc::ScanKernel::SSE2, cx::ipc::ScanKernel::AVX2}) {
+        if(kernel > cx::ipc::scan_kernel())
+            continue;
+        ok &= run(kernel_names[static_cast<int>(kernel)], burst, rounds,
+                  [kernel](std::string_view data, std::string_view marker) { return count_kernel(data, marker, kernel); }) == expected;
+    }
+    if(!ok)
+        std::printf("Kernels disagree on the number of markers!\n");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,57 @@
+/* Encoding & decoding schema messages. The round trips below are checked by the compiler; the loop times how long decoding a record into
+ * its struct takes at run time, both when the type is known up front & when it's found out from the id, the way the window manager does.
+ *      ./schema_bench [messages = 20000000] */
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <schema.h>
+
+using namespace std::chrono;
+using namespace cx::ipc::schema;
+
+static_assert(encoded_size<WindowMove> == 3);
+static_assert(encoded_size<WindowResize> == 6);
+static_assert(decode<WindowMove>(encode(WindowMove{Direction::Up}))->direction == Direction::Up);
+static_assert(decode<WindowResize>(encode(WindowResize{Direction::Left, true, 300}))->step == 300);
+static_assert(encode(WorkspaceFocus{0x01020304})[2] == std::byte{0x01}, "Fields are big-endian");
+static_assert(!decode<WindowMove>(encode(WorkspaceFocus{1})), "Decoding checks the id");
+
+template<typename T>
+inline void keep(const T& value) { asm volatile("" : : "r,m"(value) : "memory"); }
+
+template<typename Fn>
+auto nanoseconds_each(long messages, Fn&& fn) -> double {
+    auto start = steady_clock::now();
+    for(auto i = 0L; i < messages; ++i)
+        fn(i);
+    return static_cast<double>(duration_cast<nanoseconds>(steady_clock::now() - start).count()) / static_cast<double>(messages);
+}
+
+int main(int argc, char* argv[]) {
+    const long messages = argc > 1 ? std::atol(argv[1]) : 20000000;
+    // A mix of records, as a batch of typed commands would carry them
+    std::vector<std::vector<std::byte>> records;
+    for(auto i = 0; i < 64; ++i) {
+        auto add = [&](const auto& encoded) { records.emplace_back(encoded.begin(), encoded.end()); };
+        switch(i % 3) {
+            case 0: add(encode(WindowMove{static_cast<Direction>(i % 4)})); break;
+            case 1: add(encode(WindowResize{static_cast<Direction>(i % 4), i % 2 == 0, static_cast<std::uint16_t>(i)})); break;
+            default: add(encode(WorkspaceFocus{static_cast<std::uint32_t>(i)})); break;
+        }
+    }
+    const auto move = encode(WindowMove{Direction::Right});
+
+    std::printf("encode WindowMove        %6.2f ns\n", nanoseconds_each(messages, [](long i) {
+        keep(encode(WindowMove{static_cast<Direction>(i & 3)}));
+    }));
+    std::printf("decode WindowMove        %6.2f ns\n", nanoseconds_each(messages, [&](long) {
+        keep(decode<WindowMove>(move));
+    }));
+    std::size_t visited = 0;
+    std::printf("visit mixed records      %6.2f ns\n", nanoseconds_each(messages, [&](long i) {
+        const auto& record = records[static_cast<std::size_t>(i) & 63];
+        visit<WindowMove, WindowResize, WorkspaceFocus>(record, [&](const auto& message) { keep(message); ++visited; });
+    }));
+    return visited == static_cast<std::size_t>(messages) ? 0 : 1;
+}
@@ -0,0 +1,64 @@
+#include "histogram.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace cx
+{
+    static_assert(Histogram::bucket_of(~0ULL) == Histogram::BUCKETS - 1 && Histogram::bucket_top(Histogram::BUCKETS - 1) == ~0ULL);
+    static_assert(Histogram::bucket_of(Histogram::bucket_top(100)) == 100 && Histogram::bucket_of(Histogram::bucket_top(100) + 1) == 101);
+
+    void Histogram::record(std::uint64_t value) noexcept
+    {
+        buckets[bucket_of(value)].fetch_add(1, std::memory_order_relaxed);
+        auto seen = largest.load(std::memory_order_relaxed);
+        while(value > seen && !largest.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {
+        }
+    }
+
+    auto Histogram::count() const noexcept -> std::uint64_t
+    {
+        std::uint64_t total = 0;
+        for(const auto& bucket : buckets)
+            total += bucket.load(std::memory_order_relaxed);
+        return total;
+    }
+
+    auto Histogram::max() const noexcept -> std::uint64_t { return largest.load(std::memory_order_relaxed); }
+
+    auto Histogram::mean() const noexcept -> double
+    {
+        double sum = 0.0;
+        std::uint64_t n = 0;
+        for(std::size_t bucket = 0; bucket < BUCKETS; ++bucket) {
+            const auto in_bucket = buckets[bucket].load(std::memory_order_relaxed);
+            const auto bottom = bucket == 0 ? 0 : bucket_top(bucket - 1) + 1;
+            sum += static_cast<double>(in_bucket) * (static_cast<double>(bottom) + static_cast<double>(bucket_top(bucket))) / 2.0;
+            n += in_bucket;
+        }
+        return n == 0 ? 0.0 : sum / static_cast<double>(n);
+    }
+
+    auto Histogram::percentile(double percent) const noexcept -> std::uint64_t
+    {
+        const auto n = count();
+        if(n == 0)
+            return 0;
+        const auto rank = std::max<std::uint64_t>(static_cast<std::uint64_t>(std::ceil(percent / 100.0 * static_cast<double>(n))), 1);
+        std::uint64_t seen = 0;
+        for(std::size_t bucket = 0; bucket < BUCKETS; ++bucket) {
+            seen += buckets[bucket].load(std::memory_order_relaxed);
+            // Nothing recorded is above the largest value, even if its bucket goes further
+            if(seen >= rank)
+                return std::min(bucket_top(bucket), max());
+        }
+        return max();
+    }
+
+    void Histogram::reset() noexcept
+    {
+        for(auto& bucket : buckets)
+            bucket.store(0, std::memory_order_relaxed);
+        largest.store(0, std::memory_order_relaxed);
+    }
+} // namespace cx
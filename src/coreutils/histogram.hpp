@@ -0,0 +1,58 @@
+#pragma once
+// System headers
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+
+// Library/Application headers
+#include <coreutils/core.hpp>
+
+namespace cx
+{
+    /// Counts values (i.e. nanoseconds) in log-linear buckets: every power of two is split in SUB_BUCKETS equal parts, so whatever a
+    /// percentile says is at most 1/SUB_BUCKETS above the value it stands for, whether that's 40ns or 4s. Recording is one relaxed atomic
+    /// add (& a compare, for the max), without locks or allocation, from any thread; reading while others record sees each bucket as it is at
+    /// that moment. Count & mean are worked out from the buckets when asked for, so that recording doesn't have to keep them
+    class Histogram
+    {
+      public:
+        static constexpr unsigned SUB_BITS = 4;
+        static constexpr std::uint64_t SUB_BUCKETS = 1ULL << SUB_BITS;
+        static constexpr std::size_t BUCKETS = (64 - SUB_BITS + 1) * SUB_BUCKETS;
+
+        Histogram() noexcept = default;
+        Histogram(const Histogram&) = delete;
+        Histogram& operator=(const Histogram&) = delete;
+
+        void record(std::uint64_t value) noexcept;
+        [[nodiscard]] auto count() const noexcept -> std::uint64_t;
+        [[nodiscard]] auto max() const noexcept -> std::uint64_t;
+        /// Of the middle of each value's bucket; as close as the percentiles are
+        [[nodiscard]] auto mean() const noexcept -> double;
+        /// The value that percent (0 - 100) of what's been recorded is at or below; the top of the bucket it falls in. 0 if there's nothing
+        [[nodiscard]] auto percentile(double percent) const noexcept -> std::uint64_t;
+        void reset() noexcept;
+
+        static constexpr auto bucket_of(std::uint64_t value) -> std::size_t
+        {
+            if(value < SUB_BUCKETS)
+                return static_cast<std::size_t>(value);
+            const auto shift = static_cast<unsigned>(std::bit_width(value)) - 1 - SUB_BITS;
+            return (shift + 1) * SUB_BUCKETS + static_cast<std::size_t>((value >> shift) - SUB_BUCKETS);
+        }
+        /// The largest value that goes in bucket
+        static constexpr auto bucket_top(std::size_t bucket) -> std::uint64_t
+        {
+            if(bucket < SUB_BUCKETS)
+                return bucket;
+            const auto shift = bucket / SUB_BUCKETS - 1;
+            const auto bottom = (SUB_BUCKETS + bucket % SUB_BUCKETS) << shift;
+            return bottom + ((1ULL << shift) - 1);
+        }
+
+      private:
+        std::array<std::atomic<std::uint64_t>, BUCKETS> buckets{};
+        std::atomic<std::uint64_t> largest{0};
+    };
+} // namespace cx
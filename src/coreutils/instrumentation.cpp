@@ -0,0 +1,95 @@
+#include "instrumentation.hpp"
+
+#include <chrono>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace cx::instrumentation
+{
+    namespace
+    {
+        struct Probe {
+            std::string_view category;
+            std::string_view name;
+            Histogram histogram{};
+        };
+
+        struct Registry {
+            std::mutex lock{};
+            /// Never moves what's in it, so the histograms handed out stay where they are
+            std::deque<Probe> probes{};
+            std::map<std::pair<std::string_view, std::string_view>, Histogram*> index{};
+            /// Until calibrate() has been, nothing
+            double ns_per_tick = 0.0;
+        };
+
+        auto registry() -> Registry&
+        {
+            static Registry instance{};
+            return instance;
+        }
+
+        auto measure_ns_per_tick() -> double
+        {
+#if defined(__x86_64__) || defined(__i386__)
+            // Over less than this, the two clocks being read a few ns apart is a measurable error
+            constexpr auto baseline = std::chrono::milliseconds{10};
+            const auto start_ticks = ticks();
+            const auto start = std::chrono::steady_clock::now();
+            std::this_thread::sleep_for(baseline);
+            const auto elapsed_ticks = ticks() - start_ticks;
+            const auto elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+            return static_cast<double>(elapsed_ns.count()) / static_cast<double>(elapsed_ticks);
+#else
+            return 1.0;
+#endif
+        }
+    } // namespace
+
+    void calibrate()
+    {
+        const auto measured = measure_ns_per_tick();
+        auto& r = registry();
+        std::lock_guard guard{r.lock};
+        r.ns_per_tick = measured;
+    }
+
+    auto probe(std::string_view category, std::string_view name) -> Histogram&
+    {
+        auto& r = registry();
+        std::lock_guard guard{r.lock};
+        if(auto found = r.index.find(std::pair{category, name}); found != r.index.end())
+            return *found->second;
+        auto& added = r.probes.emplace_back(category, name);
+        r.index.emplace(std::pair{category, name}, &added.histogram);
+        return added.histogram;
+    }
+
+    void report(fmt::memory_buffer& out)
+    {
+        auto& r = registry();
+        std::lock_guard guard{r.lock};
+        if(r.probes.empty())
+            return;
+        // Whoever didn't calibrate at start up, waits for it now
+        if(r.ns_per_tick == 0.0)
+            r.ns_per_tick = measure_ns_per_tick();
+        const auto scale = r.ns_per_tick;
+        for(const auto& [category, name, histogram] : r.probes) {
+            if(histogram.count() != 0)
+                append_percentiles(out, category, name, histogram, scale);
+        }
+    }
+
+    void append_percentiles(fmt::memory_buffer& out, std::string_view category, std::string_view name, const Histogram& histogram,
+                            double ns_per_unit)
+    {
+        auto ns = [ns_per_unit](auto value) { return static_cast<double>(value) * ns_per_unit; };
+        fmt::format_to(std::back_inserter(out), "{} {}: {} times, mean {:.0f}ns, p50 {:.0f}ns, p90 {:.0f}ns, p99 {:.0f}ns, max {:.0f}ns\n", category,
+                       name, histogram.count(), ns(histogram.mean()), ns(histogram.percentile(50)), ns(histogram.percentile(90)),
+                       ns(histogram.percentile(99)), ns(histogram.max()));
+    }
+} // namespace cx::instrumentation
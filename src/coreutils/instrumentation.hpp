@@ -0,0 +1,98 @@
+#pragma once
+// System headers
+#include <array>
+#include <cstdint>
+#include <string_view>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#    include <x86intrin.h>
+#endif
+
+// Third party headers
+#include <fmt/format.h>
+
+// Library/Application headers
+#include <coreutils/core.hpp>
+#include <coreutils/histogram.hpp>
+
+/// Where the time goes, per kind of X event, command & IPC request: TIMED_SCOPE times the rest of the scope it's in, into the histogram of
+/// the probe it names. Built with INSTRUMENTATION_SET (Debug builds) only; otherwise the macros are nothing, & so is what they cost.
+/// Timing is by the time stamp counter where there is one, which takes a few ns to read, & CLOCK_MONOTONIC where there isn't
+namespace cx::instrumentation
+{
+#ifdef INSTRUMENTATION_SET
+    constexpr bool enabled = true;
+#else
+    constexpr bool enabled = false;
+#endif
+
+    /// In time stamp counter ticks, or nanoseconds. report() does the converting
+    inline auto ticks() noexcept -> std::uint64_t
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        timespec ts{};
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<std::uint64_t>(ts.tv_sec) * 1'000'000'000ULL + static_cast<std::uint64_t>(ts.tv_nsec);
+#endif
+    }
+
+    /// The histogram of the probe named category & name, made the first time it's asked for. Both have to outlive the program, i.e. be
+    /// string literals; a lookup doesn't copy them
+    auto probe(std::string_view category, std::string_view name) -> Histogram&;
+    /// Works out how long a tick is, over a few ms. Call at start up, so that the first report() doesn't have to wait for it
+    void calibrate();
+    /// Appends a line per probe that has recorded anything, in nanoseconds: count, mean, p50, p90, p99 & max
+    void report(fmt::memory_buffer& out);
+    /// Appends a line for histogram, of values in nanoseconds
+    void append_percentiles(fmt::memory_buffer& out, std::string_view category, std::string_view name, const Histogram& histogram,
+                            double ns_per_unit = 1.0);
+
+    /// The probes of category named in names, looked up once; timing under one of them is an array index
+    template<std::size_t N>
+    class ProbeSet
+    {
+      public:
+        ProbeSet(std::string_view category, const std::array<std::string_view, N>& names)
+        {
+            for(std::size_t i = 0; i < N; ++i)
+                probes[i] = &probe(category, names[i]);
+        }
+        auto operator[](std::size_t index) const noexcept -> Histogram& { return *probes[index]; }
+
+      private:
+        std::array<Histogram*, N> probes{};
+    };
+
+    class ScopedTimer
+    {
+      public:
+        explicit ScopedTimer(Histogram& histogram) noexcept : histogram(histogram), start(ticks()) {}
+        ScopedTimer(const ScopedTimer&) = delete;
+        ScopedTimer& operator=(const ScopedTimer&) = delete;
+        ~ScopedTimer() { histogram.record(ticks() - start); }
+
+      private:
+        Histogram& histogram;
+        std::uint64_t start;
+    };
+} // namespace cx::instrumentation
+
+#define CX_CONCAT_IMPL(a, b) a##b
+#define CX_CONCAT(a, b)      CX_CONCAT_IMPL(a, b)
+
+#ifdef INSTRUMENTATION_SET
+/// For a probe that's always the same where it's used: it's looked up once, the first time through
+#    define TIMED_SCOPE(category, name)                                                                                                   \
+        static auto& CX_CONCAT(probe_, __LINE__) = cx::instrumentation::probe(category, name);                                          \
+        cx::instrumentation::ScopedTimer CX_CONCAT(timer_, __LINE__) { CX_CONCAT(probe_, __LINE__) }
+/// For a probe that depends on what's being timed, i.e. a command's type: names is a constexpr array of every probe name there is (string
+/// literals), index picks one. They're all looked up the first time through
+#    define TIMED_SCOPE_DYNAMIC(category, names, index)                                                                                   \
+        static const cx::instrumentation::ProbeSet CX_CONCAT(probes_, __LINE__){category, names};                                       \
+        cx::instrumentation::ScopedTimer CX_CONCAT(timer_, __LINE__) { CX_CONCAT(probes_, __LINE__)[static_cast<std::size_t>(index)] }
+#else
+#    define TIMED_SCOPE(category, name)
+#    define TIMED_SCOPE_DYNAMIC(category, names, index)
+#endif
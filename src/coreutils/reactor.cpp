@@ -0,0 +1,195 @@
+#include "reactor.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <utility>
+
+namespace cx
+{
+    namespace
+    {
+        /// Set in the epoll data of our own sources; the file descriptor is in the low half. Others add theirs with data.fd, which leaves
+        /// the high half 0
+        constexpr std::uint64_t OWNED = 1ULL << 32;
+
+        auto to_timespec(std::chrono::nanoseconds duration) -> timespec
+        {
+            const auto seconds = std::chrono::duration_cast<std::chrono::seconds>(duration);
+            return timespec{static_cast<time_t>(seconds.count()), static_cast<long>((duration - seconds).count())};
+        }
+    } // namespace
+
+    auto Reactor::create() -> std::optional<Reactor>
+    {
+        auto fd = epoll_create1(EPOLL_CLOEXEC);
+        if(fd == -1) {
+            cx::println("Failed to create epoll instance: {}", std::strerror(errno));
+            return {};
+        }
+        return Reactor{fd};
+    }
+
+    Reactor::Reactor(int epoll_fd) noexcept : epoll_fd(epoll_fd) { sigemptyset(&signal_mask); }
+
+    Reactor::Reactor(Reactor&& other) noexcept
+        : epoll_fd(std::exchange(other.epoll_fd, -1)), sources(std::move(other.sources)), retired(std::move(other.retired)),
+          fallback(std::move(other.fallback)), hooks(std::move(other.hooks)), signal_fd(std::exchange(other.signal_fd, -1)), signal_mask(other.signal_mask)
+    {
+        sigemptyset(&other.signal_mask);
+    }
+
+    Reactor& Reactor::operator=(Reactor&& other) noexcept
+    {
+        std::swap(epoll_fd, other.epoll_fd);
+        std::swap(sources, other.sources);
+        std::swap(retired, other.retired);
+        std::swap(fallback, other.fallback);
+        std::swap(hooks, other.hooks);
+        std::swap(signal_fd, other.signal_fd);
+        std::swap(signal_mask, other.signal_mask);
+        return *this;
+    }
+
+    Reactor::~Reactor()
+    {
+        for(const auto& [fd, source] : sources) {
+            if(!std::holds_alternative<Io>(*source))
+                close(fd);
+        }
+        if(signal_fd != -1)
+            sigprocmask(SIG_UNBLOCK, &signal_mask, nullptr);
+        if(epoll_fd != -1)
+            close(epoll_fd);
+    }
+
+    auto Reactor::fd() const -> int { return epoll_fd; }
+
+    auto Reactor::add_source(int fd, u32 events, Source source) -> bool
+    {
+        epoll_event event{};
+        event.events = events;
+        event.data.u64 = OWNED | static_cast<std::uint32_t>(fd);
+        if(epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) == -1) {
+            cx::println("Failed to add file descriptor {} to epoll: {}", fd, std::strerror(errno));
+            return false;
+        }
+        sources[fd] = std::make_unique<Source>(std::move(source));
+        return true;
+    }
+
+    void Reactor::remove_source(int fd)
+    {
+        auto source = sources.find(fd);
+        if(source == sources.end())
+            return;
+        epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+        if(!std::holds_alternative<Io>(*source->second))
+            close(fd);
+        retired.push_back(std::move(source->second));
+        sources.erase(source);
+    }
+
+    auto Reactor::watch(int fd, u32 events, IoHandler handler) -> bool { return add_source(fd, events, Io{std::move(handler)}); }
+
+    void Reactor::unwatch(int fd)
+    {
+        if(auto source = sources.find(fd); source != sources.end() && std::holds_alternative<Io>(*source->second))
+            remove_source(fd);
+    }
+
+    void Reactor::set_fallback(IoHandler handler) { fallback = std::move(handler); }
+
+    auto Reactor::add_timer(std::chrono::nanoseconds delay, std::chrono::nanoseconds interval, TimerHandler handler) -> int
+    {
+        auto fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        if(fd == -1) {
+            cx::println("Failed to create timer: {}", std::strerror(errno));
+            return -1;
+        }
+        // A zero it_value disarms the timer instead; a timer that's due now, is due in a nanosecond
+        itimerspec spec{to_timespec(interval), to_timespec(std::max(delay, std::chrono::nanoseconds{1}))};
+        if(timerfd_settime(fd, 0, &spec, nullptr) == -1 || !add_source(fd, EPOLLIN, Timer{std::move(handler), interval.count() > 0})) {
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    void Reactor::cancel_timer(int timer)
+    {
+        if(auto source = sources.find(timer); source != sources.end() && std::holds_alternative<Timer>(*source->second))
+            remove_source(timer);
+    }
+
+    auto Reactor::handle_signals(std::initializer_list<int> signals, SignalHandler handler) -> bool
+    {
+        for(auto signal : signals)
+            sigaddset(&signal_mask, signal);
+        // Blocked, they stay pending until the signalfd is read, instead of running a handler in the middle of who knows what
+        if(sigprocmask(SIG_BLOCK, &signal_mask, nullptr) == -1) {
+            cx::println("Failed to block signals: {}", std::strerror(errno));
+            return false;
+        }
+        auto fd = signalfd(signal_fd, &signal_mask, SFD_NONBLOCK | SFD_CLOEXEC);
+        if(fd == -1) {
+            cx::println("Failed to create signalfd: {}", std::strerror(errno));
+            return false;
+        }
+        if(fd == signal_fd) {
+            *sources[fd] = Signals{std::move(handler)};
+            return true;
+        }
+        signal_fd = fd;
+        return add_source(fd, EPOLLIN, Signals{std::move(handler)});
+    }
+
+    void Reactor::before_wait(std::function<void()> hook) { hooks.push_back(std::move(hook)); }
+
+    auto Reactor::run_once(int timeout) -> int
+    {
+        for(const auto& hook : hooks)
+            hook();
+        std::array<epoll_event, 32> events{};
+        auto count = epoll_wait(epoll_fd, events.data(), static_cast<int>(events.size()), timeout);
+        if(count == -1)
+            return errno == EINTR ? 0 : -1;
+        for(auto i = 0; i < count; ++i) {
+            const auto data = events[i].data.u64;
+            if(data & OWNED)
+                dispatch(static_cast<int>(data & ~OWNED), events[i].events);
+            else if(fallback)
+                fallback(events[i].data.fd, events[i].events);
+        }
+        retired.clear();
+        return count;
+    }
+
+    void Reactor::dispatch(int fd, u32 events)
+    {
+        auto found = sources.find(fd);
+        // Removed by a handler earlier in the same batch
+        if(found == sources.end())
+            return;
+        auto* source = found->second.get();
+        if(auto io = std::get_if<Io>(source)) {
+            io->handler(fd, events);
+        } else if(auto timer = std::get_if<Timer>(source)) {
+            // Reading it is what disarms the readiness. Nothing to read means it was cancelled, and the number reused, since epoll said so
+            std::uint64_t expirations = 0;
+            if(read(fd, &expirations, sizeof(expirations)) != sizeof(expirations))
+                return;
+            if(!timer->periodic)
+                remove_source(fd);
+            timer->handler();
+        } else if(auto signals = std::get_if<Signals>(source)) {
+            signalfd_siginfo info{};
+            while(read(fd, &info, sizeof(info)) == sizeof(info))
+                signals->handler(static_cast<int>(info.ssi_signo));
+        }
+    }
+} // namespace cx
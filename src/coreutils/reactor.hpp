@@ -0,0 +1,89 @@
+#pragma once
+// System headers
+#include <chrono>
+#include <csignal>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+// Library/Application headers
+#include <coreutils/core.hpp>
+
+namespace cx
+{
+    /// Called with the file descriptor & the epoll events it's ready for
+    using IoHandler = std::function<void(int fd, u32 events)>;
+    using TimerHandler = std::function<void()>;
+    /// Called with the signal number, once per signal delivered
+    using SignalHandler = std::function<void(int signal)>;
+
+    /// The one place the event loop sleeps: an epoll instance, with a handler per file descriptor, timers on timerfds & signals on a
+    /// signalfd. Everything is level triggered, so a handler that leaves something unread gets called again next time, instead of never.
+    /// File descriptors others add to fd() themselves (the IPC socket's clients) go to the fallback handler
+    class Reactor
+    {
+      public:
+        /// Nothing if the kernel won't give us an epoll instance
+        static auto create() -> std::optional<Reactor>;
+        Reactor(Reactor&& other) noexcept;
+        Reactor& operator=(Reactor&& other) noexcept;
+        Reactor(const Reactor&) = delete;
+        Reactor& operator=(const Reactor&) = delete;
+        ~Reactor();
+
+        /// The epoll instance, for those that add file descriptors to it on their own
+        [[nodiscard]] auto fd() const -> int;
+        /// Calls handler whenever fd is ready for events. fd stays the caller's to close, after unwatch()
+        auto watch(int fd, u32 events, IoHandler handler) -> bool;
+        void unwatch(int fd);
+        /// Gets what epoll says about the file descriptors that were added to fd() by someone else
+        void set_fallback(IoHandler handler);
+        /// Calls handler after delay, and then every interval, unless that's 0. Returns an id to cancel it with, or -1 if there's no timerfd
+        /// to be had. A one shot timer is gone once it's fired
+        auto add_timer(std::chrono::nanoseconds delay, std::chrono::nanoseconds interval, TimerHandler handler) -> int;
+        void cancel_timer(int timer);
+        /// Blocks signals & has them delivered to handler, by the event loop, instead of interrupting whatever is going on. They stay
+        /// blocked in threads created after this, and in processes spawned from them
+        auto handle_signals(std::initializer_list<int> signals, SignalHandler handler) -> bool;
+
+        /// Called by run_once() every time, before it waits. For whoever needs to get things in order before we sleep, i.e. arm a timer
+        void before_wait(std::function<void()> hook);
+
+        /// Waits for at most timeout milliseconds (-1 for as long as it takes) & dispatches whatever happened. Returns the number of events
+        /// dispatched, or -1 if epoll failed. A signal interrupting the wait isn't a failure; it's 0 events
+        auto run_once(int timeout) -> int;
+
+      private:
+        struct Io {
+            IoHandler handler;
+        };
+        struct Timer {
+            TimerHandler handler;
+            bool periodic;
+        };
+        struct Signals {
+            SignalHandler handler;
+        };
+        using Source = std::variant<Io, Timer, Signals>;
+
+        explicit Reactor(int epoll_fd) noexcept;
+        auto add_source(int fd, u32 events, Source source) -> bool;
+        /// Removes fd from epoll & from sources. Its handler is kept alive until the end of run_once(), as it might be what called this
+        void remove_source(int fd);
+        void dispatch(int fd, u32 events);
+
+        int epoll_fd;
+        /// Boxed, so that a handler that removes its own source isn't moved out from under itself
+        std::unordered_map<int, std::unique_ptr<Source>> sources{};
+        /// Removed since run_once() last got to the end
+        std::vector<std::unique_ptr<Source>> retired{};
+        IoHandler fallback{};
+        std::vector<std::function<void()>> hooks{};
+        int signal_fd = -1;
+        sigset_t signal_mask{};
+    };
+} // namespace cx
@@ -0,0 +1,206 @@
+#include "timer_wheel.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <limits>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace cx
+{
+    namespace
+    {
+        constexpr std::uint64_t NS_PER_TICK = std::chrono::nanoseconds{TimerWheel::TICK}.count();
+        constexpr auto NEVER = std::numeric_limits<std::uint64_t>::max();
+
+        auto monotonic_ns() -> std::uint64_t
+        {
+            timespec ts{};
+            clock_gettime(CLOCK_MONOTONIC, &ts);
+            return static_cast<std::uint64_t>(ts.tv_sec) * 1'000'000'000ULL + static_cast<std::uint64_t>(ts.tv_nsec);
+        }
+
+        auto shift_of(unsigned level) -> unsigned { return level * TimerWheel::SLOT_BITS; }
+    } // namespace
+
+    TimerNode::TimerNode(std::function<void()> on_expiry) noexcept : on_expiry(std::move(on_expiry)) {}
+
+    TimerNode::~TimerNode()
+    {
+        if(wheel)
+            wheel->cancel(*this);
+    }
+
+    auto TimerWheel::create(Reactor& reactor) -> std::unique_ptr<TimerWheel>
+    {
+        auto fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        if(fd == -1) {
+            cx::println("Failed to create timer for the timer wheel: {}", std::strerror(errno));
+            return nullptr;
+        }
+        auto wheel = std::unique_ptr<TimerWheel>{new TimerWheel{fd}};
+        auto* self = wheel.get();
+        if(!reactor.watch(fd, EPOLLIN, [self](int, u32) { self->advance(); }))
+            return nullptr;
+        reactor.before_wait([self] { self->sync_timer(); });
+        return wheel;
+    }
+
+    TimerWheel::TimerWheel(int timer_fd) noexcept : timer_fd(timer_fd), now(monotonic_ns() / NS_PER_TICK)
+    {
+        for(auto& head : slots)
+            head.prev = head.next = &head;
+    }
+
+    TimerWheel::~TimerWheel()
+    {
+        // Whoever still has an armed timer mustn't try to take it out of a wheel that's gone
+        for(auto& head : slots) {
+            for(auto link = head.next; link != &head; link = link->next)
+                static_cast<TimerNode*>(link)->wheel = nullptr;
+        }
+        close(timer_fd);
+    }
+
+    void TimerWheel::arm(TimerNode& timer, std::chrono::nanoseconds delay)
+    {
+        if(timer.wheel)
+            unlink(timer);
+        const auto clock = monotonic_ns();
+        // With nothing pending, nothing has kept now up to date; it can catch up without anything to fire
+        if(count == 0)
+            now = std::max(now, clock / NS_PER_TICK);
+        // Rounded up, so it never fires early. Nor in the tick that's being fired; that's 64 ticks away, as far as the slots go
+        const auto deadline = clock + static_cast<std::uint64_t>(std::max<std::int64_t>(delay.count(), 0));
+        timer.expires = std::max((deadline + NS_PER_TICK - 1) / NS_PER_TICK, now + 1);
+        timer.wheel = this;
+        insert(timer);
+    }
+
+    void TimerWheel::cancel(TimerNode& timer)
+    {
+        if(timer.wheel != this)
+            return;
+        unlink(timer);
+        timer.wheel = nullptr;
+    }
+
+    void TimerWheel::insert(TimerNode& timer)
+    {
+        const auto delta = timer.expires > now ? timer.expires - now : 0;
+        auto level = 0U;
+        while(level + 1 < LEVELS && delta >= (1ULL << shift_of(level + 1)))
+            ++level;
+        // Further out than the top level goes, it waits in the top level's last slot & gets put back there when that comes up
+        const auto expires = std::min<std::uint64_t>(timer.expires, now + (1ULL << shift_of(LEVELS)) - 1);
+        const auto index = static_cast<unsigned>(expires >> shift_of(level)) & (SLOTS - 1);
+        timer.slot = static_cast<std::uint16_t>(level * SLOTS + index);
+        auto& head = slots[timer.slot];
+        timer.prev = head.prev;
+        timer.next = &head;
+        head.prev->next = &timer;
+        head.prev = &timer;
+        occupied[level] |= 1ULL << index;
+        ++count;
+    }
+
+    void TimerWheel::unlink(TimerNode& timer)
+    {
+        timer.prev->next = timer.next;
+        timer.next->prev = timer.prev;
+        timer.prev = timer.next = nullptr;
+        if(auto& head = slots[timer.slot]; head.next == &head)
+            occupied[timer.slot / SLOTS] &= ~(1ULL << (timer.slot % SLOTS));
+        --count;
+    }
+
+    void TimerWheel::cascade(unsigned level, unsigned index)
+    {
+        auto& head = slots[level * SLOTS + index];
+        while(head.next != &head) {
+            auto& timer = *static_cast<TimerNode*>(head.next);
+            unlink(timer);
+            insert(timer);
+        }
+    }
+
+    auto TimerWheel::next_tick() const -> std::uint64_t
+    {
+        auto next = NEVER;
+        for(auto level = 0U; level < LEVELS; ++level) {
+            if(occupied[level] == 0)
+                continue;
+            const auto position = now >> shift_of(level);
+            // Slots after the current one first; the current one itself is a whole turn away
+            const auto rotated = std::rotr(occupied[level], static_cast<int>((position + 1) & (SLOTS - 1)));
+            const auto distance = static_cast<std::uint64_t>(std::countr_zero(rotated)) + 1;
+            next = std::min(next, (position + distance) << shift_of(level));
+        }
+        return next;
+    }
+
+    void TimerWheel::advance()
+    {
+        std::uint64_t expirations = 0;
+        if(read(timer_fd, &expirations, sizeof(expirations)) == sizeof(expirations)) {
+            ++wakeup_count;
+            armed_tick = 0;
+        }
+        const auto target = monotonic_ns() / NS_PER_TICK;
+        for(auto tick = next_tick(); tick <= target; tick = next_tick()) {
+            now = tick;
+            // Top down, so that whatever comes down from a level above lands where the level below is about to look
+            for(auto level = LEVELS - 1; level > 0; --level) {
+                if((now & ((1ULL << shift_of(level)) - 1)) == 0)
+                    cascade(level, static_cast<unsigned>(now >> shift_of(level)) & (SLOTS - 1));
+            }
+            auto& head = slots[now & (SLOTS - 1)];
+            while(head.next != &head) {
+                auto& timer = *static_cast<TimerNode*>(head.next);
+                unlink(timer);
+                timer.wheel = nullptr;
+                // May re-arm itself, or arm & cancel others; none of that can end up in this slot again
+                if(timer.on_expiry)
+                    timer.on_expiry();
+            }
+        }
+        now = std::max(now, target);
+    }
+
+    void TimerWheel::sync_timer()
+    {
+        const auto next = next_tick();
+        if(next == armed_tick || (next == NEVER && armed_tick == 0))
+            return;
+        itimerspec spec{};
+        if(next != NEVER) {
+            const auto ns = next * NS_PER_TICK;
+            spec.it_value = timespec{static_cast<time_t>(ns / 1'000'000'000ULL), static_cast<long>(ns % 1'000'000'000ULL)};
+        }
+        timerfd_settime(timer_fd, TFD_TIMER_ABSTIME, &spec, nullptr);
+        armed_tick = next == NEVER ? 0 : next;
+    }
+
+    auto TimerWheel::pending() const -> std::size_t { return count; }
+
+    auto TimerWheel::wakeups() const -> std::size_t { return wakeup_count; }
+
+    Debouncer::Debouncer(TimerWheel& wheel, std::chrono::nanoseconds delay, std::function<void(std::uint64_t key)> handler)
+        : wheel(wheel), delay(delay), handler(std::move(handler))
+    {
+    }
+
+    void Debouncer::debounce(std::uint64_t key)
+    {
+        auto [timer, added] = timers.try_emplace(key);
+        if(added)
+            timer->second.on_expiry = [this, key] { handler(key); };
+        if(!timer->second.armed())
+            wheel.arm(timer->second, delay);
+    }
+
+    void Debouncer::forget(std::uint64_t key) { timers.erase(key); }
+} // namespace cx
@@ -0,0 +1,112 @@
+#pragma once
+// System headers
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+
+// Library/Application headers
+#include <coreutils/core.hpp>
+#include <coreutils/reactor.hpp>
+
+namespace cx
+{
+    class TimerWheel;
+
+    /// Links of the intrusive lists the wheel's slots are made of
+    struct TimerLink {
+        TimerLink* prev = nullptr;
+        TimerLink* next = nullptr;
+    };
+
+    /// A timer that lives in whatever it's for. Arming & cancelling it allocates nothing; destroying it while it's armed, cancels it
+    class TimerNode : private TimerLink
+    {
+      public:
+        explicit TimerNode(std::function<void()> on_expiry = {}) noexcept;
+        TimerNode(const TimerNode&) = delete;
+        TimerNode& operator=(const TimerNode&) = delete;
+        ~TimerNode();
+        [[nodiscard]] auto armed() const -> bool { return wheel != nullptr; }
+        std::function<void()> on_expiry;
+
+      private:
+        friend class TimerWheel;
+        TimerWheel* wheel = nullptr;
+        /// In ticks
+        std::uint64_t expires = 0;
+        /// Index into TimerWheel::slots
+        std::uint16_t slot = 0;
+    };
+
+    /// Timers by the millisecond, on one timerfd: four levels of 64 slots, each slot of a level spanning all of the level below it, so a
+    /// timer goes in (and comes out) in constant time, whether it's due in 2ms or in an hour. Timers further out are moved down a level
+    /// as their slot comes up. The timerfd is only set when the earliest deadline has changed, right before the reactor waits; arming &
+    /// cancelling a thousand timers in between costs nothing but the list operations, and cancelled timers never wake us up
+    class TimerWheel
+    {
+      public:
+        static constexpr auto TICK = std::chrono::milliseconds{1};
+        static constexpr unsigned LEVELS = 4;
+        static constexpr unsigned SLOT_BITS = 6;
+        static constexpr unsigned SLOTS = 1U << SLOT_BITS;
+
+        /// Nothing if there's no timerfd to be had. The wheel goes off as a handler of reactor, which may be moved, but has to outlive it
+        static auto create(Reactor& reactor) -> std::unique_ptr<TimerWheel>;
+        TimerWheel(const TimerWheel&) = delete;
+        TimerWheel& operator=(const TimerWheel&) = delete;
+        ~TimerWheel();
+
+        /// Fires timer after delay, at the earliest; it's rounded up to the next tick. Re-arming an armed timer moves it
+        void arm(TimerNode& timer, std::chrono::nanoseconds delay);
+        void cancel(TimerNode& timer);
+        /// Fires everything that's due
+        void advance();
+        [[nodiscard]] auto pending() const -> std::size_t;
+        /// Times the timerfd went off
+        [[nodiscard]] auto wakeups() const -> std::size_t;
+
+      private:
+        explicit TimerWheel(int timer_fd) noexcept;
+        /// Puts timer in the slot its deadline falls in, as seen from now
+        void insert(TimerNode& timer);
+        void unlink(TimerNode& timer);
+        /// Moves the timers of a slot further out, into the levels below it
+        void cascade(unsigned level, unsigned index);
+        /// The next tick anything has to be done at: a level 0 slot with timers in it, or a higher one that has to be cascaded
+        [[nodiscard]] auto next_tick() const -> std::uint64_t;
+        /// Sets the timerfd for next_tick(), or disarms it, if that's not what it's already set to
+        void sync_timer();
+
+        int timer_fd;
+        /// The tick everything up to, and including, has been fired
+        std::uint64_t now;
+        std::array<TimerLink, LEVELS * SLOTS> slots{};
+        /// Bit n of a level is set while its slot n has timers in it
+        std::array<std::uint64_t, LEVELS> occupied{};
+        std::size_t count = 0;
+        /// What the timerfd is set to; 0 while disarmed
+        std::uint64_t armed_tick = 0;
+        std::size_t wakeup_count = 0;
+    };
+
+    /// Runs handler(key) once, within delay of the first call to debounce(key) since it last ran, no matter how many calls there are in
+    /// between; i.e. redraw a window's title no more than once every 16ms, however fast it changes. A key's timer is allocated the first
+    /// time it's seen, and reused from then on
+    class Debouncer
+    {
+      public:
+        Debouncer(TimerWheel& wheel, std::chrono::nanoseconds delay, std::function<void(std::uint64_t key)> handler);
+        void debounce(std::uint64_t key);
+        /// Cancels whatever is pending for key & lets go of its timer. Not to be called from handler
+        void forget(std::uint64_t key);
+
+      private:
+        TimerWheel& wheel;
+        std::chrono::nanoseconds delay;
+        std::function<void(std::uint64_t)> handler;
+        std::unordered_map<std::uint64_t, TimerNode> timers{};
+    };
+} // namespace cx
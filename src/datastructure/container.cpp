@@ -16,13 +16,13 @@ namespace cx::workspace
     ContainerTree::ContainerTree(std::string container_tag, geom::Geometry geometry, ContainerTree* parent, Layout layout,
                                  std::size_t height) noexcept
         : tag(std::move(container_tag)), client{}, left(nullptr), right(nullptr), parent(parent), policy(layout), split_ratio(0.5),
-          geometry(geometry), m_tree_height(height)
+          geometry(geometry), m_tree_height(height), dirty(false)
     {
     }
 
     ContainerTree::ContainerTree(std::string container_tag, geom::Geometry geometry, Layout layout) noexcept
         : tag(std::move(container_tag)), client{}, left(nullptr), right(nullptr), parent(this), policy(layout), split_ratio(0.5f), geometry(geometry),
-          m_tree_height(0)
+          m_tree_height(0), dirty(false)
     {
     }
 
@@ -84,22 +84,40 @@ namespace cx::workspace
         }
     }
 
-    void ContainerTree::update_subtree_geometry()
+    void ContainerTree::mark_dirty()
     {
-        if(is_split_container()) {
-            auto [ltree_geo, rtree_geo] = split_at(geometry, policy, this->split_position);
-            if(left) {
-                left->geometry = ltree_geo;
-                left->update_subtree_geometry();
-            }
-            if(right) {
-                right->geometry = rtree_geo;
-                right->update_subtree_geometry();
-            }
+        // If a node is dirty, so are all of it's ancestors, so we can stop at the first one that already is
+        for(auto node = this; !node->dirty; node = node->parent) {
+            node->dirty = true;
+            if(node->is_root())
+                break;
         }
+    }
+
+    void ContainerTree::layout(std::vector<ContainerTree*>& changed_windows)
+    {
+        if(!dirty)
+            return;
+        dirty = false;
         if(is_window()) {
-            this->client->set_geometry(this->geometry);
+            if(client->geometry != geometry) {
+                client->set_geometry(geometry);
+                changed_windows.push_back(this);
+            }
+            return;
         }
+        auto [ltree_geo, rtree_geo] = split_at(geometry, policy, split_position);
+        auto layout_child = [&changed_windows](TreeOwned& child, const geom::Geometry& child_geometry) {
+            if(!child)
+                return;
+            if(child->geometry != child_geometry) {
+                child->geometry = child_geometry;
+                child->dirty = true;
+            }
+            child->layout(changed_windows);
+        };
+        layout_child(left, ltree_geo);
+        layout_child(right, rtree_geo);
     }
 
     void ContainerTree::switch_layout_policy()
@@ -121,7 +139,7 @@ namespace cx::workspace
     {
         if(is_window()) {
             parent->switch_layout_policy();
-            parent->update_subtree_geometry();
+            parent->mark_dirty();
         }
     }
     /// Rotates position of a client-tile-pair
@@ -129,7 +147,7 @@ namespace cx::workspace
     {
         if(!is_root()) {
             parent->left.swap(parent->right);
-            parent->update_subtree_geometry();
+            parent->mark_dirty();
         }
     }
     // This looks rugged...
@@ -162,8 +180,8 @@ namespace cx::workspace
                 from->parent = parent_to;
                 to->parent = parent_from;
             }
-            parent_from->update_subtree_geometry();
-            parent_to->update_subtree_geometry();
+            parent_from->mark_dirty();
+            parent_to->mark_dirty();
         } else {
             DBGLOG("Root windows can not be moved! {}", "");
         }
@@ -178,12 +196,12 @@ namespace cx::workspace
             if(grand_parent->left.get() == child->parent) {
                 child->parent = grand_parent;
                 grand_parent->left.swap(child);
-                grand_parent->update_subtree_geometry();
+                grand_parent->mark_dirty();
                 return grand_parent->left.get();
             } else {
                 child->parent = grand_parent;
                 grand_parent->right.swap(child);
-                grand_parent->update_subtree_geometry();
+                grand_parent->mark_dirty();
                 return grand_parent->right.get();
             }
         }
@@ -2,6 +2,7 @@
 #include <memory>
 #include <optional>
 #include <string>
+#include <vector>
 
 #include <xcom/window.hpp>
 
@@ -57,6 +58,8 @@ namespace cx::workspace
         geom::Geometry geometry;
         std::size_t m_tree_height;
         geom::Position split_position;
+        /// Set when this node, or something below it, needs its geometry recomputed by layout()
+        bool dirty;
         [[nodiscard]] bool is_root() const;
         [[nodiscard]] bool is_split_container() const; // basically "is_branch?"
         [[nodiscard]] bool is_window() const;          // basically "is_leaf?"
@@ -67,7 +70,11 @@ namespace cx::workspace
         [[nodiscard]] auto get_center() const -> geom::Position;
 
         void push_client(Window new_client);
-        void update_subtree_geometry();
+        /// Flags this node for the next layout pass. Its ancestors get flagged too, so the pass can find it from the root
+        void mark_dirty();
+        /// Recomputes geometry of dirty subtrees only, and collects the windows whose geometry actually changed in changed_windows.
+        /// Subtrees that aren't dirty, and whose rectangle didn't change, are not visited at all
+        void layout(std::vector<ContainerTree*>& changed_windows);
         void switch_layout_policy();
 
         void rotate_container_layout();
@@ -79,12 +86,9 @@ namespace cx::workspace
         template<typename MapFn>
         friend auto in_order_window_map(std::unique_ptr<ContainerTree>& tree_node, MapFn fn) -> void;
 
-        template<typename ThenFn>
-        friend auto find_window_and_then(std::unique_ptr<ContainerTree>& tree_node, xcb_window_t win, ThenFn fn) -> void;
-
         friend void move_client(ContainerTree* from, ContainerTree* to);
-        // Promote's child to parent. This function also calls update_subtree_geometry on promoted child so all it's children get proper
-        // geometries
+        // Promote's child to parent. The grand parent is marked dirty, so the promoted child & it's children get proper geometries in the next
+        // layout pass
         friend auto promote_child(std::unique_ptr<ContainerTree> child) -> ContainerTree*;
         static auto make_root(const std::string& container_tag, geom::Geometry geometry, Layout layout) -> TreeOwned;
 
@@ -108,16 +112,6 @@ namespace cx::workspace
         in_order_window_map(tree_node->right, fn);
     }
 
-    template<typename ThenFn>
-    auto find_window_and_then(std::unique_ptr<ContainerTree>& tree_node, xcb_window_t win, ThenFn fn) -> void {
-        if(!tree_node) return;
-        find_window_and_then(tree_node->left, win, fn);
-        if(tree_node->is_window() && (tree_node->client.value().client_id == win || tree_node->client.value().frame_id == win)) {
-            fn(tree_node->client.value());
-        }
-        find_window_and_then(tree_node->right, win, fn);
-    }
-
     template<typename Predicate>
     auto tree_in_order_find(std::unique_ptr<ContainerTree>& tree, Predicate p) -> std::optional<ContainerTree*>
     {
@@ -34,6 +34,7 @@ namespace cx::geom
     struct Position {
         GU x, y;
         friend Position operator+(const Position& lhs, const Vector& rhs);
+        friend bool operator==(const Position& lhs, const Position& rhs) = default;
     };
 
     Position operator+(const Position& lhs, const Vector& rhs);
@@ -64,6 +65,7 @@ namespace cx::geom
         friend Geometry operator+(const Geometry& lhs, const Position& rhs);
         // Scalar multiplication of the *dimensions*, i.e. width & height, not the anchor/position
         friend Geometry operator*(const Geometry& lhs, int rhs);
+        friend bool operator==(const Geometry& lhs, const Geometry& rhs) = default;
         friend Position middle_of_top(const Geometry& g);
         friend Position middle_of_side(const Geometry& g, ScreenSpaceDirection direction);
         friend Position center(const Geometry& g);
@@ -0,0 +1,98 @@
+#include <algorithm>
+#include <bit>
+#include <datastructure/window_index.hpp>
+
+namespace cx::workspace
+{
+    // XCB_WINDOW_NONE is never a window we manage, so it marks an empty slot
+    constexpr xcb_window_t EMPTY = XCB_WINDOW_NONE;
+
+    WindowIndex::WindowIndex(std::size_t initial_capacity)
+        : slots(std::bit_ceil(std::max<std::size_t>(initial_capacity, 8)), Slot{EMPTY, {}}), mask(slots.size() - 1)
+    {
+    }
+
+    void WindowIndex::assign(xcb_window_t client, xcb_window_t frame, Workspace* workspace, ContainerTree* node)
+    {
+        WindowLocation location{client, frame, workspace, node};
+        insert(client, location);
+        insert(frame, location);
+    }
+
+    void WindowIndex::erase(xcb_window_t client, xcb_window_t frame)
+    {
+        erase(client);
+        erase(frame);
+    }
+
+    auto WindowIndex::find(xcb_window_t xid) const -> const WindowLocation*
+    {
+        if(xid == EMPTY)
+            return nullptr;
+        for(auto i = slot_of(xid);; i = (i + 1) & mask) {
+            if(slots[i].key == xid)
+                return &slots[i].location;
+            if(slots[i].key == EMPTY)
+                return nullptr;
+        }
+    }
+
+    auto WindowIndex::size() const -> std::size_t { return used / 2; }
+
+    auto WindowIndex::slot_of(xcb_window_t xid) const -> std::size_t
+    {
+        // Fibonacci hashing; the high bits of the product are the well mixed ones
+        return static_cast<std::size_t>((static_cast<std::uint64_t>(xid) * 11400714819323198485ULL) >> 32U) & mask;
+    }
+
+    void WindowIndex::insert(xcb_window_t key, const WindowLocation& location)
+    {
+        if(key == EMPTY)
+            return;
+        // Keep the load factor at or below 1/2, so probe runs stay short
+        if((used + 1) * 2 > slots.size())
+            grow();
+        auto i = slot_of(key);
+        while(slots[i].key != EMPTY && slots[i].key != key)
+            i = (i + 1) & mask;
+        if(slots[i].key == EMPTY)
+            ++used;
+        slots[i] = Slot{key, location};
+    }
+
+    void WindowIndex::erase(xcb_window_t key)
+    {
+        if(key == EMPTY)
+            return;
+        auto i = slot_of(key);
+        while(slots[i].key != key) {
+            if(slots[i].key == EMPTY)
+                return;
+            i = (i + 1) & mask;
+        }
+        // Move entries further down the run back into the hole, if the hole lies between their home slot and where they are now
+        for(auto next = (i + 1) & mask; slots[next].key != EMPTY; next = (next + 1) & mask) {
+            auto home = slot_of(slots[next].key);
+            auto hole_distance = (i - home) & mask;
+            auto next_distance = (next - home) & mask;
+            if(hole_distance < next_distance) {
+                slots[i] = slots[next];
+                i = next;
+            }
+        }
+        slots[i].key = EMPTY;
+        --used;
+    }
+
+    void WindowIndex::grow()
+    {
+        std::vector<Slot> old(slots.size() * 2, Slot{EMPTY, {}});
+        old.swap(slots);
+        mask = slots.size() - 1;
+        used = 0;
+        for(const auto& slot : old) {
+            if(slot.key != EMPTY)
+                insert(slot.key, slot.location);
+        }
+    }
+} // namespace cx::workspace
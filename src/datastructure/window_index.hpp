@@ -0,0 +1,52 @@
+#pragma once
+// System headers
+#include <cstdint>
+#include <vector>
+#include <xcb/xcb.h>
+
+// Library/Application headers
+#include <coreutils/core.hpp>
+
+namespace cx::workspace
+{
+    struct Workspace;
+    struct ContainerTree;
+
+    /// Where a managed window lives. Both the client's & the frame's id lead to the same location
+    struct WindowLocation {
+        xcb_window_t client;
+        xcb_window_t frame;
+        Workspace* workspace;
+        ContainerTree* node;
+    };
+
+    /// Maps client & frame ids to the workspace and tree node holding that window, for every managed window on every workspace.
+    /// Open addressing with linear probing; X ids are handed out sequentially per client, so they are scrambled by a multiplicative hash
+    /// before being used as a slot index. Deletion shifts the rest of the probe run back, so there are no tombstones to skip over.
+    class WindowIndex
+    {
+      public:
+        explicit WindowIndex(std::size_t initial_capacity = 64);
+        /// Inserts the window, or updates where it lives if it's already in the index
+        void assign(xcb_window_t client, xcb_window_t frame, Workspace* workspace, ContainerTree* node);
+        void erase(xcb_window_t client, xcb_window_t frame);
+        /// Looks up xid, which can be either a client or a frame id
+        [[nodiscard]] auto find(xcb_window_t xid) const -> const WindowLocation*;
+        /// Number of windows (not ids) in the index
+        [[nodiscard]] auto size() const -> std::size_t;
+
+      private:
+        struct Slot {
+            xcb_window_t key;
+            WindowLocation location;
+        };
+        [[nodiscard]] auto slot_of(xcb_window_t xid) const -> std::size_t;
+        void insert(xcb_window_t key, const WindowLocation& location);
+        void erase(xcb_window_t key);
+        void grow();
+
+        std::vector<Slot> slots;
+        std::size_t mask;
+        std::size_t used = 0;
+    };
+} // namespace cx::workspace
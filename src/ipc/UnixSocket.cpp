@@ -3,33 +3,42 @@
 //
 
 #include "UnixSocket.h"
+#include "command_parser.hpp"
 
+#include <cerrno>
+#include <cstring>
 #include <unistd.h>
 #include <utility>
 namespace cx::ipc
 {
     void UnixSocket::handle_incoming_connection()
     {
-        sockaddr_un client_addr{};
-        socklen_t client_addr_len = sizeof(client_addr);
-        epoll_event event{};
-        cx::println("EPOLLET {} - EPOLLIN {}", EPOLLET, EPOLLIN);
-        event.events = EPOLLIN | EPOLLRDHUP;
-        if(auto ipc_client_fd = accept(server_fds.listening, (sockaddr*)&client_addr, &client_addr_len); ipc_client_fd == -1) {
-            cx::println("failed to accept client.");
-        } else {
-            if(!make_socket_non_blocking(ipc_client_fd)) {
-                cx::println("Failed to make socket for incoming client non-blocking. File descriptor: {}", ipc_client_fd);
+        // Edge triggered; we won't hear about the listening socket again until every pending connection has been accepted
+        for(;;) {
+            sockaddr_un client_addr{};
+            socklen_t client_addr_len = sizeof(client_addr);
+            auto ipc_client_fd = accept4(server_fds.listening, (sockaddr*)&client_addr, &client_addr_len, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if(ipc_client_fd == -1) {
+                if(errno == EINTR)
+                    continue;
+                if(errno != EAGAIN && errno != EWOULDBLOCK)
+                    cx::println("failed to accept client. Error: {}", std::strerror(errno));
+                return;
+            }
+            epoll_event event{};
+            event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+            event.data.fd = ipc_client_fd;
+            auto buffer = RingBuffer::create(CLIENT_BUFFER_SIZE);
+            if(!buffer) {
+                cx::println("Failed to set up read buffer for client. File descriptor: {}", ipc_client_fd);
+                close(ipc_client_fd);
+            } else if(epoll_ctl(server_fds.epoll, EPOLL_CTL_ADD, ipc_client_fd, &event) != 0) {
+                cx::println("Failed to add client socket to watch list for EPOLL");
                 close(ipc_client_fd);
             } else {
-                event.data.fd = ipc_client_fd;
-                if(epoll_ctl(server_fds.epoll, EPOLL_CTL_ADD, ipc_client_fd, &event) != 0) {
-                    cx::println("Failed to add client socket to watch list for EPOLL");
-                    close(ipc_client_fd);
-                } else {
-                    connected_clients.emplace(ipc_client_fd, std::make_unique<IPCClient>(ipc_client_fd, client_addr, client_addr_len));
-                    cx::println("Successfully connected to client. If it has a path it is: {}", client_addr.sun_path);
-                }
+                connected_clients.emplace(ipc_client_fd,
+                                          std::make_unique<IPCClient>(ipc_client_fd, client_addr, client_addr_len, std::move(*buffer)));
+                DBGLOG("Successfully connected to client. If it has a path it is: {}", client_addr.sun_path);
             }
         }
     }
@@ -51,13 +60,13 @@ namespace cx::ipc
 
         return IPCReadResult(std::nullopt);
     }
-    bool UnixSocket::has_request() const { return IPCInterface::has_request(); }
-    auto UnixSocket::initialize(const fs::path& socket_path, std::size_t max_connections, int epoll_fd) -> std::unique_ptr<UnixSocket>
+    bool UnixSocket::has_request() const { return !ready_clients.empty(); }
+    auto UnixSocket::bind_listening_socket(const fs::path& socket_path, std::size_t max_connections) -> std::pair<int, sockaddr_un>
     {
         std::string_view path_view{socket_path.c_str()};
         auto path_len = path_view.size();
         sockaddr_un unix_socket{};
-        auto listening_fd = socket(AF_LOCAL, SOCK_STREAM | SOCK_NONBLOCK, 0);
+        auto listening_fd = socket(AF_LOCAL, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
         if(listening_fd < 0)
             std::perror("failed to create accepting socket");
         unix_socket.sun_family = AF_UNIX;
@@ -74,9 +83,13 @@ namespace cx::ipc
             cx::println("Successfully bound socket to address: {}", unix_socket.sun_path);
         }
         listen(listening_fd, max_connections);
-
+        return {listening_fd, unix_socket};
+    }
+    auto UnixSocket::initialize(const fs::path& socket_path, std::size_t max_connections, int epoll_fd) -> std::unique_ptr<UnixSocket>
+    {
+        auto [listening_fd, unix_socket] = bind_listening_socket(socket_path, max_connections);
         epoll_event event{};
-        event.events = EPOLLIN;
+        event.events = EPOLLIN | EPOLLET;
         event.data.fd = listening_fd;
         if(epoll_ctl(epoll_fd, EPOLL_CTL_ADD, listening_fd, &event) != 0) {
             cx::println("Failed to install listening socket to EPOLL service");
@@ -87,103 +100,233 @@ namespace cx::ipc
     }
 
     UnixSocket::UnixSocket(fs::path socket_path, sockaddr_un addr, IPCFileDescriptors file_descriptors, std::size_t max_connections)
-        : IPCInterface(std::move(socket_path), file_descriptors), socket_address(addr), max_conns(max_connections), connected_clients{}
+        : IPCInterface(std::move(socket_path), file_descriptors), socket_address(addr), max_conns(max_connections), connected_clients{}, ready_clients{}, pending_output{},
+          subscribers{}
     {
     }
-    void UnixSocket::poll_event() {}
+    void UnixSocket::poll_event()
+    {
+        // Draining may put clients right back on the list, if they still haven't run dry
+        auto clients = std::exchange(ready_clients, {});
+        for(auto fd : clients) {
+            if(auto client = connected_clients.find(fd); client != connected_clients.end())
+                drain(*client->second);
+        }
+    }
     bool UnixSocket::is_connection_request(int fd) { return IPCInterface::is_connection_request(fd); }
-    void UnixSocket::read_from_input(std::optional<int> file_descriptor) {
+    void UnixSocket::read_from_input(std::optional<int> file_descriptor)
+    {
         auto fd = file_descriptor.value();
-        if(connected_clients.contains(fd)) {
-            std::byte max_buf[2048];
-            auto& client = connected_clients.at(fd);
-            auto bytes_read = read(fd, max_buf, 2048);
-            if(bytes_read > 0) {
-                std::array<unsigned char, 2048> buf{};
-                std::memcpy(buf.data(), max_buf, bytes_read);
-                cx::println("Read {} bytes", bytes_read);
-                std::copy(max_buf, max_buf + bytes_read, std::begin(client->read_buffer) + client->current_data);
-                client->current_data += bytes_read;
-                client->process_read_buffer();
-                if(!client->read_messages.empty()) {
-                    cx::println("Processed {} messages. Outputting...:", client->read_messages.size());
-                    for(const auto& msg : client->read_messages) cx::println("{}", msg);
-                    client->read_messages.clear();
-                }
-            } else {
-                auto socket_is_ok =
-                    [](int fd) {
-                      int ret;
-                      int code;
-                      socklen_t len = sizeof(int);
-                      ret = getsockopt(fd, SOL_SOCKET, SO_ERROR, &code, &len);
-                      return ret == 0 && code == 0;
-                    };
-                if(!socket_is_ok(fd)) {
-                    cx::println("DROPPIGN CLIENT!!!!!!!");
-                    drop_client(fd);
-                }
-                // TODO: We must handle when the client closes the connection by inspecting our file descriptor for errors, otherwise
-                //  when the client closes it's side, we will infinitely and continously get events for reads - therefore we must destroy it's
-                //  association with the epoll file-descriptor most likely by some call to epoll_ctl(epfd, CTL_DEL, fd....) or something to that degree
-            }
+        if(auto client = connected_clients.find(fd); client != connected_clients.end()) {
+            drain(*client->second);
         } else {
             cx::println("We have no registered client by that file descriptor!");
         }
     }
-    auto UnixSocket::inspect_for_message(std::array<std::byte, 2048> array, size_t data) -> std::optional<std::string> {
-        return extract_payload(array, data);
+    void UnixSocket::drain(IPCClient& client)
+    {
+        const auto fd = client.socket_fd;
+        std::size_t budget = READ_BUDGET;
+        while(budget > 0) {
+            fit_buffer(client);
+            auto space = client.input.writable();
+            auto bytes_read = read(fd, space.data(), std::min(space.size(), budget));
+            if(bytes_read > 0) {
+                client.input.commit(static_cast<std::size_t>(bytes_read));
+                client.parser.parse(client.input, [this, &client](const Frame& frame) { handle_frame(client, frame); });
+                budget -= static_cast<std::size_t>(bytes_read);
+            } else if(bytes_read == -1 && errno == EINTR) {
+                continue;
+            } else if(bytes_read == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                // Drained. epoll tells us when there's more
+                return;
+            } else {
+                // 0 means the client hung up, after everything it sent has been read. Anything else, the socket is broken
+                DBGLOG("Client {} disconnected", fd);
+                drop_client(fd);
+                return;
+            }
+        }
+        // Out of budget, with data possibly left. Being edge triggered, epoll won't tell us about it again, so it's up to us to come back
+        if(std::find(ready_clients.begin(), ready_clients.end(), fd) == ready_clients.end())
+            ready_clients.push_back(fd);
     }
     UnixSocket::~UnixSocket() {
         close(this->server_fds.listening);
         unlink(path.c_str());
     }
-    void UnixSocket::drop_client(int fd) {
-        if(connected_clients.contains(fd)) {
-            connected_clients.erase(fd);
+    void UnixSocket::fit_buffer(IPCClient& client)
+    {
+        const auto needed = client.parser.bytes_needed();
+        const auto capacity = client.input.capacity();
+        const auto grow = needed > capacity;
+        const auto shrink = capacity > CLIENT_BUFFER_SIZE && client.input.size() == 0;
+        if(!grow && !shrink)
+            return;
+        auto buffer = RingBuffer::create(grow ? needed : CLIENT_BUFFER_SIZE);
+        if(!buffer) {
+            // The frame never completes; the client will get dropped, once it's filled up the buffer it's got
+            cx::println("Failed to make room for a {} byte frame from client {}", needed, client.socket_fd);
+            return;
         }
+        auto pending = client.input.readable();
+        auto space = buffer->writable();
+        std::memcpy(space.data(), pending.data(), pending.size());
+        buffer->commit(pending.size());
+        client.input = std::move(*buffer);
     }
-
-    IPCClient::IPCClient(int fd, sockaddr_un client_address, socklen_t addr_len)
-        : socket_fd(fd), address(client_address), addr_len(addr_len), current_data(0), read_buffer(), read_messages{}
-    {
-    }
-    void IPCClient::process_read_buffer() {
-        std::vector<std::string> payloads{};
-        std::string_view strViewBuf{(const char*)read_buffer.data(), this->current_data};
-        std::vector<std::pair<std::size_t, std::size_t>> messages_ranges{};
-        auto sub_range_start_pos = 0;
-        auto sub_range_len = PACKAGE_END.size();
-        auto range_start = 0;
-        while((sub_range_start_pos+sub_range_len) <= strViewBuf.size()) {
-            if(strViewBuf.substr(sub_range_start_pos, sub_range_len) == PACKAGE_END) {
-                messages_ranges.emplace_back(range_start, sub_range_start_pos+sub_range_len);
-                sub_range_start_pos += sub_range_len;
-                range_start = sub_range_start_pos;
+    void UnixSocket::handle_frame(IPCClient& client, const Frame& frame)
+    {
+        client.protocol_version = frame.version;
+        if(frame.version == 1) {
+            auto response = handle_message(client, frame.body);
+            // v1 gets no replies, except to "snapshot", as the file descriptor has to come with something, & to what has something to say
+            const auto passing = std::exchange(pass_snapshot, false);
+            const auto body = passing ? command_type_names[static_cast<std::size_t>(CommandTypes::Snapshot)] : response.body;
+            if(body.empty())
+                return;
+            std::string reply(FIXED_FIELDS_SIZE + body.size(), '\0');
+            encode_into(body, std::as_writable_bytes(std::span{reply}));
+            queue_reply(client, reply, passing ? snapshot_fd : -1);
+            return;
+        }
+        Batch reply{MessageType::Reply, frame.request_id};
+        std::string text;
+        RecordReader records{frame.body};
+        for(auto record = records.next(); record; record = records.next()) {
+            auto response = frame.type == MessageType::Typed ? handle_typed(client, *record) : handle_message(client, *record);
+            if(response.ok && response.body.empty()) {
+                reply.add("ok");
+            } else if(response.ok) {
+                text.assign("ok ").append(response.body);
+                reply.add(text);
             } else {
-                sub_range_start_pos++;
+                text.assign("error ").append(response.error).append(": '").append(response.token).append("'");
+                reply.add(text);
             }
         }
-        if(messages_ranges[messages_ranges.size()-1].second == current_data) {
-            current_data = 0;
+        if(records.malformed() || reply.count() != frame.count)
+            reply.add("error Malformed frame: record count or lengths don't add up");
+        queue_reply(client, reply.frame(), std::exchange(pass_snapshot, false) ? snapshot_fd : -1);
+    }
+    auto UnixSocket::handle_message(IPCClient& client, std::string_view payload) -> Response
+    {
+        if(!payload.starts_with(command_type_names[static_cast<std::size_t>(CommandTypes::Subscribe)]) &&
+           !payload.starts_with(command_type_names[static_cast<std::size_t>(CommandTypes::Snapshot)]))
+            return message_handler(client.socket_fd, payload);
+        auto result = parse_command(payload);
+        if(auto subscription = std::get_if<Subscription>(&result)) {
+            subscribe(client, subscription->events);
+            return Response{};
         }
-
-        std::array<std::byte, 2048> tmp_buf{};
-        for(const auto& [begin, end] : messages_ranges) {
-            auto length = end - begin;
-            // DBGLOG("Message range [{}..{}]. Length: {}", begin, end, length);
-            std::copy(read_buffer.begin() + begin, read_buffer.begin() + end, tmp_buf.begin());
-            // DBGLOG("tmpOutput: {}", std::string{std::string_view{(const char*)tmp_buf.data(), length}});
-            auto possible_payload = extract_payload(tmp_buf, length);
-            if(possible_payload) {
-                payloads.push_back(possible_payload.value());
+        if(std::holds_alternative<SnapshotRequest>(result)) {
+            if(snapshot_fd == -1)
+                return Response{false, "No snapshot is being published", payload};
+            pass_snapshot = true;
+            return Response{};
+        }
+        auto error = std::get<ParseError>(result);
+        cx::println("IPC client {}: {}: '{}'", client.socket_fd, error.message, error.token);
+        return Response{false, error.message, error.token};
+    }
+    auto UnixSocket::handle_typed(IPCClient& client, std::string_view record) -> Response
+    {
+        auto result = decode_command(record);
+        if(auto error = std::get_if<ParseError>(&result))
+            return Response{false, error->message, {}};
+        return command_handler(client.socket_fd, std::get<Command>(result));
+    }
+    void UnixSocket::queue_reply(IPCClient& client, std::string_view frame, int fd)
+    {
+        const auto was_empty = client.output.empty();
+        if(!client.output.push_reply(std::make_shared<const std::string>(frame), fd)) {
+            // Can't drop it from in here; we're in the middle of parsing its buffer. Once shut down, the next read sees it hung up
+            DBGLOG("Client {} isn't reading its replies. Hanging up on it", client.socket_fd);
+            shutdown(client.socket_fd, SHUT_RDWR);
+            return;
+        }
+        // Replies go out with the next flush, i.e. once what was asked for has been committed
+        if(was_empty)
+            pending_output.push_back(client.socket_fd);
+    }
+    void UnixSocket::subscribe(IPCClient& client, u32 events)
+    {
+        for(auto type = 0U; type < subscribers.size(); ++type) {
+            const auto bit = 1U << type;
+            if((client.subscriptions & bit) && !(events & bit))
+                --subscribers[type];
+            else if(!(client.subscriptions & bit) && (events & bit))
+                ++subscribers[type];
+        }
+        client.subscriptions = events;
+    }
+    void UnixSocket::share_snapshot(int fd) { snapshot_fd = fd; }
+    auto UnixSocket::has_subscribers(EventType type) const -> bool { return subscribers[static_cast<std::size_t>(type)] > 0; }
+    void UnixSocket::publish(EventType type, std::string_view payload)
+    {
+        if(!has_subscribers(type))
+            return;
+        // Encoded at most once per protocol version, however many subscribers there are
+        std::shared_ptr<const std::string> v1_frame;
+        std::shared_ptr<const std::string> v2_frame;
+        const auto encoded = [&](std::uint8_t version) -> const std::shared_ptr<const std::string>& {
+            if(version == 1) {
+                if(!v1_frame) {
+                    auto v1_payload = payload.substr(0, MAX_PAYLOAD_LENGTH);
+                    std::string frame(FIXED_FIELDS_SIZE + v1_payload.size(), '\0');
+                    encode_into(v1_payload, std::as_writable_bytes(std::span{frame}));
+                    v1_frame = std::make_shared<const std::string>(std::move(frame));
+                }
+                return v1_frame;
+            }
+            if(!v2_frame) {
+                Batch event{MessageType::Event, 0};
+                event.add(payload);
+                v2_frame = std::make_shared<const std::string>(event.frame());
+            }
+            return v2_frame;
+        };
+        const auto subject = event_subject(type, payload);
+        const auto bit = 1U << static_cast<u32>(type);
+        for(auto& [fd, client] : connected_clients) {
+            if(client->subscriptions & bit) {
+                // A client with a non-empty queue is either waiting to be flushed already, or waiting for EPOLLOUT
+                if(client->output.empty())
+                    pending_output.push_back(fd);
+                client->output.push(type, subject, encoded(client->protocol_version));
+            }
+        }
+    }
+    void UnixSocket::flush_output()
+    {
+        // A failed write drops the client, which takes it off the list
+        auto clients = std::exchange(pending_output, {});
+        for(auto fd : clients)
+            write_to_output(fd);
+    }
+    void UnixSocket::write_to_output(int fd)
+    {
+        if(auto client = connected_clients.find(fd); client != connected_clients.end()) {
+            if(client->second->output.write_to(fd) == WriteStatus::Failed) {
+                DBGLOG("Writing to client {} failed. Dropping it", fd);
+                drop_client(fd);
             }
         }
-        if(!payloads.empty()) {
-            std::copy(payloads.begin(), payloads.end(), std::back_inserter(read_messages));
-            cx::println("Processed {} messages", payloads.size());
+    }
+    void UnixSocket::drop_client(int fd) {
+        if(auto client = connected_clients.find(fd); client != connected_clients.end()) {
+            subscribe(*client->second, 0);
+            connected_clients.erase(client);
+            std::erase(ready_clients, fd);
+            std::erase(pending_output, fd);
         }
     }
+
+    IPCClient::IPCClient(int fd, sockaddr_un client_address, socklen_t addr_len, RingBuffer buffer)
+        : socket_fd(fd), address(client_address), addr_len(addr_len), input(std::move(buffer)), parser{},
+          subscriptions(0), output(OUTPUT_QUEUE_SIZE), protocol_version(1)
+    {
+    }
     IPCClient::~IPCClient() {
         close(socket_fd);
     }
@@ -3,7 +3,10 @@
 //
 #pragma once
 #include <fcntl.h>
+#include <ipc/frame_parser.hpp>
 #include <ipc/ipc.hpp>
+#include <ipc/output_queue.hpp>
+#include <ipc/ring_buffer.hpp>
 #include <map>
 #include <sys/epoll.h>
 #include <sys/socket.h>
@@ -29,17 +32,31 @@ namespace cx::ipc
         return true;
     };
 
-    /// Holds file descriptors for sockets, internal buffer for reply / received messages
+    /// Room for a few maximum sized messages, so a client can have more than one in flight
+    constexpr auto CLIENT_BUFFER_SIZE = 4 * MAX_MESSAGE_SIZE;
+
+    /// Most a client gets read in one go. Whoever sends more than that, gets the rest read on the next loop iteration, so that a chatty
+    /// client can't keep us from getting to X events
+    constexpr std::size_t READ_BUDGET = 16 * MAX_MESSAGE_SIZE;
+
+    /// Events a subscriber can fall behind by, before they start getting coalesced
+    constexpr std::size_t OUTPUT_QUEUE_SIZE = 256;
+
+    /// Holds file descriptors for sockets, internal buffer for received messages & the queue of events going out
     struct IPCClient {
-        IPCClient(int fd, sockaddr_un client_address, socklen_t addr_len);
+        IPCClient(int fd, sockaddr_un client_address, socklen_t addr_len, RingBuffer buffer);
         ~IPCClient();
-        void process_read_buffer();
         int socket_fd;
         sockaddr_un address;
         socklen_t addr_len;
-        std::size_t current_data;
-        std::array<std::byte, 2048> read_buffer;
-        std::vector<std::string> read_messages;
+        /// read(2) writes into this directly; messages are framed & handed out from it, in place
+        RingBuffer input;
+        FrameParser parser;
+        /// Bit n set, means subscribed to EventType n
+        u32 subscriptions;
+        OutputQueue output;
+        /// The protocol version of the last frame the client sent. Events go out to it in that version too
+        std::uint8_t protocol_version;
     };
 
     class UnixSocket : public IPCInterface
@@ -56,18 +73,49 @@ namespace cx::ipc
         /// Since this function polls, it also just calls epoll_wait with a maximum events of 1
         [[nodiscard]] IPCReadResult poll_queue() override;
         void handle_incoming_connection() override;
+        /// True while there are clients that ran out of read budget before they ran out of data
         [[nodiscard]] bool has_request() const override;
+        /// Continues reading from the clients has_request() is about
         void poll_event() override;
         static auto initialize(const fs::path& socket_path, std::size_t max_connections, int epoll_fd) -> std::unique_ptr<UnixSocket>;
         bool is_connection_request(int fd) override;
         void read_from_input(std::optional<int> file_descriptor) override;
         void drop_client(int fd) override ;
-      private:
+        void write_to_output(int fd) override;
+        [[nodiscard]] auto has_subscribers(EventType type) const -> bool override;
+        /// Encodes the frame once; every subscriber's queue shares it
+        void publish(EventType type, std::string_view payload) override;
+        void flush_output() override;
+        void share_snapshot(int fd) override;
+      protected:
+        /// The socket clients connect to, bound to socket_path & listening. Aborts if it can't be
+        static auto bind_listening_socket(const fs::path& socket_path, std::size_t max_connections) -> std::pair<int, sockaddr_un>;
         /// C-interface data. the filesystem::path in base class IPCInterface is for our convenience
         sockaddr_un socket_address;
         /// Contains Epoll file descriptor & listening fd, which listens for incoming *connections* to accept for. Data is _not_ transferred via these
         std::size_t max_conns;
         std::map<int, std::unique_ptr<IPCClient>> connected_clients;
-        auto inspect_for_message(std::array<std::byte, 2048> array, size_t data) -> std::optional<std::string>;
+        /// Clients that ran out of read budget before running out of data
+        std::vector<int> ready_clients;
+        /// Clients that have been published to since the last flush
+        std::vector<int> pending_output;
+        /// Number of clients subscribed to each EventType
+        std::array<std::size_t, static_cast<std::size_t>(EventType::Count)> subscribers;
+        int snapshot_fd = -1;
+        /// The frame being handled asked for the snapshot; its reply carries snapshot_fd
+        bool pass_snapshot = false;
+        /// Reads what client has sent, until the socket would block or the budget runs out, and hands out every message that completes
+        void drain(IPCClient& client);
+        /// Gives the buffer room for the frame the parser is waiting on, or lets go of the room a large frame needed, once it's gone
+        void fit_buffer(IPCClient& client);
+        /// Handles every command in frame. A v2 frame gets one reply, with a record for each of them
+        void handle_frame(IPCClient& client, const Frame& frame);
+        /// Subscriptions & snapshot requests are taken care of here; everything else goes to the message handler
+        auto handle_message(IPCClient& client, std::string_view payload) -> Response;
+        /// A schema message, from a typed frame
+        auto handle_typed(IPCClient& client, std::string_view record) -> Response;
+        /// fd, if there is one, goes out along with the frame
+        void queue_reply(IPCClient& client, std::string_view frame, int fd = -1);
+        void subscribe(IPCClient& client, u32 events);
     };
 } // namespace cx::ipc
@@ -0,0 +1,387 @@
+#include "UringSocket.h"
+
+#include <cerrno>
+#include <cstring>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+namespace cx::ipc
+{
+    /// The buffer group multishot receives pick their buffers from
+    constexpr std::uint16_t RECV_BUFFER_GROUP = 0;
+
+    namespace
+    {
+        /// Which operation completed, and for which file descriptor, is all a completion has to tell us
+        template<typename Op>
+        auto tag(Op op, int fd) -> std::uint64_t
+        {
+            return static_cast<std::uint64_t>(op) << 32 | static_cast<std::uint32_t>(fd);
+        }
+    } // namespace
+
+    auto UringSocket::initialize(const fs::path& socket_path, std::size_t max_connections, int epoll_fd) -> std::unique_ptr<UringSocket>
+    {
+        auto ring = Uring::create(URING_ENTRIES);
+        if(!ring) {
+            cx::println("Failed to set up io_uring: {}", std::strerror(errno));
+            return nullptr;
+        }
+        if(!ring->setup_buffer_ring(RECV_BUFFER_GROUP, RECV_BUFFER_COUNT, RECV_BUFFER_SIZE)) {
+            cx::println("Failed to register receive buffers with io_uring: {}", std::strerror(errno));
+            return nullptr;
+        }
+        auto event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if(event_fd == -1 || !ring->register_eventfd(event_fd)) {
+            cx::println("Failed to set up eventfd for io_uring: {}", std::strerror(errno));
+            if(event_fd != -1)
+                close(event_fd);
+            return nullptr;
+        }
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = event_fd;
+        if(epoll_ctl(epoll_fd, EPOLL_CTL_ADD, event_fd, &event) != 0) {
+            cx::println("Failed to install io_uring eventfd to EPOLL service");
+            close(event_fd);
+            return nullptr;
+        }
+        auto [listening_fd, unix_socket] = bind_listening_socket(socket_path, max_connections);
+        // The ring does the waiting. Given a non-blocking socket it won't; it hands back EAGAIN instead
+        fcntl(listening_fd, F_SETFL, fcntl(listening_fd, F_GETFL, 0) & ~O_NONBLOCK);
+        auto uring_socket = std::make_unique<UringSocket>(socket_path, unix_socket, IPCFileDescriptors{epoll_fd, listening_fd}, max_connections,
+                                                          std::move(*ring), event_fd);
+        uring_socket->arm_accept();
+        uring_socket->submit_and_reap();
+        return uring_socket;
+    }
+
+    UringSocket::UringSocket(fs::path socket_path, sockaddr_un addr, IPCFileDescriptors file_descriptors, std::size_t max_connections,
+                             Uring uring, int eventfd)
+        : UnixSocket(std::move(socket_path), addr, file_descriptors, max_connections), ring(std::move(uring)), event_fd(eventfd), in_flight{},
+          closing{}
+    {
+    }
+
+    UringSocket::~UringSocket() { close(event_fd); }
+
+    bool UringSocket::is_connection_request(int) { return false; }
+
+    void UringSocket::handle_incoming_connection() {}
+
+    bool UringSocket::has_request() const
+    {
+        return ring.queued() > 0 || ring.has_completions() || ring.overflowed() || held_buffers > 0 || !pending_output.empty();
+    }
+
+    void UringSocket::poll_event() { submit_and_reap(); }
+
+    void UringSocket::read_from_input(std::optional<int> file_descriptor)
+    {
+        if(file_descriptor != event_fd) {
+            cx::println("We have no registered client by that file descriptor!");
+            return;
+        }
+        // Left for the next flush to clear, along with the signals of whatever it submits
+        signalled = true;
+        submit_and_reap();
+    }
+
+    void UringSocket::flush_output()
+    {
+        for(auto fd : std::exchange(pending_output, {})) {
+            if(auto client = connected_clients.find(fd); client != connected_clients.end())
+                arm_send(*client->second);
+        }
+        // Every completion signals the eventfd, the ones reaped right after submitting too. Clearing it here, after the fact, saves waking
+        // up to nothing. Whatever completes after it's been read, signals it again; whatever completed before, has_request() is about
+        if(submit_and_reap() > 0 || signalled) {
+            signalled = false;
+            eventfd_t completions = 0;
+            eventfd_read(event_fd, &completions);
+        }
+        // Sends re-armed by what was just reaped. Left queued, they'd wait on a wakeup that only they would cause
+        if(ring.queued() > 0)
+            ring.submit();
+        // The replies to what was read this time around are on their way; clients get a new read budget
+        ++round;
+    }
+
+    void UringSocket::write_to_output(int fd)
+    {
+        if(auto client = connected_clients.find(fd); client != connected_clients.end()) {
+            arm_send(*client->second);
+            submit_and_reap();
+        }
+    }
+
+    void UringSocket::drop_client(int fd)
+    {
+        auto client = connected_clients.find(fd);
+        if(client == connected_clients.end())
+            return;
+        subscribe(*client->second, 0);
+        std::erase(ready_clients, fd);
+        std::erase(pending_output, fd);
+        auto& state = in_flight[fd];
+        for(auto [buffer_id, length] : state.held)
+            ring.recycle_buffer(buffer_id);
+        held_buffers -= state.held.size();
+        state.held.clear();
+        if(state.operations == 0) {
+            in_flight.erase(fd);
+            connected_clients.erase(client);
+            return;
+        }
+        // Shutting it down ends the receive & fails the send still in flight; the socket is closed once they've said so
+        shutdown(fd, SHUT_RDWR);
+        closing.emplace(fd, std::move(client->second));
+        connected_clients.erase(client);
+    }
+
+    void UringSocket::arm_accept()
+    {
+        auto sqe = ring.get_sqe();
+        if(!sqe) {
+            cx::println("io_uring submission queue is full; can't accept connections");
+            return;
+        }
+        sqe->opcode = IORING_OP_ACCEPT;
+        sqe->fd = server_fds.listening;
+        sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+        sqe->accept_flags = SOCK_CLOEXEC;
+        sqe->user_data = tag(Op::Accept, server_fds.listening);
+        accepting = true;
+    }
+
+    void UringSocket::arm_recv(int fd)
+    {
+        auto sqe = ring.get_sqe();
+        if(!sqe) {
+            cx::println("io_uring submission queue is full; dropping client {}", fd);
+            drop_client(fd);
+            return;
+        }
+        sqe->opcode = IORING_OP_RECV;
+        sqe->fd = fd;
+        sqe->flags = IOSQE_BUFFER_SELECT;
+        sqe->buf_group = RECV_BUFFER_GROUP;
+        sqe->ioprio = IORING_RECV_MULTISHOT;
+        sqe->user_data = tag(Op::Recv, fd);
+        ++in_flight[fd].operations;
+    }
+
+    void UringSocket::arm_send(IPCClient& client)
+    {
+        const auto fd = client.socket_fd;
+        auto& state = in_flight[fd];
+        // One send at a time per client; whatever is queued meanwhile goes out when it completes
+        if(state.sending || client.output.empty())
+            return;
+        auto sqe = ring.get_sqe();
+        if(!sqe) {
+            pending_output.push_back(fd);
+            return;
+        }
+        state.message = msghdr{};
+        state.message.msg_iov = state.iovecs.data();
+        state.message.msg_iovlen = client.output.gather(state.iovecs);
+        attach_fd(state.message, state.passed, client.output.gathered_fd());
+        sqe->opcode = IORING_OP_SENDMSG;
+        sqe->fd = fd;
+        sqe->addr = reinterpret_cast<std::uint64_t>(&state.message);
+        sqe->len = 1;
+        sqe->msg_flags = MSG_NOSIGNAL;
+        sqe->user_data = tag(Op::Send, fd);
+        state.sending = true;
+        ++state.operations;
+    }
+
+    auto UringSocket::submit_and_reap() -> unsigned
+    {
+        if(ring.queued() > 0) {
+            if(auto submitted = ring.submit(); submitted < 0)
+                cx::println("io_uring submit failed: {}", std::strerror(-submitted));
+        }
+        if(held_buffers > 0) {
+            std::vector<int> behind;
+            for(const auto& [fd, state] : in_flight) {
+                if(!state.held.empty())
+                    behind.push_back(fd);
+            }
+            for(auto fd : behind)
+                catch_up(fd);
+        }
+        // Every completion is reaped, whatever the budgets; stopping early would leave the sends behind them waiting
+        auto on_cqe = [this](const io_uring_cqe& cqe) {
+            handle_completion(cqe);
+            return true;
+        };
+        auto reaped = ring.reap(on_cqe);
+        if(ring.overflowed()) {
+            ring.flush_overflow();
+            reaped += ring.reap(on_cqe);
+        }
+        return reaped;
+    }
+
+    void UringSocket::handle_completion(const io_uring_cqe& cqe)
+    {
+        const auto fd = static_cast<int>(cqe.user_data & 0xFFFFFFFF);
+        switch(static_cast<Op>(cqe.user_data >> 32)) {
+        case Op::Accept:
+            on_accept(cqe);
+            break;
+        case Op::Recv:
+            on_recv(fd, cqe);
+            break;
+        case Op::Send:
+            on_send(fd, cqe);
+            break;
+        }
+    }
+
+    void UringSocket::on_accept(const io_uring_cqe& cqe)
+    {
+        if(!(cqe.flags & IORING_CQE_F_MORE))
+            accepting = false;
+        if(cqe.res < 0) {
+            cx::println("failed to accept client. Error: {}", std::strerror(-cqe.res));
+            // Not something that goes away by asking again
+            if(cqe.res == -EINVAL || cqe.res == -EBADF)
+                return;
+        } else {
+            auto client_fd = cqe.res;
+            auto buffer = RingBuffer::create(CLIENT_BUFFER_SIZE);
+            if(!buffer) {
+                cx::println("Failed to set up read buffer for client. File descriptor: {}", client_fd);
+                close(client_fd);
+            } else {
+                connected_clients.emplace(client_fd, std::make_unique<IPCClient>(client_fd, sockaddr_un{}, 0, std::move(*buffer)));
+                in_flight.emplace(client_fd, InFlight{});
+                arm_recv(client_fd);
+                DBGLOG("Successfully connected to client {}", client_fd);
+            }
+        }
+        if(!accepting)
+            arm_accept();
+    }
+
+    void UringSocket::on_recv(int fd, const io_uring_cqe& cqe)
+    {
+        auto client = connected_clients.find(fd);
+        const auto connected = client != connected_clients.end();
+        if(cqe.res > 0) {
+            const auto buffer_id = static_cast<std::uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+            if(connected)
+                deliver(fd, buffer_id, static_cast<std::size_t>(cqe.res));
+            else
+                ring.recycle_buffer(buffer_id);
+        } else if(cqe.res == 0 && connected && !in_flight[fd].held.empty()) {
+            // What it sent before hanging up still counts
+            in_flight[fd].hung_up = true;
+        } else if(connected && cqe.res != -ENOBUFS) {
+            // 0 means the client hung up, after everything it sent has been received. Anything else, the socket is broken
+            DBGLOG("Client {} disconnected", fd);
+            drop_client(fd);
+        }
+        if(!(cqe.flags & IORING_CQE_F_MORE)) {
+            // The receive has ended. Out of buffers is the one reason to start over; they've been handed back by now
+            if(connected_clients.contains(fd) && !in_flight[fd].hung_up)
+                arm_recv(fd);
+            retire(fd);
+        }
+    }
+
+    void UringSocket::on_send(int fd, const io_uring_cqe& cqe)
+    {
+        in_flight[fd].sending = false;
+        if(auto client = connected_clients.find(fd); client != connected_clients.end()) {
+            auto& output = client->second->output;
+            if(cqe.res >= 0) {
+                output.advance(static_cast<std::size_t>(cqe.res));
+                // Partly written, or published to while it was being written
+                arm_send(*client->second);
+            } else if(cqe.res == -EINTR || cqe.res == -EAGAIN) {
+                output.advance(0);
+                arm_send(*client->second);
+            } else {
+                output.advance(0);
+                DBGLOG("Writing to client {} failed. Dropping it", fd);
+                drop_client(fd);
+            }
+        }
+        retire(fd);
+    }
+
+    void UringSocket::deliver(int fd, std::uint16_t buffer_id, std::size_t length)
+    {
+        auto& state = in_flight[fd];
+        if(state.round != round) {
+            state.round = round;
+            state.received = 0;
+        }
+        if(!state.held.empty() || state.received >= READ_BUDGET) {
+            state.held.emplace_back(buffer_id, length);
+            ++held_buffers;
+            return;
+        }
+        state.received += length;
+        receive(*connected_clients[fd], ring.buffer(buffer_id, length));
+        ring.recycle_buffer(buffer_id);
+    }
+
+    void UringSocket::catch_up(int fd)
+    {
+        // Looked up every time around; handling a frame can drop the client
+        for(auto state = in_flight.find(fd); state != in_flight.end() && !state->second.held.empty(); state = in_flight.find(fd)) {
+            auto& behind = state->second;
+            if(behind.round != round) {
+                behind.round = round;
+                behind.received = 0;
+            }
+            if(behind.received >= READ_BUDGET)
+                return;
+            auto [buffer_id, length] = behind.held.front();
+            behind.held.pop_front();
+            --held_buffers;
+            behind.received += length;
+            if(auto client = connected_clients.find(fd); client != connected_clients.end())
+                receive(*client->second, ring.buffer(buffer_id, length));
+            ring.recycle_buffer(buffer_id);
+        }
+        if(auto state = in_flight.find(fd); state != in_flight.end() && state->second.hung_up && state->second.held.empty())
+            drop_client(fd);
+    }
+
+    void UringSocket::receive(IPCClient& client, std::span<const std::byte> bytes)
+    {
+        while(!bytes.empty()) {
+            fit_buffer(client);
+            auto space = client.input.writable();
+            if(space.empty()) {
+                cx::println("Client {} sent more than it can be buffered. Dropping it", client.socket_fd);
+                drop_client(client.socket_fd);
+                return;
+            }
+            auto count = std::min(space.size(), bytes.size());
+            std::memcpy(space.data(), bytes.data(), count);
+            client.input.commit(count);
+            client.parser.parse(client.input, [this, &client](const Frame& frame) { handle_frame(client, frame); });
+            bytes = bytes.subspan(count);
+        }
+    }
+
+    void UringSocket::retire(int fd)
+    {
+        auto state = in_flight.find(fd);
+        if(state == in_flight.end() || --state->second.operations > 0)
+            return;
+        if(auto client = closing.find(fd); client != closing.end()) {
+            closing.erase(client);
+            in_flight.erase(state);
+        }
+    }
+} // namespace cx::ipc
@@ -0,0 +1,91 @@
+#pragma once
+#include <ipc/UnixSocket.h>
+#include <ipc/uring.hpp>
+
+#include <deque>
+
+namespace cx::ipc
+{
+    /// Provided buffers multishot receives land in. Shared by every client; one is only held on to while its bytes are copied out
+    constexpr std::uint16_t RECV_BUFFER_COUNT = 64;
+    constexpr std::uint32_t RECV_BUFFER_SIZE = 4096;
+    constexpr unsigned URING_ENTRIES = 256;
+
+    /// The same socket, clients & framing as UnixSocket, but the I/O goes through io_uring: one multishot accept for connections, one
+    /// multishot receive per client, and a batch of sends per flush, all submitted with one system call. The ring's eventfd is the only
+    /// thing in epoll; when it's readable, read_from_input reaps everything that completed
+    class UringSocket : public UnixSocket
+    {
+      public:
+        UringSocket(fs::path socket_path, sockaddr_un addr, IPCFileDescriptors file_descriptors, std::size_t max_connections, Uring ring,
+                    int event_fd);
+        ~UringSocket() override;
+        /// Nothing if io_uring, or the parts of it we need, isn't there. Nothing has been bound then, so UnixSocket can take over
+        static auto initialize(const fs::path& socket_path, std::size_t max_connections, int epoll_fd) -> std::unique_ptr<UringSocket>;
+        /// Connections are accepted by the ring; the listening socket never shows up in epoll
+        bool is_connection_request(int fd) override;
+        void handle_incoming_connection() override;
+        /// True while there's something to submit, completions to reap, held buffers to handle, or output to send. One round of each is
+        /// done per call, so clients that keep sending can't keep us from getting to X events
+        [[nodiscard]] bool has_request() const override;
+        /// Submits & reaps again, handling held buffers first if their clients have budget left
+        void poll_event() override;
+        /// file_descriptor is the ring's eventfd; reaps what completed. The eventfd is left for flush_output() to clear, which
+        /// Manager::commit calls before going back to epoll_wait
+        void read_from_input(std::optional<int> file_descriptor) override;
+        void drop_client(int fd) override;
+        void write_to_output(int fd) override;
+        /// Queues a send for every client with something to go out, and submits them together
+        void flush_output() override;
+
+      private:
+        enum class Op : std::uint8_t { Accept = 1, Recv, Send };
+        /// What the ring is doing for one client. A client that's been dropped is kept around until it's at 0 operations, so that
+        /// nothing completes into a client that's gone, or into a new client that got its file descriptor
+        struct InFlight {
+            unsigned operations = 0;
+            bool sending = false;
+            /// Received past its read budget: buffers left for the next round. Until then they can't be received into again, which is
+            /// what slows the client down
+            std::deque<std::pair<std::uint16_t, std::size_t>> held{};
+            /// Bytes handled in round
+            std::size_t received = 0;
+            unsigned round = 0;
+            /// Hung up with buffers still held; dropped once they've been handled
+            bool hung_up = false;
+            msghdr message{};
+            PassedFd passed{};
+            /// Room for the whole queue. Unlike UnixSocket, which writes until the socket is full, there's one send per trip through the
+            /// ring; a client that asks faster than that would otherwise run out of queue
+            std::array<iovec, OUTPUT_QUEUE_SIZE> iovecs{};
+        };
+        void arm_accept();
+        void arm_recv(int fd);
+        void arm_send(IPCClient& client);
+        /// Submits what's queued & handles whatever has completed. Returns the number of completions handled
+        auto submit_and_reap() -> unsigned;
+        void handle_completion(const io_uring_cqe& cqe);
+        void on_accept(const io_uring_cqe& cqe);
+        void on_recv(int fd, const io_uring_cqe& cqe);
+        void on_send(int fd, const io_uring_cqe& cqe);
+        /// Handles a received buffer, or holds on to it if fd is past its read budget for this round
+        void deliver(int fd, std::uint16_t buffer_id, std::size_t length);
+        /// Handles buffers held for fd, for as long as its budget lasts
+        void catch_up(int fd);
+        /// Copies what was received into the client's buffer & handles every frame that completes
+        void receive(IPCClient& client, std::span<const std::byte> bytes);
+        /// An operation on fd has completed for good
+        void retire(int fd);
+        Uring ring;
+        int event_fd;
+        std::map<int, InFlight> in_flight;
+        /// Dropped clients, waiting on their operations to finish
+        std::map<int, std::unique_ptr<IPCClient>> closing;
+        bool accepting = false;
+        /// The eventfd has been seen readable, and not read since
+        bool signalled = false;
+        /// Trips through the event loop, i.e. flushes. Each client gets READ_BUDGET per round, like it gets per wakeup on UnixSocket
+        unsigned round = 0;
+        std::size_t held_buffers = 0;
+    };
+} // namespace cx::ipc
@@ -0,0 +1,249 @@
+#include "command_parser.hpp"
+
+#include <cxprotocol/src/schema.h>
+
+#include <X11/keysym.h>
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <optional>
+
+namespace cx::ipc
+{
+    namespace
+    {
+        using Dir = geom::ScreenSpaceDirection;
+
+        /// Hands out whitespace separated tokens, front to back
+        struct Tokens {
+            std::string_view rest;
+            auto next() -> std::string_view
+            {
+                auto begin = rest.find_first_not_of(" \t\r\n");
+                if(begin == std::string_view::npos) {
+                    rest = {};
+                    return {};
+                }
+                rest.remove_prefix(begin);
+                auto token = rest.substr(0, rest.find_first_of(" \t\r\n"));
+                rest.remove_prefix(token.size());
+                return token;
+            }
+            [[nodiscard]] auto empty() const -> bool { return rest.find_first_not_of(" \t\r\n") == std::string_view::npos; }
+        };
+
+        constexpr std::array<std::pair<std::string_view, Dir>, 4> directions{
+            {{"left", Dir::LEFT}, {"right", Dir::RIGHT}, {"up", Dir::UP}, {"down", Dir::DOWN}}};
+
+        constexpr std::array<std::pair<std::string_view, u16>, 5> modifiers{{{"super", XCB_MOD_MASK_4},
+                                                                            {"shift", XCB_MOD_MASK_SHIFT},
+                                                                            {"ctrl", XCB_MOD_MASK_CONTROL},
+                                                                            {"control", XCB_MOD_MASK_CONTROL},
+                                                                            {"alt", XCB_MOD_MASK_1}}};
+
+        /// Keys that aren't a single letter or digit
+        constexpr std::array<std::pair<std::string_view, xcb_keysym_t>, 20> key_names{{{"Left", XK_Left},     {"Right", XK_Right},
+                                                                                      {"Up", XK_Up},         {"Down", XK_Down},
+                                                                                      {"Return", XK_Return}, {"Tab", XK_Tab},
+                                                                                      {"Escape", XK_Escape}, {"space", XK_space},
+                                                                                      {"F1", XK_F1},         {"F2", XK_F2},
+                                                                                      {"F3", XK_F3},         {"F4", XK_F4},
+                                                                                      {"F5", XK_F5},         {"F6", XK_F6},
+                                                                                      {"F7", XK_F7},         {"F8", XK_F8},
+                                                                                      {"F9", XK_F9},         {"F10", XK_F10},
+                                                                                      {"F11", XK_F11},       {"F12", XK_F12}}};
+
+        template<typename Table>
+        constexpr auto lookup(const Table& table, std::string_view name) -> std::optional<typename Table::value_type::second_type>
+        {
+            auto it = std::find_if(table.begin(), table.end(), [name](const auto& entry) { return entry.first == name; });
+            if(it == table.end())
+                return {};
+            return it->second;
+        }
+
+        template<typename Int>
+        auto parse_number(std::string_view token, int base = 10) -> std::optional<Int>
+        {
+            Int value{};
+            auto [end, error] = std::from_chars(token.data(), token.data() + token.size(), value, base);
+            if(error != std::errc{} || end != token.data() + token.size())
+                return {};
+            return value;
+        }
+
+        /// A letter, a digit, one of key_names or the keysym's value in hex
+        auto parse_keysym(std::string_view key) -> std::optional<xcb_keysym_t>
+        {
+            if(key.size() == 1 && std::isalnum(static_cast<unsigned char>(key[0])))
+                // Key presses are looked up without shift, which gives the lower case keysym. Latin-1 keysyms are the characters themselves
+                return static_cast<xcb_keysym_t>(std::tolower(static_cast<unsigned char>(key[0])));
+            if(key.starts_with("0x"))
+                return parse_number<xcb_keysym_t>(key.substr(2), 16);
+            return lookup(key_names, key);
+        }
+
+        auto parse_command(CommandTypes type, Tokens& tokens) -> std::variant<Command, ParseError>
+        {
+            auto name = tokens.next();
+            auto spec = std::find_if(command_table.begin(), command_table.end(),
+                                     [type, name](const auto& spec) { return spec.type == type && spec.name == name; });
+            if(spec == command_table.end())
+                return ParseError{"Unknown command", name};
+
+            Command command{spec->action, events::EventArg{std::nullopt}};
+            switch(spec->argument) {
+            case Argument::Nothing:
+                break;
+            case Argument::Direction: {
+                auto token = tokens.next();
+                auto dir = lookup(directions, token);
+                if(!dir)
+                    return ParseError{"Expected a direction", token};
+                command.arg = events::EventArg{*dir};
+                break;
+            }
+            case Argument::Resize: {
+                auto token = tokens.next();
+                auto dir = lookup(directions, token);
+                if(!dir)
+                    return ParseError{"Expected a direction", token};
+                events::ResizeArgument resize{*dir, 10, spec->action == Action::IncreaseSize ? events::ResizeType::Increase : events::ResizeType::Decrease};
+                if(!tokens.empty()) {
+                    token = tokens.next();
+                    auto step = parse_number<cx::uint>(token);
+                    if(!step)
+                        return ParseError{"Expected a step size", token};
+                    resize.step = *step;
+                }
+                command.arg = events::EventArg{resize};
+                break;
+            }
+            case Argument::Index: {
+                auto token = tokens.next();
+                auto index = parse_number<int>(token);
+                if(!index)
+                    return ParseError{"Expected a number", token};
+                command.arg = events::EventArg{*index};
+                break;
+            }
+            }
+            if(!tokens.empty())
+                return ParseError{"Unexpected trailing input", tokens.rest};
+            return command;
+        }
+
+        auto parse_category(Tokens& tokens) -> std::variant<CommandTypes, ParseError>
+        {
+            auto name = tokens.next();
+            auto it = std::find(command_type_names.begin() + 1, command_type_names.end(), name);
+            if(it == command_type_names.end())
+                return ParseError{"Unknown command type", name};
+            return static_cast<CommandTypes>(it - command_type_names.begin());
+        }
+
+        /// "super+shift+Left"
+        auto parse_key(std::string_view token) -> std::variant<config::KeyConfiguration, ParseError>
+        {
+            u16 modifier = 0;
+            auto key = token;
+            for(auto plus = key.find('+'); plus != std::string_view::npos; plus = key.find('+')) {
+                auto mod = lookup(modifiers, key.substr(0, plus));
+                if(!mod)
+                    return ParseError{"Unknown modifier", key.substr(0, plus)};
+                modifier |= *mod;
+                key.remove_prefix(plus + 1);
+            }
+            auto keysym = parse_keysym(key);
+            if(!keysym)
+                return ParseError{"Unknown key", key};
+            return config::KeyConfiguration{*keysym, modifier};
+        }
+    } // namespace
+
+    auto decode_command(std::string_view record) -> std::variant<Command, ParseError>
+    {
+        using namespace schema;
+        constexpr std::array<Dir, 4> wire_directions{Dir::LEFT, Dir::RIGHT, Dir::UP, Dir::DOWN};
+        std::variant<Command, ParseError> result{ParseError{"Unknown or malformed message", record}};
+        auto direction = [&](schema::Direction direction) -> std::optional<Dir> {
+            if(static_cast<std::size_t>(direction) >= wire_directions.size()) {
+                result = ParseError{"Expected a direction", record};
+                return {};
+            }
+            return wire_directions[static_cast<std::size_t>(direction)];
+        };
+        visit<WindowMove, WindowResize, WorkspaceFocus>(
+            std::as_bytes(std::span{record}),
+            IPCResultVisitor{[&](const WindowMove& move) {
+                                 if(auto dir = direction(move.direction))
+                                     result = Command{Action::MoveFocused, events::EventArg{*dir}};
+                             },
+                             [&](const WindowResize& resize) {
+                                 if(auto dir = direction(resize.direction)) {
+                                     auto type = resize.grow ? events::ResizeType::Increase : events::ResizeType::Decrease;
+                                     result = Command{resize.grow ? Action::IncreaseSize : Action::DecreaseSize,
+                                                      events::EventArg{events::ResizeArgument{*dir, resize.step, type}}};
+                                 }
+                             },
+                             [&](const WorkspaceFocus& focus) {
+                                 result = Command{Action::FocusWorkspace, events::EventArg{static_cast<int>(focus.index)}};
+                             }});
+        return result;
+    }
+
+    auto parse_command(std::string_view payload) -> ParseResult
+    {
+        Tokens tokens{payload};
+        auto category = parse_category(tokens);
+        if(auto error = std::get_if<ParseError>(&category))
+            return *error;
+        auto type = std::get<CommandTypes>(category);
+        if(type == CommandTypes::Subscribe) {
+            u32 events = 0;
+            for(auto name = tokens.next(); !name.empty(); name = tokens.next()) {
+                if(name == "all") {
+                    events = (1U << static_cast<u32>(EventType::Count)) - 1;
+                    continue;
+                }
+                auto it = std::find(event_type_names.begin(), event_type_names.end(), name);
+                if(it == event_type_names.end())
+                    return ParseError{"Unknown event", name};
+                events |= 1U << static_cast<u32>(it - event_type_names.begin());
+            }
+            if(events == 0)
+                return ParseError{"Nothing to subscribe to", payload};
+            return Subscription{events};
+        }
+        if(type == CommandTypes::Snapshot) {
+            if(!tokens.empty())
+                return ParseError{"Unexpected trailing input", tokens.rest};
+            return SnapshotRequest{};
+        }
+        if(type == CommandTypes::Stats) {
+            if(!tokens.empty())
+                return ParseError{"Unexpected trailing input", tokens.rest};
+            return StatsRequest{};
+        }
+        if(type != CommandTypes::BindKey) {
+            auto command = parse_command(type, tokens);
+            if(auto error = std::get_if<ParseError>(&command))
+                return *error;
+            return std::get<Command>(command);
+        }
+
+        auto key = parse_key(tokens.next());
+        if(auto error = std::get_if<ParseError>(&key))
+            return *error;
+        auto bound_category = parse_category(tokens);
+        if(auto error = std::get_if<ParseError>(&bound_category))
+            return *error;
+        if(auto bound = std::get<CommandTypes>(bound_category); bound == CommandTypes::BindKey || bound == CommandTypes::Subscribe ||
+                                                                   bound == CommandTypes::Snapshot || bound == CommandTypes::Stats)
+            return ParseError{"A key can only be bound to a window or workspace command", payload};
+        auto command = parse_command(std::get<CommandTypes>(bound_category), tokens);
+        if(auto error = std::get_if<ParseError>(&command))
+            return *error;
+        return KeyBinding{std::get<config::KeyConfiguration>(key), std::get<Command>(command)};
+    }
+} // namespace cx::ipc
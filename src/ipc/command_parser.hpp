@@ -0,0 +1,104 @@
+#pragma once
+// System headers
+#include <algorithm>
+#include <array>
+#include <string_view>
+#include <variant>
+
+// Library/Application headers
+#include <ipc/ipc.hpp>
+#include <xcom/events.hpp>
+#include <xcom/utility/key_config.hpp>
+
+namespace cx::ipc
+{
+    /// Everything that can be asked of the manager over IPC, or bound to a key
+    enum class Action { RotateLayout, RotatePair, MoveFocused, IncreaseSize, DecreaseSize, KillClient, FocusWorkspace };
+    /// What, if anything, follows the name of an action
+    enum class Argument { Nothing, Direction, Resize, Index };
+
+    struct CommandSpec {
+        CommandTypes type;
+        std::string_view name;
+        Action action;
+        Argument argument;
+    };
+
+    /// Category names, as they're written in a message, indexed by CommandTypes
+    constexpr std::array<std::string_view, static_cast<std::size_t>(CommandTypes::N) + 1> command_type_names{
+        "", "window", "workspace", "bindkey", "subscribe", "snapshot", "stats"};
+    /// Event names, as they're written in a subscribe message, indexed by EventType
+    constexpr std::array<std::string_view, static_cast<std::size_t>(EventType::Count)> event_type_names{"focus", "workspace", "title"};
+
+    /// Every command a message can contain, i.e. "window move left", "window grow right 20" or "workspace focus 2"
+    constexpr std::array command_table{
+        CommandSpec{CommandTypes::Window, "rotate", Action::RotateLayout, Argument::Nothing},
+        CommandSpec{CommandTypes::Window, "swap", Action::RotatePair, Argument::Nothing},
+        CommandSpec{CommandTypes::Window, "move", Action::MoveFocused, Argument::Direction},
+        CommandSpec{CommandTypes::Window, "grow", Action::IncreaseSize, Argument::Resize},
+        CommandSpec{CommandTypes::Window, "shrink", Action::DecreaseSize, Argument::Resize},
+        CommandSpec{CommandTypes::Window, "kill", Action::KillClient, Argument::Nothing},
+        CommandSpec{CommandTypes::Workspace, "focus", Action::FocusWorkspace, Argument::Index},
+    };
+
+    /// The name of action, as it's written in a message
+    constexpr auto action_name(Action action) -> std::string_view
+    {
+        for(const auto& spec : command_table) {
+            if(spec.action == action)
+                return spec.name;
+        }
+        return {};
+    }
+
+    /// Every action has exactly one entry in command_table, so there are as many actions as there are entries
+    constexpr auto ACTION_COUNT = command_table.size();
+    /// Names indexed by Action, i.e. to pick the probe an action is timed under
+    constexpr auto action_names = [] {
+        std::array<std::string_view, ACTION_COUNT> names{};
+        for(std::size_t i = 0; i < ACTION_COUNT; ++i)
+            names[i] = action_name(static_cast<Action>(i));
+        return names;
+    }();
+    static_assert(std::ranges::none_of(action_names, &std::string_view::empty), "Every Action needs an entry in command_table");
+
+    struct Command {
+        Action action;
+        events::EventArg arg;
+    };
+
+    /// "bindkey super+shift+Left window move left" binds the key to the command that follows it
+    struct KeyBinding {
+        config::KeyConfiguration key;
+        Command command;
+    };
+
+    /// "subscribe focus title" or "subscribe all". Replaces whatever the client was subscribed to before
+    struct Subscription {
+        /// Bit n set, means subscribed to EventType n
+        u32 events;
+    };
+
+    /// "snapshot". Asks for the file descriptor of the layout snapshot, which comes with the reply
+    struct SnapshotRequest {
+    };
+
+    /// "stats". Asks for what the event loop has measured: key press latency, events merged &, in instrumented builds, the percentiles of
+    /// every probe
+    struct StatsRequest {
+    };
+
+    struct ParseError {
+        std::string_view message;
+        /// The offending part of the message; points into the payload that was parsed
+        std::string_view token;
+    };
+
+    using ParseResult = std::variant<Command, KeyBinding, Subscription, SnapshotRequest, StatsRequest, ParseError>;
+
+    /// Parses a message payload into a command. Tokens are whitespace separated views into payload; nothing gets allocated
+    auto parse_command(std::string_view payload) -> ParseResult;
+    /// Decodes a record of a typed v2 frame, i.e. one schema message, into a command. No text to tokenize; the fields are read straight off
+    /// their offsets
+    auto decode_command(std::string_view record) -> std::variant<Command, ParseError>;
+} // namespace cx::ipc
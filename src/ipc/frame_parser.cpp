@@ -0,0 +1,69 @@
+#include "frame_parser.hpp"
+
+#include <cxprotocol/src/library.h>
+
+namespace cx::ipc
+{
+    FrameParser::FrameParser() noexcept : needed(HEADER_SIZE) {}
+
+    auto FrameParser::next(std::string_view data) -> Result
+    {
+        if(data.size() < needed)
+            return Result{Step::Incomplete, {}, 0};
+        if(!starts_with_marker(data.data(), HEADER_IDENTIFIER)) {
+            // Out of sync. Skip to the next header; if there's none, keep the tail, as it might be the first half of one
+            auto next_header = find_header(data.substr(1));
+            auto skip = next_header != std::string_view::npos ? next_header + 1 : data.size() - (HEADER_IDENTIFIER.size() - 1);
+            DBGLOG("Skipping {} bytes of IPC garbage", skip);
+            needed = HEADER_SIZE;
+            return Result{Step::Skip, {}, skip};
+        }
+        if(is_v2_frame(data))
+            return next_v2(data);
+        const unsigned char length_field[2]{static_cast<unsigned char>(data[HEADER_IDENTIFIER.size()]),
+                                            static_cast<unsigned char>(data[HEADER_IDENTIFIER.size() + 1])};
+        const std::size_t payload_length = deserialize_payload_length(length_field);
+        if(payload_length > MAX_PAYLOAD_LENGTH) {
+            DBGLOG("IPC frame claims a payload of {} bytes. Skipping it", payload_length);
+            needed = HEADER_SIZE;
+            return Result{Step::Skip, {}, HEADER_IDENTIFIER.size()};
+        }
+        const auto frame_size = HEADER_SIZE + payload_length + PACKAGE_END.size();
+        if(data.size() < frame_size) {
+            // Don't look at this frame again until all of it is here
+            needed = frame_size;
+            return Result{Step::Incomplete, {}, 0};
+        }
+        needed = HEADER_SIZE;
+        if(!starts_with_marker(data.data() + HEADER_SIZE + payload_length, PACKAGE_END)) {
+            DBGLOG("IPC frame of {} bytes has no end marker. Skipping it", frame_size);
+            return Result{Step::Skip, {}, HEADER_IDENTIFIER.size()};
+        }
+        return Result{Step::Frame, Frame{1, MessageType::Request, 0, 1, data.substr(HEADER_SIZE, payload_length)}, frame_size};
+    }
+
+    auto FrameParser::next_v2(std::string_view data) -> Result
+    {
+        if(data.size() < V2_HEADER_SIZE) {
+            needed = V2_HEADER_SIZE;
+            return Result{Step::Incomplete, {}, 0};
+        }
+        needed = HEADER_SIZE;
+        auto header = decode_header(data);
+        if(!header || (header->type != MessageType::Request && header->type != MessageType::Typed)) {
+            DBGLOG("Not a v2 request header. Skipping it", "");
+            return Result{Step::Skip, {}, HEADER_IDENTIFIER.size()};
+        }
+        if(header->length > MAX_FRAME_BODY) {
+            DBGLOG("IPC frame claims a body of {} bytes. Skipping it", header->length);
+            return Result{Step::Skip, {}, HEADER_IDENTIFIER.size()};
+        }
+        const auto frame_size = V2_HEADER_SIZE + header->length;
+        if(data.size() < frame_size) {
+            needed = frame_size;
+            return Result{Step::Incomplete, {}, 0};
+        }
+        const auto body = data.substr(V2_HEADER_SIZE, header->length);
+        return Result{Step::Frame, Frame{PROTOCOL_VERSION, header->type, header->request_id, header->count, body}, frame_size};
+    }
+} // namespace cx::ipc
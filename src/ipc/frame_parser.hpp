@@ -0,0 +1,68 @@
+#pragma once
+// System headers
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// Library/Application headers
+#include <cxprotocol/src/library.h>
+#include <ipc/ring_buffer.hpp>
+
+namespace cx::ipc
+{
+    /// A complete frame, as FrameParser hands it out
+    struct Frame {
+        /// 1 or 2. A v1 frame carries a single command
+        std::uint8_t version;
+        /// Request or Typed; v1 frames are text requests
+        MessageType type;
+        /// Always 0 for v1
+        std::uint32_t request_id;
+        std::uint32_t count;
+        /// v1: the payload. v2: the records, for RecordReader to walk
+        std::string_view body;
+    };
+
+    /// Frames messages straight out of a client's ring buffer; v1 ("cxwm-ipc", payload length, payload, "cxwm-end") and v2 ("cxwm-ipc",
+    /// v2 marker, binary header, records) alike. Frames are found by their length field, so payload bytes are never scanned, and a frame
+    /// that has only partly arrived is not looked at again until enough bytes are in to complete it. Garbage in front of a frame is skipped,
+    /// up to where the next one starts
+    class FrameParser
+    {
+      public:
+        FrameParser() noexcept;
+        /// Calls on_frame(const Frame&) for every complete frame in buffer & consumes it. The frame's body points into the buffer, so it is
+        /// only good for the duration of the call. Returns the number of frames handed out
+        template<typename Fn>
+        auto parse(RingBuffer& buffer, Fn&& on_frame) -> std::size_t
+        {
+            std::size_t frames = 0;
+            for(;;) {
+                auto [step, frame, length] = next(buffer.readable());
+                if(step == Step::Incomplete)
+                    return frames;
+                if(step == Step::Frame) {
+                    on_frame(frame);
+                    ++frames;
+                }
+                buffer.consume(length);
+            }
+        }
+
+        /// Bytes the buffer must hold, before it's worth looking at again. Can be more than a client's buffer holds, for a large v2 frame
+        [[nodiscard]] auto bytes_needed() const -> std::size_t { return needed; }
+
+      private:
+        enum class Step { Incomplete, Frame, Skip };
+        struct Result {
+            Step step;
+            Frame frame;
+            /// Bytes to consume; the whole frame, or the garbage to skip
+            std::size_t length;
+        };
+        auto next(std::string_view data) -> Result;
+        auto next_v2(std::string_view data) -> Result;
+
+        std::size_t needed;
+    };
+} // namespace cx::ipc
@@ -5,6 +5,9 @@
 #include "ipc.hpp"
 /// Derived IPC Mechanisms from base class IPCInterface
 #include "UnixSocket.h"
+#ifdef CX_HAVE_IO_URING
+#include "UringSocket.h"
+#endif
 // ----
 
 #include <coreutils/core.hpp>
@@ -17,6 +20,16 @@ namespace cx::ipc
         return UnixSocket::initialize(p, 10, epoll_fd);
     }
 
+    auto factory::ipc_setup_io_uring(const fs::path& p, int epoll_fd) -> std::unique_ptr<IPCInterface>
+    {
+#ifdef CX_HAVE_IO_URING
+        if(auto socket = UringSocket::initialize(p, 10, epoll_fd))
+            return socket;
+        cx::println("io_uring is not available. Falling back to epoll");
+#endif
+        return ipc_setup_unix_socket(p, epoll_fd);
+    }
+
     IPCMessage::IPCMessage(CommandTypes type, std::string_view client_identifier, std::string_view payload) noexcept
         : type(type), client_name(client_identifier), payload(payload)
     {
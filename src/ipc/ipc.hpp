@@ -5,6 +5,7 @@
 #pragma once
 #include <coreutils/core.hpp>
 #include <filesystem>
+#include <functional>
 #include <optional>
 #include <queue>
 #include <sys/ipc.h>
@@ -25,7 +26,9 @@ namespace cx::ipc
 
     template<typename... Args>
     IPCResultVisitor(Args&&...) -> IPCResultVisitor<Args...>;
-    enum class CommandTypes : long { Window = 1, Workspace = 2, BindKey = 3, N = BindKey };
+    enum class CommandTypes : long { Window = 1, Workspace = 2, BindKey = 3, Subscribe = 4, Snapshot = 5, Stats = 6, N = Stats };
+    /// What subscribers can be told about. Used as bit index in a client's subscription mask
+    enum class EventType : unsigned { Focus, Workspace, Title, Count };
     /// Internal representation. This is is the struct we let Linux write into from the message queue
 
     struct IPCFileDescriptors {
@@ -76,12 +79,34 @@ namespace cx::ipc
         SYS_V_MQ = 1,
         POSIX_MQ = 2,
         POSIX_SOCKET = 3,
+        IO_URING = 4,
     };
 
+    /// What became of a message. One that failed says why, and which part of it was to blame. v2 clients get it back in their reply
+    struct Response {
+        bool ok = true;
+        std::string_view error{};
+        /// Points into the payload it came from
+        std::string_view token{};
+        /// What an ok reply says besides "ok", if anything. Has to stay valid until the next message is handled
+        std::string_view body{};
+    };
+
+    /// Called with the sending client's file descriptor & the payload of each message. The payload points into the client's read buffer and
+    /// is only valid for the duration of the call
+    using MessageHandler = std::function<Response(int client_fd, std::string_view payload)>;
+    /// Defined in command_parser.hpp
+    struct Command;
+    /// Called with each command of a typed frame, already decoded; there's no text to parse
+    using CommandHandler = std::function<Response(int client_fd, const Command& command)>;
+
     class IPCInterface;
     namespace factory
     {
         [[nodiscard]] auto ipc_setup_unix_socket(const fs::path& p, int epoll_fd) -> std::unique_ptr<IPCInterface>;
+        /// The unix socket, with its I/O done by io_uring. Falls back to ipc_setup_unix_socket if io_uring wasn't built in, or the kernel
+        /// doesn't have (enough of) it
+        [[nodiscard]] auto ipc_setup_io_uring(const fs::path& p, int epoll_fd) -> std::unique_ptr<IPCInterface>;
 
     } // namespace factory
 
@@ -98,9 +123,28 @@ namespace cx::ipc
         [[nodiscard]] virtual auto is_connection_request(int fd) -> bool { return fd == server_fds.listening; }
         virtual void handle_incoming_connection() = 0;
         virtual void read_from_input(std::optional<int> file_descriptor) = 0;
-        virtual void drop_client(int fd) {}
+        virtual void drop_client(int) {}
+        /// Called when fd can be written to again, after it's been full
+        virtual void write_to_output(int /*fd*/) {}
+        [[nodiscard]] virtual auto has_subscribers(EventType) const -> bool { return false; }
+        /// Queues payload for every client subscribed to type. Nothing is written until flush_output()
+        virtual void publish(EventType /*type*/, std::string_view /*payload*/) {}
+        /// Writes what's been published since the last flush, as far as each client's socket takes it without blocking
+        virtual void flush_output() {}
+        /// fd is a read-only snapshot of the layout, which clients get a copy of when they ask for it with "snapshot". It stays ours
+        virtual void share_snapshot(int /*fd*/) {}
+        void set_message_handler(MessageHandler handler) { message_handler = std::move(handler); }
+        void set_command_handler(CommandHandler handler) { command_handler = std::move(handler); }
 
       protected:
         IPCFileDescriptors server_fds;
+        MessageHandler message_handler = [](int fd, std::string_view payload) {
+            cx::println("Message from client {}: {}", fd, payload);
+            return Response{};
+        };
+        CommandHandler command_handler = [](int fd, const Command&) {
+            cx::println("Typed command from client {}", fd);
+            return Response{};
+        };
     };
 } // namespace cx::ipc
@@ -0,0 +1,130 @@
+#include "output_queue.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+
+namespace cx::ipc
+{
+    void attach_fd(msghdr& message, PassedFd& room, int fd)
+    {
+        if(fd == -1)
+            return;
+        message.msg_control = room.control.data();
+        message.msg_controllen = room.control.size();
+        auto* header = CMSG_FIRSTHDR(&message);
+        header->cmsg_level = SOL_SOCKET;
+        header->cmsg_type = SCM_RIGHTS;
+        header->cmsg_len = CMSG_LEN(sizeof(int));
+        std::memcpy(CMSG_DATA(header), &fd, sizeof(int));
+    }
+
+    auto event_subject(EventType type, std::string_view payload) -> std::uint32_t
+    {
+        if(type != EventType::Title)
+            return 0;
+        // "title <client id> <tag>"
+        const auto id = payload.substr(std::min(payload.find(' '), payload.size()) + 1);
+        std::uint32_t subject = 0;
+        std::from_chars(id.data(), id.data() + id.size(), subject);
+        return subject;
+    }
+
+    OutputQueue::OutputQueue(std::size_t capacity) noexcept : capacity(std::max<std::size_t>(capacity, 2)) {}
+
+    void OutputQueue::push(EventType type, std::uint32_t subject, std::shared_ptr<const std::string> frame)
+    {
+        if(entries.size() >= capacity && !make_room(type, subject)) {
+            // Nothing but replies queued; this event is the one that has to give
+            ++coalesce_count;
+            return;
+        }
+        entries.push_back(Entry{type, subject, std::move(frame)});
+    }
+
+    auto OutputQueue::push_reply(std::shared_ptr<const std::string> frame, int fd) -> bool
+    {
+        if(entries.size() >= capacity && !make_room(std::nullopt, 0))
+            return false;
+        entries.push_back(Entry{std::nullopt, 0, std::move(frame), fd});
+        return true;
+    }
+
+    auto OutputQueue::make_room(std::optional<EventType> type, std::uint32_t subject) -> bool
+    {
+        // The front might be half written, or still being written; it has to go out as is. Any event behind it can go
+        auto first = entries.begin() + static_cast<long>(std::max<std::size_t>(gathered, written > 0 ? 1 : 0));
+        const auto same = [type, subject](const auto& entry) { return entry.type == type && entry.subject == subject; };
+        auto victim = type ? std::find_if(first, entries.end(), same) : entries.end();
+        if(victim == entries.end())
+            victim = std::find_if(first, entries.end(), [](const auto& entry) { return entry.type.has_value(); });
+        if(victim == entries.end())
+            return false;
+        entries.erase(victim);
+        ++coalesce_count;
+        return true;
+    }
+
+    auto OutputQueue::write_to(int fd) -> WriteStatus
+    {
+        while(!entries.empty()) {
+            std::array<iovec, MAX_IOVECS> iovecs{};
+            // writev, but with MSG_NOSIGNAL; a subscriber that went away must not take us down with SIGPIPE
+            msghdr message{};
+            PassedFd passed{};
+            message.msg_iov = iovecs.data();
+            message.msg_iovlen = gather(iovecs);
+            attach_fd(message, passed, gathered_fd());
+            auto bytes = sendmsg(fd, &message, MSG_NOSIGNAL);
+            if(bytes == -1) {
+                advance(0);
+                if(errno == EINTR)
+                    continue;
+                return errno == EAGAIN || errno == EWOULDBLOCK ? WriteStatus::Blocked : WriteStatus::Failed;
+            }
+            advance(static_cast<std::size_t>(bytes));
+        }
+        return WriteStatus::Done;
+    }
+
+    auto OutputQueue::gather(std::span<iovec> iovecs) -> std::size_t
+    {
+        gathered = std::min(entries.size(), iovecs.size());
+        // Ancillary data goes with the first byte of a write; a file descriptor further in would arrive early
+        for(std::size_t i = 1; i < gathered; ++i) {
+            if(entries[i].fd != -1) {
+                gathered = i;
+                break;
+            }
+        }
+        for(std::size_t i = 0; i < gathered; ++i) {
+            const auto& frame = *entries[i].frame;
+            auto skip = i == 0 ? written : 0;
+            iovecs[i] = iovec{const_cast<char*>(frame.data() + skip), frame.size() - skip};
+        }
+        return gathered;
+    }
+
+    void OutputQueue::advance(std::size_t bytes)
+    {
+        gathered = 0;
+        while(bytes > 0) {
+            auto left_of_front = entries.front().frame->size() - written;
+            if(bytes < left_of_front) {
+                written += bytes;
+                return;
+            }
+            bytes -= left_of_front;
+            written = 0;
+            entries.pop_front();
+        }
+    }
+
+    auto OutputQueue::gathered_fd() const -> int { return gathered > 0 && written == 0 ? entries.front().fd : -1; }
+
+    auto OutputQueue::empty() const -> bool { return entries.empty(); }
+
+    auto OutputQueue::coalesced() const -> std::size_t { return coalesce_count; }
+} // namespace cx::ipc
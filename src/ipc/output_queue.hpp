@@ -0,0 +1,85 @@
+#pragma once
+// System headers
+#include <array>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <sys/socket.h>
+#include <string_view>
+#include <sys/uio.h>
+
+// Library/Application headers
+#include <ipc/ipc.hpp>
+
+namespace cx::ipc
+{
+    /// Most frames gathered into one write
+    constexpr std::size_t MAX_IOVECS = 64;
+
+    /// Room for the one file descriptor a frame can carry, as SCM_RIGHTS
+    struct PassedFd {
+        alignas(cmsghdr) std::array<std::byte, CMSG_SPACE(sizeof(int))> control{};
+    };
+    /// Sends fd along with message, unless it's -1
+    void attach_fd(msghdr& message, PassedFd& room, int fd);
+
+    /// What an event is about, among the events of its type: a title event is about the window whose id it carries. Focus & workspace
+    /// events are about the one focus & the one current workspace there is, so they're all about the same thing, 0
+    auto event_subject(EventType type, std::string_view payload) -> std::uint32_t;
+
+    enum class WriteStatus {
+        /// Everything queued has been written
+        Done,
+        /// The socket is full; EPOLLOUT tells us when to try again
+        Blocked,
+        Failed,
+    };
+
+    /// Frames waiting to go out to one client. Frames are shared between every subscriber they go to, so publishing to many clients
+    /// encodes once. The queue is bounded: when a subscriber falls behind, a newer event replaces the oldest queued one of the same type &
+    /// subject, as it tells the subscriber everything the older one did. If there's none, the oldest event of any kind is dropped; that one
+    /// the subscriber never hears of. Replies to requests are never replaced
+    class OutputQueue
+    {
+      public:
+        explicit OutputQueue(std::size_t capacity) noexcept;
+        void push(EventType type, std::uint32_t subject, std::shared_ptr<const std::string> frame);
+        /// Returns false if the queue is full of nothing but replies; the client isn't reading what it asked for. A reply can carry fd
+        /// (which stays ours; the client gets a copy), sent along with its first byte
+        auto push_reply(std::shared_ptr<const std::string> frame, int fd = -1) -> bool;
+        /// Writes as much of the queue as the socket takes, gathered into one call if it takes it all
+        auto write_to(int fd) -> WriteStatus;
+        /// Points iovecs at the front of the queue, for someone else to write. Returns how many were filled in. Those frames stay queued
+        /// & unreplaced until advance() says how much of them went out, so the write can take its time. Stops short of a frame that
+        /// carries a file descriptor, so that it's the first of the next write
+        auto gather(std::span<iovec> iovecs) -> std::size_t;
+        /// The file descriptor that has to go with what was gathered, or -1
+        [[nodiscard]] auto gathered_fd() const -> int;
+        /// bytes of what was gathered have been written
+        void advance(std::size_t bytes);
+        [[nodiscard]] auto empty() const -> bool;
+        /// Frames that were replaced by (or, if there was nothing of the same type & subject to replace, dropped for) a newer one
+        [[nodiscard]] auto coalesced() const -> std::size_t;
+
+      private:
+        struct Entry {
+            /// Nothing, for a reply
+            std::optional<EventType> type;
+            std::uint32_t subject = 0;
+            std::shared_ptr<const std::string> frame;
+            int fd = -1;
+        };
+        /// Drops a queued event to make room; the oldest one of type & subject if there is one, otherwise the oldest of any type
+        auto make_room(std::optional<EventType> type, std::uint32_t subject) -> bool;
+        std::deque<Entry> entries{};
+        /// Bytes of the front entry that have already been written
+        std::size_t written = 0;
+        /// Entries at the front, handed out by gather()
+        std::size_t gathered = 0;
+        std::size_t capacity;
+        std::size_t coalesce_count = 0;
+    };
+} // namespace cx::ipc
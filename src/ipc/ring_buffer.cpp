@@ -0,0 +1,85 @@
+#include "ring_buffer.hpp"
+
+#include <algorithm>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <utility>
+
+namespace cx::ipc
+{
+    auto RingBuffer::create(std::size_t min_capacity) -> std::optional<RingBuffer>
+    {
+        const auto page_size = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+        const auto capacity = std::max<std::size_t>((min_capacity + page_size - 1) / page_size, 1) * page_size;
+        auto fd = memfd_create("cxwm-ipc-ring", MFD_CLOEXEC);
+        if(fd == -1) {
+            cx::println("Failed to create memory file for IPC buffer");
+            return {};
+        }
+        if(ftruncate(fd, static_cast<off_t>(capacity)) == -1) {
+            cx::println("Failed to size memory file for IPC buffer to {} bytes", capacity);
+            close(fd);
+            return {};
+        }
+        // Reserve room for both views first, so nothing else can end up between them, then put the same pages in both halves
+        auto reserved = mmap(nullptr, capacity * 2, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if(reserved == MAP_FAILED) {
+            cx::println("Failed to reserve address space for IPC buffer");
+            close(fd);
+            return {};
+        }
+        auto base = static_cast<std::byte*>(reserved);
+        auto first = mmap(base, capacity, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0);
+        auto second = mmap(base + capacity, capacity, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0);
+        // The mappings keep the memory alive
+        close(fd);
+        if(first == MAP_FAILED || second == MAP_FAILED) {
+            cx::println("Failed to map IPC buffer");
+            munmap(base, capacity * 2);
+            return {};
+        }
+        return RingBuffer{base, capacity};
+    }
+
+    RingBuffer::RingBuffer(std::byte* mapping, std::size_t capacity) noexcept : base(mapping), cap(capacity) {}
+
+    RingBuffer::RingBuffer(RingBuffer&& other) noexcept
+        : base(std::exchange(other.base, nullptr)), cap(std::exchange(other.cap, 0)), head(std::exchange(other.head, 0)),
+          used(std::exchange(other.used, 0))
+    {
+    }
+
+    RingBuffer& RingBuffer::operator=(RingBuffer&& other) noexcept
+    {
+        std::swap(base, other.base);
+        std::swap(cap, other.cap);
+        std::swap(head, other.head);
+        std::swap(used, other.used);
+        return *this;
+    }
+
+    RingBuffer::~RingBuffer()
+    {
+        if(base)
+            munmap(base, cap * 2);
+    }
+
+    auto RingBuffer::readable() const -> std::string_view { return std::string_view{reinterpret_cast<const char*>(base + head), used}; }
+
+    auto RingBuffer::writable() -> std::span<std::byte> { return std::span<std::byte>{base + head + used, cap - used}; }
+
+    void RingBuffer::commit(std::size_t bytes_written) { used += std::min(bytes_written, cap - used); }
+
+    void RingBuffer::consume(std::size_t bytes_read)
+    {
+        bytes_read = std::min(bytes_read, used);
+        used -= bytes_read;
+        head += bytes_read;
+        if(head >= cap)
+            head -= cap;
+    }
+
+    auto RingBuffer::size() const -> std::size_t { return used; }
+
+    auto RingBuffer::capacity() const -> std::size_t { return cap; }
+} // namespace cx::ipc
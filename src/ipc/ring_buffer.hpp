@@ -0,0 +1,43 @@
+#pragma once
+// System headers
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <string_view>
+
+// Library/Application headers
+#include <coreutils/core.hpp>
+
+namespace cx::ipc
+{
+    /// Byte ring buffer whose storage is mapped twice, back to back, in virtual memory. Whatever is in it & whatever space is free, is
+    /// therefore always one contiguous range, no matter where it wraps: read(2) writes straight into it & readers look at it through a
+    /// string_view, without either one having to care about the wrap around
+    class RingBuffer
+    {
+      public:
+        /// Capacity is rounded up to a whole number of pages. Returns nothing if the kernel won't give us the memory
+        static auto create(std::size_t min_capacity) -> std::optional<RingBuffer>;
+        RingBuffer(RingBuffer&& other) noexcept;
+        RingBuffer& operator=(RingBuffer&& other) noexcept;
+        RingBuffer(const RingBuffer&) = delete;
+        RingBuffer& operator=(const RingBuffer&) = delete;
+        ~RingBuffer();
+
+        /// Everything written, but not yet consumed
+        [[nodiscard]] auto readable() const -> std::string_view;
+        /// Free space, to be written into directly. Tell the buffer how much was written with commit()
+        [[nodiscard]] auto writable() -> std::span<std::byte>;
+        void commit(std::size_t bytes_written);
+        void consume(std::size_t bytes_read);
+        [[nodiscard]] auto size() const -> std::size_t;
+        [[nodiscard]] auto capacity() const -> std::size_t;
+
+      private:
+        RingBuffer(std::byte* mapping, std::size_t capacity) noexcept;
+        std::byte* base;
+        std::size_t cap;
+        std::size_t head = 0;
+        std::size_t used = 0;
+    };
+} // namespace cx::ipc
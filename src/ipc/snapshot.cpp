@@ -0,0 +1,69 @@
+#include "snapshot.hpp"
+
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cxprotocol/src/snapshot.h>
+
+namespace cx::ipc
+{
+    auto SharedSnapshot::create(std::size_t capacity) -> std::unique_ptr<SharedSnapshot>
+    {
+        const auto page_size = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+        const auto size = (sizeof(snapshot::Header) + capacity + page_size - 1) / page_size * page_size;
+        auto fd = memfd_create("cxwm-snapshot", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+        if(fd == -1) {
+            cx::println("Failed to create memory file for the layout snapshot");
+            return nullptr;
+        }
+        if(ftruncate(fd, static_cast<off_t>(size)) == -1) {
+            cx::println("Failed to size memory file for the layout snapshot to {} bytes", size);
+            close(fd);
+            return nullptr;
+        }
+        auto mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if(mapping == MAP_FAILED) {
+            cx::println("Failed to map the layout snapshot");
+            close(fd);
+            return nullptr;
+        }
+        auto* header = static_cast<snapshot::Header*>(mapping);
+        *header = snapshot::Header{snapshot::MAGIC, snapshot::VERSION, 0, 0, static_cast<std::uint32_t>(size - sizeof(snapshot::Header))};
+        // Our mapping stays writable; nobody else gets one, and nobody gets to change the size out from under the readers. Kernels before
+        // 5.1 can't seal off future writes, only all of them; there, a client could write to it, which only ever garbles its own reads
+        constexpr auto seals = F_SEAL_GROW | F_SEAL_SHRINK | F_SEAL_SEAL;
+        if(fcntl(fd, F_ADD_SEALS, seals | F_SEAL_FUTURE_WRITE) == -1 && fcntl(fd, F_ADD_SEALS, seals) == -1) {
+            cx::println("Failed to seal the layout snapshot");
+            munmap(mapping, size);
+            close(fd);
+            return nullptr;
+        }
+        return std::unique_ptr<SharedSnapshot>{new SharedSnapshot{fd, static_cast<std::byte*>(mapping), size}};
+    }
+
+    SharedSnapshot::SharedSnapshot(int fd, std::byte* mapping, std::size_t mapping_size) noexcept
+        : memory_fd(fd), mapping(mapping), mapping_size(mapping_size)
+    {
+    }
+
+    SharedSnapshot::~SharedSnapshot()
+    {
+        munmap(mapping, mapping_size);
+        close(memory_fd);
+    }
+
+    auto SharedSnapshot::fd() const -> int { return memory_fd; }
+
+    auto SharedSnapshot::publish(std::span<const std::byte> body) -> bool
+    {
+        // We're the only writer, so what's mapped can't change while we look. Readers polling the generation don't get woken for nothing
+        const auto* header = reinterpret_cast<const snapshot::Header*>(mapping);
+        if(header->size == body.size() && std::memcmp(mapping + sizeof(snapshot::Header), body.data(), body.size()) == 0)
+            return true;
+        return snapshot::write(mapping, body);
+    }
+
+    auto SharedSnapshot::generation() const -> std::uint64_t { return snapshot::generation(mapping); }
+} // namespace cx::ipc
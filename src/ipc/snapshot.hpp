@@ -0,0 +1,39 @@
+#pragma once
+// System headers
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+
+// Library/Application headers
+#include <coreutils/core.hpp>
+
+namespace cx::ipc
+{
+    /// Room for the layout, after the header. The pages are only there once they've been written to
+    constexpr std::size_t SNAPSHOT_CAPACITY = 1024 * 1024;
+
+    /// The layout, in a sealed memory file that clients map read-only & read whenever they like (see cxprotocol/src/snapshot.h). What's
+    /// published replaces what was there; readers that catch it halfway try again, so the manager never waits on them
+    class SharedSnapshot
+    {
+      public:
+        /// Nothing if the kernel won't give us a memory file, or won't seal it
+        static auto create(std::size_t capacity) -> std::unique_ptr<SharedSnapshot>;
+        SharedSnapshot(const SharedSnapshot&) = delete;
+        SharedSnapshot& operator=(const SharedSnapshot&) = delete;
+        ~SharedSnapshot();
+        /// What clients get a copy of. Whatever they do with it, they can neither write to it, nor resize it
+        [[nodiscard]] auto fd() const -> int;
+        /// Replaces the snapshot with body, unless it's what's already there. Returns false if it doesn't fit
+        auto publish(std::span<const std::byte> body) -> bool;
+        /// How many times something new has been published
+        [[nodiscard]] auto generation() const -> std::uint64_t;
+
+      private:
+        SharedSnapshot(int fd, std::byte* mapping, std::size_t mapping_size) noexcept;
+        int memory_fd;
+        std::byte* mapping;
+        std::size_t mapping_size;
+    };
+} // namespace cx::ipc
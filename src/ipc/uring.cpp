@@ -0,0 +1,186 @@
+#include "uring.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <utility>
+
+namespace cx::ipc
+{
+    namespace
+    {
+        auto as_bytes_at(void* base, unsigned offset) -> std::byte* { return static_cast<std::byte*>(base) + offset; }
+        template<typename T>
+        auto field_at(void* base, unsigned offset) -> T* { return reinterpret_cast<T*>(as_bytes_at(base, offset)); }
+    } // namespace
+
+    auto Uring::create(unsigned entries) -> std::optional<Uring>
+    {
+        io_uring_params params{};
+        params.flags = IORING_SETUP_CQSIZE | IORING_SETUP_SUBMIT_ALL | IORING_SETUP_SINGLE_ISSUER;
+        // Multishot receives post a completion per read, for every client; give them more room than the submissions need
+        params.cq_entries = 4 * entries;
+        auto fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+        if(fd < 0)
+            return {};
+        Uring uring{};
+        uring.ring_fd = fd;
+        if(!(params.features & IORING_FEAT_SINGLE_MMAP))
+            return {};
+        // One mapping for both rings; the completion ring is the larger one, as it holds the entries themselves
+        uring.ring_mapping_size = std::max(params.sq_off.array + params.sq_entries * sizeof(unsigned),
+                                           params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe));
+        uring.ring_mapping = mmap(nullptr, uring.ring_mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+        if(uring.ring_mapping == MAP_FAILED) {
+            uring.ring_mapping = nullptr;
+            return {};
+        }
+        uring.sqe_mapping_size = params.sq_entries * sizeof(io_uring_sqe);
+        uring.sqe_mapping = mmap(nullptr, uring.sqe_mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+        if(uring.sqe_mapping == MAP_FAILED) {
+            uring.sqe_mapping = nullptr;
+            return {};
+        }
+        auto* rings = uring.ring_mapping;
+        uring.sq = SubmissionQueue{field_at<unsigned>(rings, params.sq_off.head),
+                                   field_at<unsigned>(rings, params.sq_off.tail),
+                                   field_at<unsigned>(rings, params.sq_off.ring_mask),
+                                   field_at<unsigned>(rings, params.sq_off.flags),
+                                   field_at<unsigned>(rings, params.sq_off.array),
+                                   static_cast<io_uring_sqe*>(uring.sqe_mapping),
+                                   *field_at<unsigned>(rings, params.sq_off.tail),
+                                   params.sq_entries};
+        uring.cq = CompletionQueue{field_at<unsigned>(rings, params.cq_off.head), field_at<unsigned>(rings, params.cq_off.tail),
+                                   field_at<unsigned>(rings, params.cq_off.ring_mask), field_at<io_uring_cqe>(rings, params.cq_off.cqes)};
+        return uring;
+    }
+
+    Uring::Uring(Uring&& other) noexcept
+        : ring_fd(std::exchange(other.ring_fd, -1)), ring_mapping(std::exchange(other.ring_mapping, nullptr)),
+          ring_mapping_size(other.ring_mapping_size), sqe_mapping(std::exchange(other.sqe_mapping, nullptr)),
+          sqe_mapping_size(other.sqe_mapping_size), sq(other.sq), cq(other.cq), buffers(std::exchange(other.buffers, {}))
+    {
+    }
+
+    Uring& Uring::operator=(Uring&& other) noexcept
+    {
+        if(this != &other) {
+            release();
+            ring_fd = std::exchange(other.ring_fd, -1);
+            ring_mapping = std::exchange(other.ring_mapping, nullptr);
+            ring_mapping_size = other.ring_mapping_size;
+            sqe_mapping = std::exchange(other.sqe_mapping, nullptr);
+            sqe_mapping_size = other.sqe_mapping_size;
+            sq = other.sq;
+            cq = other.cq;
+            buffers = std::exchange(other.buffers, {});
+        }
+        return *this;
+    }
+
+    Uring::~Uring() { release(); }
+
+    void Uring::release() noexcept
+    {
+        // Closing the ring cancels whatever is still in flight, before the buffers it could be receiving into go away
+        if(ring_fd != -1)
+            close(ring_fd);
+        if(buffers.ring)
+            munmap(buffers.ring, buffers.count * sizeof(io_uring_buf));
+        if(buffers.memory)
+            munmap(buffers.memory, static_cast<std::size_t>(buffers.count) * buffers.buffer_size);
+        if(sqe_mapping)
+            munmap(sqe_mapping, sqe_mapping_size);
+        if(ring_mapping)
+            munmap(ring_mapping, ring_mapping_size);
+        ring_fd = -1;
+        ring_mapping = sqe_mapping = nullptr;
+        buffers = {};
+    }
+
+    auto Uring::get_sqe() -> io_uring_sqe*
+    {
+        if(sq.local_tail - __atomic_load_n(sq.head, __ATOMIC_ACQUIRE) >= sq.entries) {
+            if(submit() <= 0)
+                return nullptr;
+            if(sq.local_tail - __atomic_load_n(sq.head, __ATOMIC_ACQUIRE) >= sq.entries)
+                return nullptr;
+        }
+        const auto index = sq.local_tail & *sq.ring_mask;
+        auto* sqe = &sq.sqes[index];
+        std::memset(sqe, 0, sizeof(*sqe));
+        sq.array[index] = index;
+        ++sq.local_tail;
+        return sqe;
+    }
+
+    auto Uring::queued() const -> unsigned { return sq.local_tail - *sq.tail; }
+
+    auto Uring::has_completions() const -> bool { return __atomic_load_n(cq.tail, __ATOMIC_ACQUIRE) != *cq.head; }
+
+    auto Uring::submit() -> int
+    {
+        const auto count = queued();
+        if(count == 0)
+            return 0;
+        __atomic_store_n(sq.tail, sq.local_tail, __ATOMIC_RELEASE);
+        for(;;) {
+            auto submitted = syscall(__NR_io_uring_enter, ring_fd, count, 0, 0, nullptr, 0);
+            if(submitted >= 0)
+                return static_cast<int>(submitted);
+            if(errno != EINTR)
+                return -errno;
+        }
+    }
+
+    auto Uring::overflowed() const -> bool { return __atomic_load_n(sq.flags, __ATOMIC_RELAXED) & IORING_SQ_CQ_OVERFLOW; }
+
+    void Uring::flush_overflow() { syscall(__NR_io_uring_enter, ring_fd, 0, 0, IORING_ENTER_GETEVENTS, nullptr, 0); }
+
+    auto Uring::register_eventfd(int fd) -> bool { return syscall(__NR_io_uring_register, ring_fd, IORING_REGISTER_EVENTFD, &fd, 1) == 0; }
+
+    auto Uring::setup_buffer_ring(std::uint16_t group, std::uint16_t count, std::uint32_t size) -> bool
+    {
+        const auto ring_size = count * sizeof(io_uring_buf);
+        auto* ring = mmap(nullptr, ring_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if(ring == MAP_FAILED)
+            return false;
+        auto* memory = mmap(nullptr, static_cast<std::size_t>(count) * size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if(memory == MAP_FAILED) {
+            munmap(ring, ring_size);
+            return false;
+        }
+        buffers = BufferRing{static_cast<io_uring_buf*>(ring), static_cast<std::byte*>(memory), size, count, 0};
+        io_uring_buf_reg registration{};
+        registration.ring_addr = reinterpret_cast<std::uint64_t>(ring);
+        registration.ring_entries = count;
+        registration.bgid = group;
+        if(syscall(__NR_io_uring_register, ring_fd, IORING_REGISTER_PBUF_RING, &registration, 1) != 0) {
+            munmap(ring, ring_size);
+            munmap(memory, static_cast<std::size_t>(count) * size);
+            buffers = {};
+            return false;
+        }
+        for(std::uint16_t id = 0; id < count; ++id)
+            recycle_buffer(id);
+        return true;
+    }
+
+    auto Uring::buffer(std::uint16_t id, std::size_t length) const -> std::span<const std::byte>
+    {
+        return {buffers.memory + static_cast<std::size_t>(id) * buffers.buffer_size, length};
+    }
+
+    void Uring::recycle_buffer(std::uint16_t id)
+    {
+        auto& entry = buffers.ring[buffers.tail & (buffers.count - 1)];
+        entry.addr = reinterpret_cast<std::uint64_t>(buffers.memory + static_cast<std::size_t>(id) * buffers.buffer_size);
+        entry.len = buffers.buffer_size;
+        entry.bid = id;
+        ++buffers.tail;
+        __atomic_store_n(&buffers.ring[0].resv, buffers.tail, __ATOMIC_RELEASE);
+    }
+} // namespace cx::ipc
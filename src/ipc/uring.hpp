@@ -0,0 +1,104 @@
+#pragma once
+// System headers
+#include <cstddef>
+#include <cstdint>
+#include <linux/io_uring.h>
+#include <optional>
+#include <span>
+
+namespace cx::ipc
+{
+    /// Just enough io_uring for the IPC socket, on the raw system calls: the submission & completion rings, mapped, and a ring of provided
+    /// buffers for multishot receives. Nothing here waits; completions are reaped when the eventfd registered with the ring says there are any
+    class Uring
+    {
+      public:
+        /// Nothing, if the kernel has no io_uring, won't let us use it, or is older than 6.0. The ring is set up single issuer, which
+        /// is what 6.0 added along with multishot receives; a kernel that takes the one has the other
+        static auto create(unsigned entries) -> std::optional<Uring>;
+        Uring(Uring&& other) noexcept;
+        Uring& operator=(Uring&& other) noexcept;
+        Uring(const Uring&) = delete;
+        Uring& operator=(const Uring&) = delete;
+        ~Uring();
+
+        /// A zeroed entry to fill in, or nullptr if the queue is full even after submitting what's already in it
+        auto get_sqe() -> io_uring_sqe*;
+        /// Hands every queued entry to the kernel, in one system call. Returns the number submitted, or -errno
+        auto submit() -> int;
+        /// Entries queued, but not submitted yet
+        [[nodiscard]] auto queued() const -> unsigned;
+        /// True if there's something to reap
+        [[nodiscard]] auto has_completions() const -> bool;
+
+        /// Calls on_cqe(const io_uring_cqe&) for every completion there is, until it returns false; the rest are left for the next reap.
+        /// The completions are only marked as seen after all of them have been handled, so on_cqe may queue new entries, but must not
+        /// reap. Returns the number handled
+        template<typename Fn>
+        auto reap(Fn&& on_cqe) -> unsigned
+        {
+            const auto first = *cq.head;
+            const auto tail = __atomic_load_n(cq.tail, __ATOMIC_ACQUIRE);
+            auto head = first;
+            while(head != tail) {
+                if(!on_cqe(cq.cqes[head++ & *cq.ring_mask]))
+                    break;
+            }
+            __atomic_store_n(cq.head, head, __ATOMIC_RELEASE);
+            return head - first;
+        }
+
+        /// True if completions didn't fit in the ring, and are waiting in the kernel for flush_overflow()
+        [[nodiscard]] auto overflowed() const -> bool;
+        /// Moves completions that didn't fit, into the ring. Reap first, or there's no room for them
+        void flush_overflow();
+
+        /// The kernel signals fd whenever a completion is posted
+        auto register_eventfd(int fd) -> bool;
+        /// Sets up count (a power of two) buffers of size bytes each, as buffer group group, for receives with IOSQE_BUFFER_SELECT
+        auto setup_buffer_ring(std::uint16_t group, std::uint16_t count, std::uint32_t size) -> bool;
+        /// The bytes of a provided buffer, which the kernel has received into
+        [[nodiscard]] auto buffer(std::uint16_t id, std::size_t length) const -> std::span<const std::byte>;
+        /// Hands buffer id back to the kernel, to receive into again
+        void recycle_buffer(std::uint16_t id);
+
+      private:
+        struct SubmissionQueue {
+            unsigned* head;
+            unsigned* tail;
+            unsigned* ring_mask;
+            unsigned* flags;
+            unsigned* array;
+            io_uring_sqe* sqes;
+            unsigned local_tail;
+            unsigned entries;
+        };
+        struct CompletionQueue {
+            unsigned* head;
+            unsigned* tail;
+            unsigned* ring_mask;
+            io_uring_cqe* cqes;
+        };
+        struct BufferRing {
+            /// Not io_uring_buf_ring: compiled as C++, the empty struct in its flexible array takes up room, and bufs ends up 8 bytes in.
+            /// The tail is the resv field of the first entry
+            io_uring_buf* ring = nullptr;
+            std::byte* memory = nullptr;
+            std::uint32_t buffer_size = 0;
+            std::uint16_t count = 0;
+            std::uint16_t tail = 0;
+        };
+
+        Uring() = default;
+        void release() noexcept;
+
+        int ring_fd = -1;
+        void* ring_mapping = nullptr;
+        std::size_t ring_mapping_size = 0;
+        void* sqe_mapping = nullptr;
+        std::size_t sqe_mapping_size = 0;
+        SubmissionQueue sq{};
+        CompletionQueue cq{};
+        BufferRing buffers{};
+    };
+} // namespace cx::ipc
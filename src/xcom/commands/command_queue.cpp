@@ -0,0 +1,30 @@
+#include "command_queue.hpp"
+
+#include <coreutils/instrumentation.hpp>
+
+namespace cx::commands
+{
+    void CommandQueue::push(std::unique_ptr<ManagerCommand> cmd)
+    {
+        // Only the last one; merging past a command in between, would change the order the two get performed in
+        if(!commands.empty() && commands.back()->merge(*cmd)) {
+            ++merge_count;
+            return;
+        }
+        commands.push_back(std::move(cmd));
+    }
+
+    void CommandQueue::perform_all(xcb_connection_t* c, x11::Reconciler& x)
+    {
+        for(const auto& cmd : commands) {
+            DBGLOG("Performing command {}", cmd->command_name());
+            TIMED_SCOPE_DYNAMIC("command", command_type_names, cmd->command_type());
+            cmd->perform(c, x);
+        }
+        commands.clear();
+    }
+
+    auto CommandQueue::empty() const -> bool { return commands.empty(); }
+
+    auto CommandQueue::merged() const -> std::size_t { return merge_count; }
+} // namespace cx::commands
@@ -0,0 +1,30 @@
+#pragma once
+// System headers
+#include <memory>
+#include <vector>
+#include <xcb/xcb.h>
+
+// Library/Application headers
+#include <xcom/commands/manager_command.hpp>
+#include <xcom/utility/reconciler.hpp>
+
+namespace cx::commands
+{
+    /// Commands issued during one iteration of the event loop. They're performed together at the end of it, so that a burst of events
+    /// turns into one set of requests & one flush, instead of a flush (and a visible intermediate state) per command
+    class CommandQueue
+    {
+      public:
+        /// Queues cmd, or folds it into the command queued last, if that one can do what cmd does as well
+        void push(std::unique_ptr<ManagerCommand> cmd);
+        /// Performs every queued command, in the order they were pushed, and empties the queue
+        void perform_all(xcb_connection_t* c, x11::Reconciler& x);
+        [[nodiscard]] auto empty() const -> bool;
+        /// Number of commands that were folded into another one, instead of being queued
+        [[nodiscard]] auto merged() const -> std::size_t;
+
+      private:
+        std::vector<std::unique_ptr<ManagerCommand>> commands{};
+        std::size_t merge_count = 0;
+    };
+} // namespace cx::commands
@@ -4,6 +4,7 @@
 
 #pragma once
 #include <algorithm>
+#include <array>
 #include <coreutils/core.hpp>
 #include <stack>
 #include <tuple>
@@ -12,7 +13,9 @@
 #include <vector>
 #include <xcb/xcb.h>
 #include <xcom/events.hpp>
+#include <xcom/utility/error_tracker.hpp>
 #include <xcom/utility/key_config.hpp>
+#include <xcom/utility/reconciler.hpp>
 #include <xcom/window.hpp>
 /// Forward declarations... oh how absolutely bat shit horrendous C++ is in this regard
 
@@ -31,16 +34,35 @@ namespace cx::commands
 {
     namespace ws = cx::workspace;
 
+    /// One per command class, i.e. for timing each under a probe of its own
+    enum class CommandType : std::size_t {
+        FocusWindow,
+        ChangeWorkspace,
+        ConfigureWindows,
+        KillClient,
+        KillClientsByTag,
+        MoveWindow,
+        UpdateWindows,
+        Count
+    };
+    /// Indexed by CommandType
+    constexpr std::array<std::string_view, static_cast<std::size_t>(CommandType::Count)> command_type_names{
+        "Focus Window", "Change Workspace", "Configure Windows", "Kill client", "Kill clients by tag", "Move Window", "Display update windows"};
+
     class ManagerCommand
     {
       public:
-        ManagerCommand(std::string_view command_name) : cmd_name(command_name) {}
+        ManagerCommand(CommandType type, std::string_view command_name) : cmd_type(type), cmd_name(command_name) {}
         virtual ~ManagerCommand() = default;
+        [[nodiscard]] CommandType command_type() const { return cmd_type; }
         [[nodiscard]] std::string_view command_name() const { return cmd_name; }
-        virtual void perform(xcb_connection_t* c) const = 0;
+        virtual void perform(xcb_connection_t* c, x11::Reconciler& x) const = 0;
         virtual void request_state(Manager* m) = 0;
+        /// Makes this command also do what later does, if it can. Called on the last queued command, with the one being queued after it
+        virtual bool merge(const ManagerCommand&) { return false; }
 
       protected:
+        CommandType cmd_type;
         std::string_view cmd_name;
     };
 
@@ -50,7 +72,9 @@ namespace cx::commands
         ws::Window window; /// The window which the command is to be acted on (i.e. the focused window)
 
       public:
-        explicit WindowCommand(ws::Window win, std::string_view cmd_name) noexcept : ManagerCommand(cmd_name), window(std::move(win)) {}
+        WindowCommand(ws::Window win, CommandType type, std::string_view cmd_name) noexcept : ManagerCommand(type, cmd_name), window(std::move(win))
+        {
+        }
         virtual ~WindowCommand() noexcept = default;
     };
 
@@ -58,19 +82,20 @@ namespace cx::commands
     {
       public:
         FocusWindow(ws::Window activated_window) noexcept
-            : WindowCommand(std::move(activated_window), "Focus Window"), defocused_window{}, acol(0), icol(0)
+            : WindowCommand(std::move(activated_window), CommandType::FocusWindow, "Focus Window"), defocused_windows{}, acol(0), icol(0)
         {
         }
         ~FocusWindow() noexcept override = default;
-        /// x_windows is populated by whatever can accept a command, so the command is defined, but what it should operate on is passed in as
-        /// parameter
-        void perform(xcb_connection_t* c) const override;
+        /// Colors the borders of the focused & de-focused frames and puts the focused one on top
+        void perform(xcb_connection_t* c, x11::Reconciler& x) const override;
         void request_state(Manager* m) override;
         void set_defocused(ws::Window w);
+        /// Focusing A, then B, is focusing B with A (and whatever A took focus from) de-focused
+        bool merge(const ManagerCommand& later) override;
 
       private:
+        std::vector<ws::Window> defocused_windows;
         /// Activated/focused color and inactivated color
-        std::optional<ws::Window> defocused_window;
         int acol, icol;
     };
 
@@ -78,7 +103,7 @@ namespace cx::commands
     {
       public:
         ~ChangeWorkspace() override = default;
-        void perform(xcb_connection_t* c) const override;
+        void perform(xcb_connection_t* c, x11::Reconciler& x) const override;
 
       private:
         std::size_t from_workspace, to_workspace;
@@ -87,13 +112,16 @@ namespace cx::commands
     class ConfigureWindows : public WindowCommand
     {
       public:
-        explicit ConfigureWindows(ws::Window window) noexcept : WindowCommand(std::move(window), "Configure Window (1)"), existing_window{} {}
+        explicit ConfigureWindows(ws::Window window) noexcept
+            : WindowCommand(std::move(window), CommandType::ConfigureWindows, "Configure Window (1)"), existing_window{}
+        {
+        }
         ConfigureWindows(ws::Window existing, ws::Window new_window) noexcept
-            : WindowCommand(std::move(new_window), "Configure Windows (2)"), existing_window(existing)
+            : WindowCommand(std::move(new_window), CommandType::ConfigureWindows, "Configure Windows (2)"), existing_window(existing)
         {
         }
         ~ConfigureWindows() override = default;
-        void perform(xcb_connection_t* c) const override;
+        void perform(xcb_connection_t* c, x11::Reconciler& x) const override;
         void request_state(Manager* m) override;
 
       private:
@@ -103,9 +131,9 @@ namespace cx::commands
     class KillClient : public WindowCommand
     {
       public:
-        explicit KillClient(ws::Window w) noexcept : WindowCommand{std::move(w), "Kill client"} {}
+        explicit KillClient(ws::Window w) noexcept : WindowCommand{std::move(w), CommandType::KillClient, "Kill client"} {}
         ~KillClient() override = default;
-        void perform(xcb_connection_t* c) const override;
+        void perform(xcb_connection_t* c, x11::Reconciler& x) const override;
 
       private:
     };
@@ -113,9 +141,9 @@ namespace cx::commands
     class KillClientsByTag : public ManagerCommand
     {
       public:
-        explicit KillClientsByTag(std::string tag) noexcept : ManagerCommand{"Kill clients by tag"} {}
+        explicit KillClientsByTag(std::string tag) noexcept : ManagerCommand{CommandType::KillClientsByTag, "Kill clients by tag"} {}
         ~KillClientsByTag() override = default;
-        void perform(xcb_connection_t* c) const override;
+        void perform(xcb_connection_t* c, x11::Reconciler& x) const override;
 
       private:
     };
@@ -124,11 +152,11 @@ namespace cx::commands
     {
       public:
         MoveWindow(ws::Window focused_window, geom::ScreenSpaceDirection dir, ws::Workspace* ws)
-            : WindowCommand(std::move(focused_window), "Move Window"), direction(dir), workspace{ws}
+            : WindowCommand(std::move(focused_window), CommandType::MoveWindow, "Move Window"), direction(dir), workspace{ws}
         {
         }
         ~MoveWindow() override = default;
-        void perform(xcb_connection_t* c) const override;
+        void perform(xcb_connection_t* c, x11::Reconciler& x) const override;
         void request_state(Manager* m) override;
 
       private:
@@ -140,13 +168,15 @@ namespace cx::commands
     {
       public:
         explicit UpdateWindows(std::vector<ws::Window> windows_update) noexcept
-            : ManagerCommand("Display update windows"), windows{std::move(windows_update)}
+            : ManagerCommand(CommandType::UpdateWindows, "Display update windows"), windows{std::move(windows_update)}
         {
         }
         explicit UpdateWindows(const std::vector<ws::ContainerTree*>& nodes) noexcept;
         ~UpdateWindows() override = default;
-        void perform(xcb_connection_t* c) const override;
+        void perform(xcb_connection_t* c, x11::Reconciler& x) const override;
         void request_state(Manager* m) override;
+        /// Takes the windows of a later UpdateWindows; where both have the same window, the later geometry wins
+        bool merge(const ManagerCommand& later) override;
 
       private:
         std::vector<ws::Window> windows;
@@ -31,6 +31,8 @@ namespace cx::events
         EventArg() noexcept = default;
         EventArg(EventArg&&) noexcept = default;
         EventArg(const EventArg&) noexcept = default;
+        EventArg& operator=(EventArg&&) noexcept = default;
+        EventArg& operator=(const EventArg&) noexcept = default;
         explicit EventArg(ArgsTypes arg) noexcept : arg(arg) {}
 
         ArgsTypes arg;
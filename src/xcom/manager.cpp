@@ -8,6 +8,7 @@
 // STD System headers
 #include <algorithm>
 #include <cassert>
+#include <cerrno>
 #include <fcntl.h>
 #include <memory>
 #include <sys/epoll.h>
@@ -29,11 +30,40 @@ namespace cx
 
     auto Manager::setup() -> void
     {
-        // TODO(implement): grab pre-existing windows, reparent them properly and manage them
-        // xcb_grab_server(get_conn());
         setup_root_workspace_container();
+        adopt_existing_windows();
+    }
 
-        // xcb_ungrab_server(get_conn());
+    auto Manager::adopt_existing_windows() -> void
+    {
+        const auto& c = get_conn();
+        // No client gets to map, unmap or destroy windows while we're taking stock of them
+        xcb_grab_server(c);
+        cx::x11::X11Resource tree = xcb_query_tree_reply(c, xcb_query_tree(c, get_root()), nullptr);
+        if(!tree) {
+            cx::println("Could not query the window tree of root. No pre-existing windows adopted");
+            xcb_ungrab_server(c);
+            xcb_flush(c);
+            return;
+        }
+        auto children = xcb_query_tree_children(tree);
+        auto child_count = xcb_query_tree_children_length(tree);
+        // Ask about all of them before waiting on any of them, so that adopting costs a round trip, no matter the number of windows
+        std::vector<x11::ClientQuery> queries;
+        queries.reserve(child_count);
+        for(auto i = 0; i < child_count; ++i) {
+            if(children[i] == x_detail.ewmh_window || children[i] == status_bar->drawable || status_bar->has_child(children[i]))
+                continue;
+            queries.push_back(x11::request_client_properties(c, children[i], x_detail.atoms));
+        }
+        for(const auto& query : queries) {
+            if(auto client = x11::collect_client_properties(c, query, x_detail.atoms); client) {
+                frame_client(*client, true);
+            }
+        }
+        DBGLOG("Adopted {} of {} pre-existing windows", window_index.size(), queries.size());
+        xcb_ungrab_server(c);
+        xcb_flush(c);
     }
 
     auto Manager::setup_root_workspace_container() -> void
@@ -50,7 +80,7 @@ namespace cx
         add_workspace("Workspace 9", 0);
         add_workspace("Workspace 10", 0);
         add_workspace("Workspace 11", 0);
-        this->status_bar = ws::make_system_bar(get_conn(), get_screen(), m_workspaces.size(), geom::Geometry{0, 0, 800, 25}, configuration);
+        this->status_bar = ws::make_system_bar(get_conn(), x_errors, gc_cache, get_screen(), m_workspaces.size(), geom::Geometry{0, 0, 800, 25}, configuration);
         this->focused_ws = m_workspaces[0].get();
     }
 
@@ -90,28 +120,9 @@ namespace cx
         auto ewmh_window = xcb_generate_id(c);
         xcb_create_window(c, XCB_COPY_FROM_PARENT, ewmh_window, window, -1, -1, 1, 1, 0, XCB_WINDOW_CLASS_INPUT_ONLY, XCB_COPY_FROM_PARENT,
                           XCB_CW_OVERRIDE_REDIRECT, (uint32_t[]){1});
-        auto atoms = cx::x11::get_supported_atoms(c, x11::atom_names);
-
-        auto support_check_cookie = xcb_intern_atom(c, 0, name_len("_NET_SUPPORTING_WM_CHECK"), "_NET_SUPPORTING_WM_CHECK");
-        auto wm_name_cookie = xcb_intern_atom(c, 0, name_len("_NET_WM_NAME"), "_NET_WM_NAME");
-
-        cx::x11::X11Resource support_r = xcb_intern_atom_reply(c, support_check_cookie, nullptr);
-        cx::x11::X11Resource wm_name_r = xcb_intern_atom_reply(c, wm_name_cookie, nullptr);
-
-        auto get_atom = [c](auto atom_name) -> xcb_atom_t {
-            auto cookie = xcb_intern_atom(c, 0, strlen(atom_name), atom_name);
-            /* ... do other work here if possible ... */
-            if(cx::x11::X11Resource reply = xcb_intern_atom_reply(c, cookie, nullptr); reply) {
-                DBGLOG("The {} atom has ID {}", atom_name, reply->atom);
-                auto atom = reply->atom;
-                return atom;
-            } else {
-                DBGLOG("Failed to get atom for: {}. In debug mode we crash here.", atom_name);
-                exit(-1);
-            }
-        };
-        auto a_wm = get_atom("_NET_WM_NAME");
-        auto a_supp = get_atom("_NET_SUPPORTING_WM_CHECK");
+        const auto atoms = x11::Atoms::intern(c);
+        const auto a_wm = atoms[x11::Atom::NET_WM_NAME];
+        const auto a_supp = atoms[x11::Atom::NET_SUPPORTING_WM_CHECK];
 
         std::vector<xcb_void_cookie_t> cookies{};
 
@@ -119,9 +130,7 @@ namespace cx
         cookies.push_back(x_replace_str_prop(c, ewmh_window, a_wm, "CXWMAN"));
         cookies.push_back(xcb_change_property_checked(c, XCB_PROP_MODE_REPLACE, window, a_supp, XCB_ATOM_WINDOW, 32, 1, &ewmh_window));
         cookies.push_back(x_replace_str_prop(c, window, a_wm, "CXWMAN"));
-
-        // TODO(implement): Set the supported atoms by calling change prop with _NET_SUPPORTED as the... property, XCB_ATOM_ATOM as the
-        // type, and then the atoms as the data
+        cookies.push_back(atoms.publish_supported(c, window));
         for(const auto& cookie : cookies) {
             if(auto err = xcb_request_check(c, cookie); err) {
                 cx::println("Failed to change property of EWMH Window or Root window");
@@ -138,9 +147,6 @@ namespace cx
         auto symbols = xcb_key_symbols_alloc(c);
         auto xcb_fd = xcb_get_file_descriptor(c);
 
-        epoll_event event{};
-        event.events = EPOLLET | EPOLLIN | EPOLLOUT;
-
         constexpr auto make_socket_non_blocking = [](auto fileDescriptor) {
             auto sock_flags = fcntl(fileDescriptor, F_GETFL);
             if(sock_flags == -1) {
@@ -155,23 +161,37 @@ namespace cx
         };
         make_socket_non_blocking(xcb_fd);
 
-        event.data.fd = xcb_fd;
-        auto xcb_epfd = epoll_create1(0);
-        epoll_ctl(xcb_epfd, EPOLL_CTL_ADD, xcb_fd, &event);
-
-        return std::make_unique<Manager>(c, screen, root_drawable, window, ewmh_window, symbols, xcb_fd,
-                                         ipc::factory::ipc_setup_unix_socket("cxwman_ipc", xcb_epfd), xcb_epfd);
+        auto reactor = Reactor::create();
+        if(!reactor) {
+            xcb_disconnect(c);
+            throw std::runtime_error{"Failed to set up the event loop"};
+        }
+        auto timers = TimerWheel::create(*reactor);
+        if(!timers) {
+            xcb_disconnect(c);
+            throw std::runtime_error{"Failed to set up timers"};
+        }
+        auto messenger = ipc::factory::ipc_setup_io_uring("cxwman_ipc", reactor->fd());
+        return std::make_unique<Manager>(c, screen, root_drawable, window, ewmh_window, symbols, xcb_fd, atoms, std::move(messenger),
+                                         std::move(*reactor), std::move(timers));
     }
 
     // Private constructor called via public interface function Manager::initialize()
     Manager::Manager(x11::XCBConn* connection, x11::XCBScreen* screen, x11::XCBDrawable root_drawable, x11::XCBWindow root_window,
-                     x11::XCBWindow ewmh_window, xcb_key_symbols_t* symbols, int xcb_fd, std::unique_ptr<ipc::IPCInterface> messenger,
-                     int epoll_fd) noexcept
-        : x_detail{connection, screen, root_drawable, root_window, ewmh_window, symbols, xcb_fd},
-          m_running(false), client_to_frame_mapping{}, frame_to_client_mapping{}, focused_ws(nullptr), m_workspaces{}, event_dispatcher{this},
-          status_bar{nullptr}, inactive_windows{1, 0xff0000}, active_windows{1, 0x00ff00}, ipc_interface{std::move(messenger)}, epoll_fd(epoll_fd),
+                     x11::XCBWindow ewmh_window, xcb_key_symbols_t* symbols, int xcb_fd, x11::Atoms atoms,
+                     std::unique_ptr<ipc::IPCInterface> messenger, Reactor reactor, std::unique_ptr<TimerWheel> timer_wheel) noexcept
+        : x_detail{connection, screen, root_drawable, root_window, ewmh_window, symbols, xcb_fd, atoms}, x_errors{}, x_events{},
+          key_latency{}, uncommitted_keys(0), keys_read_at{}, stats_text{}, action_failure{}, gc_cache{connection, root_window, &x_errors},
+          reconciler{connection, &x_errors}, command_queue{}, m_running(false), window_index{}, focused_ws(nullptr), m_workspaces{},
+          event_dispatcher{this}, status_bar{nullptr}, inactive_windows{1, 0xff0000}, active_windows{1, 0x00ff00},
+          ipc_interface{std::move(messenger)},
+          snapshot{ipc::SharedSnapshot::create(ipc::SNAPSHOT_CAPACITY)}, snapshot_builder{}, snapshot_body{}, snapshot_stale(true),
+          reactor(std::move(reactor)), timers(std::move(timer_wheel)),
+          title_updates{*timers, TITLE_DEBOUNCE, [this](std::uint64_t window) { update_title(static_cast<xcb_window_t>(window)); }},
           configuration()
     {
+        if(snapshot)
+            ipc_interface->share_snapshot(snapshot->fd());
     }
 
     [[nodiscard]] inline constexpr auto Manager::get_conn() const -> x11::XCBConn* { return x_detail.c; }
@@ -191,21 +211,21 @@ namespace cx
     auto Manager::handle_unmap_request(xcb_unmap_window_request_t* event) -> void
     {
         DBGLOG("Handle unmap request for {}", event->window);
-        auto window_container = focused_ws->find_window(event->window);
-        if(window_container) {
-            auto window = *window_container.value()->client;
+        if(auto location = window_index.find(event->window); location) {
+            auto workspace = location->workspace;
+            auto window = *location->node->client;
             unframe_window(window, false);
-            focused_ws->unregister_window(*window_container);
-            focused_ws->display_update(get_conn());
+            workspace->unregister_window(location->node);
         }
     }
 
     auto Manager::handle_config_request(xcb_configure_request_event_t* e) -> void
     {
-        xcb_generic_error_t* err;
         uint32_t values[7], mask = 0, i = 0;
-        if(client_to_frame_mapping.count(e->parent) == 1) {
-            xcb_window_t frame = client_to_frame_mapping[e->window];
+        auto on_error = [](auto err) { cx::println("xcb_configure_window(): Error code: {}", err->error_code); };
+        if(auto parent = window_index.find(e->parent); parent && parent->client == e->parent) {
+            auto client = window_index.find(e->window);
+            xcb_window_t frame = client ? client->frame : static_cast<xcb_window_t>(XCB_WINDOW_NONE);
             DBGLOG("Handle cfg for frame {} of client {}", frame, e->window);
             if(e->value_mask & XCB_CONFIG_WINDOW_X) {
                 mask |= XCB_CONFIG_WINDOW_X;
@@ -228,10 +248,8 @@ namespace cx
                 mask |= XCB_CONFIG_WINDOW_BORDER_WIDTH;
                 values[i++] = e->border_width;
             }
-            err = xcb_request_check(get_conn(), xcb_configure_window_checked(get_conn(), frame, mask, values));
-            if(err) {
-                cx::println("xcb_configure_window_checked(): Error code: {}", err->error_code);
-            }
+            x_errors.track(xcb_configure_window(get_conn(), frame, mask, values), on_error);
+            reconciler.invalidate(frame);
         }
         mask = 0;
         i = 0;
@@ -263,9 +281,14 @@ namespace cx
             mask |= XCB_CONFIG_WINDOW_STACK_MODE;
             values[i++] = e->stack_mode;
         }
-        err = xcb_request_check(get_conn(), xcb_configure_window_checked(get_conn(), e->window, mask, values));
-        if(err) {
-            cx::println("xcb_configure_window_checked(): Error code: {}", err->error_code);
+        x_errors.track(xcb_configure_window(get_conn(), e->window, mask, values), on_error);
+        reconciler.invalidate(e->window);
+    }
+
+    auto Manager::handle_x_error(xcb_generic_error_t* error) -> void
+    {
+        if(!x_errors.handle_error(error)) {
+            x11::log_untracked_error(error);
         }
     }
 
@@ -283,24 +306,40 @@ namespace cx
 
     auto Manager::frame_window(x11::XCBWindow window, bool create_before_wm) -> void
     {
-        namespace xkm = xcb_key_masks;
-        std::array<xcb_void_cookie_t, 6> cookies{};
         const auto& c = get_conn();
-        if(client_to_frame_mapping.count(window)) {
+        if(window_index.find(window)) {
             DBGLOG("Framing an already framed window (id: {}) is unhandled behavior. Returning early from framing function.", window);
             return;
         }
+        // Every query goes out before we wait on the first reply, so framing costs one round trip, not one per property
+        auto query = x11::request_client_properties(c, window, x_detail.atoms);
+        if(auto client = x11::collect_client_properties(c, query, x_detail.atoms); client) {
+            frame_client(*client, create_before_wm);
+        }
+    }
 
-        cx::x11::X11Resource win_attr = xcb_get_window_attributes_reply(c, xcb_get_window_attributes(c, window), nullptr);
-        auto client_geometry = process_x_geometry(c, window);
-        DBGLOG("Client geometry: {},{} -- {}x{}", client_geometry->x(), client_geometry->y(), client_geometry->width, client_geometry->height);
+    auto Manager::frame_client(const x11::ClientProperties& client, bool create_before_wm) -> void
+    {
+        namespace xkm = xcb_key_masks;
+        std::array<xcb_void_cookie_t, 4> cookies{};
+        const auto& c = get_conn();
+        const auto window = client.window;
+        const auto& client_geometry = client.geometry;
+        DBGLOG("Client geometry: {},{} -- {}x{}", client_geometry.x(), client_geometry.y(), client_geometry.width, client_geometry.height);
         if(create_before_wm) {
             cx::println("Window was created before WM.");
-            if(win_attr->override_redirect || win_attr->map_state != XCB_MAP_STATE_VIEWABLE) {
-                delete win_attr;
+            if(client.map_state != XCB_MAP_STATE_VIEWABLE) {
                 return;
             }
         }
+        if(!client.wants_frame()) {
+            DBGLOG("Window {} places itself. Not framing it", window);
+            return;
+        }
+        if(!focused_ws) {
+            DBGLOG("No workspace container was created. {}!", "Error");
+            std::abort();
+        }
 
         // construct frame
         auto frame_id = xcb_generate_id(c);
@@ -315,44 +354,48 @@ namespace cx
         values[2] = (cx::u32)XCB_EVENT_MASK_KEY_PRESS | XCB_EVENT_MASK_SUBSTRUCTURE_REDIRECT | XCB_EVENT_MASK_BUTTON_PRESS |
                     XCB_EVENT_MASK_SUBSTRUCTURE_NOTIFY | XCB_EVENT_MASK_ENTER_WINDOW | XCB_EVENT_MASK_LEAVE_WINDOW | XCB_EVENT_MASK_EXPOSURE |
                     XCB_EVENT_MASK_PROPERTY_CHANGE;
-        cookies[0] = xcb_create_window_checked(c, 0, frame_id, get_root(), 0, 0, client_geometry->width, client_geometry->height,
-                                               inactive_windows.border_width, XCB_WINDOW_CLASS_INPUT_OUTPUT, get_screen()->root_visual, mask, values);
-
-        cookies[1] = xcb_reparent_window_checked(c, window, frame_id, 0, configuration.frame_title_height);
-        auto tag = x11::get_client_wm_name(c, window);
-
-        ws::Window win{client_geometry.value_or(geom::Geometry::window_default()), window, frame_id,
-                       ws::Tag{tag.value_or("cxw_" + std::to_string(window)), focused_ws->m_id}, configuration};
-        if(!focused_ws) {
-            DBGLOG("No workspace container was created. {}!", "Error");
-            std::abort();
-        }
+        cookies[0] = xcb_create_window(c, 0, frame_id, get_root(), 0, 0, client_geometry.width, client_geometry.height,
+                                       inactive_windows.border_width, XCB_WINDOW_CLASS_INPUT_OUTPUT, get_screen()->root_visual, mask, values);
+
+        cookies[1] = xcb_reparent_window(c, window, frame_id, 0, configuration.frame_title_height);
+        // Should we go away, the X server puts the client back on root, where the next instance of the WM can adopt it
+        xcb_change_save_set(c, XCB_SET_MODE_INSERT, window);
+
+        ws::Window win{client_geometry, window, frame_id, ws::Tag{client.title(), focused_ws->m_id}, configuration};
+        win.title_gc = gc_cache.acquire(0x000000, (u32)configuration.frame_background_color, "7x13");
+        win.title_metrics = &gc_cache.metrics(win.title_gc);
+        // It may have been unframed earlier in this iteration; what the reconciler is told about it from here on, has to go out
+        reconciler.manage(window);
+        reconciler.manage(frame_id);
         if(auto configure_command = focused_ws->register_window(win); configure_command) {
-            execute(&configure_command.value());
-            cookies[2] = xcb_map_window_checked(c, frame_id);
-            cookies[3] = xcb_map_subwindows_checked(c, frame_id);
-            cookies[5] = xcb_grab_button_checked(c, 1, frame_id, XCB_EVENT_MASK_BUTTON_PRESS, XCB_GRAB_MODE_SYNC, XCB_GRAB_MODE_ASYNC, get_root(),
-                                                 XCB_NONE, XCB_BUTTON_INDEX_1, XCB_MOD_MASK_ANY);
-            process_request(cookies[0], win, [](auto w) { cx::println("Failed to create X window/frame"); });
-            process_request(cookies[1], win, [](auto w) { cx::println("Re-parenting window {} to frame {} failed", w.client_id, w.frame_id); });
-            process_request(cookies[2], win, [](auto w) { cx::println("Failed to map frame {}", w.frame_id); });
-            process_request(cookies[3], win, [](auto w) { cx::println("Failed to map sub-windows of frame {} -> {}", w.frame_id, w.client_id); });
-            process_request(cookies[4], win, [](auto w) { cx::println("Failed button grab on window {}", w.client_id); });
-            process_request(cookies[5], win, [](auto w) { cx::println("Failed button grab on frame {}", w.frame_id); });
+            execute(std::make_unique<commands::ConfigureWindows>(std::move(*configure_command)));
+            // Goes out on commit, after the frame has been put in place
+            reconciler.map(frame_id);
+            cookies[2] = xcb_map_subwindows(c, frame_id);
+            cookies[3] = xcb_grab_button(c, 1, frame_id, XCB_EVENT_MASK_BUTTON_PRESS, XCB_GRAB_MODE_SYNC, XCB_GRAB_MODE_ASYNC, get_root(), XCB_NONE,
+                                         XCB_BUTTON_INDEX_1, XCB_MOD_MASK_ANY);
+            process_request(cookies[0], win, [](auto, auto) { cx::println("Failed to create X window/frame"); });
+            // Most likely the client went away before we got to it. Let go of what we've set up for it
+            process_request(cookies[1], win, [this](auto w, auto) {
+                cx::println("Re-parenting window {} to frame {} failed", w.client_id, w.frame_id);
+                if(auto location = window_index.find(w.client_id); location) {
+                    auto workspace = location->workspace;
+                    unframe_window(w, false);
+                    workspace->unregister_window(location->node);
+                }
+            });
+            process_request(cookies[2], win,
+                            [](auto w, auto) { cx::println("Failed to map sub-windows of frame {} -> {}", w.frame_id, w.client_id); });
+            process_request(cookies[3], win, [](auto w, auto) { cx::println("Failed button grab on frame {}", w.frame_id); });
         } else {
             cx::println("FOUND NO LAYOUT ATTRIBUTES!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!");
+            gc_cache.release(win.title_gc);
         }
 
-        auto font_gc = x11::get_font_gc(c, frame_id, 0x000000, (u32)configuration.frame_background_color, "7x13");
-        auto text_extents_cookie = xcb_query_text_extents(c, font_gc.value(), tag->length(), reinterpret_cast<const xcb_char2b_t*>(tag->c_str()));
-        cx::x11::X11Resource text_extents = xcb_query_text_extents_reply(c, text_extents_cookie, nullptr);
-        auto [x_pos, y_pos] = cx::draw::utils::align_vertical_middle_left_of(text_extents, client_geometry->width, configuration.frame_title_height);
-        xcb_image_text_8(c, tag->length(), frame_id, font_gc.value(), x_pos, y_pos, tag->c_str());
+        // The title gets drawn when the frame is exposed, which it is as soon as it's mapped
         int v[1]{XCB_EVENT_MASK_PROPERTY_CHANGE};
         xcb_change_window_attributes(c, window, XCB_CW_EVENT_MASK, v);
 
-        client_to_frame_mapping[window] = frame_id;
-        frame_to_client_mapping[frame_id] = window;
         // x11::setup_mouse_button_request_handling(c, window);
     }
 
@@ -360,12 +403,14 @@ namespace cx
     {
         xcb_unmap_window(get_conn(), w.frame_id);
         xcb_reparent_window(get_conn(), w.client_id, get_root(), 0, 0);
+        xcb_change_save_set(get_conn(), XCB_SET_MODE_DELETE, w.client_id);
+        title_updates.forget(w.client_id);
+        gc_cache.release(w.title_gc);
+        reconciler.forget(w.frame_id);
+        reconciler.forget(w.client_id);
         xcb_destroy_window(get_conn(), w.frame_id);
         if(destroy_client)
             xcb_destroy_window(get_conn(), w.client_id);
-        xcb_flush(get_conn());
-        client_to_frame_mapping.erase(w.client_id);
-        frame_to_client_mapping.erase(w.frame_id);
     }
 
     // The event loop
@@ -373,69 +418,176 @@ namespace cx
     {
         setup();
         setup_input_functions();
-        this->m_running = true;
+        // Here, rather than the first time someone asks for stats, which would have the loop wait for it
+        if constexpr(instrumentation::enabled)
+            instrumentation::calibrate();
         const auto& c = get_conn();
-        auto xfd = xcb_get_file_descriptor(c);
+        // Level triggered & only for reading. The X socket is writable nearly all of the time, and being told so is nothing but wakeups.
+        // What the read brings in is handled at the top of the loop; all the handler has to look out for, is the server going away
+        reactor.watch(x_detail.xcb_file_descriptor, EPOLLIN, [this](int, u32 events) {
+            if((events & (EPOLLERR | EPOLLHUP)) || xcb_connection_has_error(get_conn())) {
+                cx::println("Lost the connection to the X server");
+                m_running = false;
+            }
+        });
+        // Hang ups are noticed while reading, after whatever the client sent before it left has been read
+        reactor.set_fallback([this](int fd, u32 events) { handle_file_descriptor_event(fd, events); });
+        reactor.handle_signals({SIGINT, SIGTERM, SIGUSR1}, [this](int signal) {
+            if(signal == SIGUSR1) {
+                format_stats();
+                cx::println("{}", stats_text);
+                return;
+            }
+            cx::println("Caught {}. Shutting down", strsignal(signal));
+            m_running = false;
+        });
+        this->m_running = true;
         while(m_running) {
             xcb_allow_events(c, XCB_ALLOW_REPLAY_POINTER, XCB_CURRENT_TIME);
-            auto ev = xcb_poll_for_event(c);
-            if(ev == nullptr) {
-                epoll_event event_list[10];
-                auto event_count = epoll_wait(this->epoll_fd, event_list, 10, -1);
-                if(event_count == -1) {
-                    cx::println("Epoll error. Abort. Abort. Abort");
-                    m_running = false;
-                } else {
-                    for(auto index = 0; index < event_count; index++) {
-                        if(event_list[index].data.fd != xfd) { // we let our poll in the top of the while loop handle it in next iteration
-                            if(event_list[index].events & EPOLLRDHUP) {
-                                ipc_interface->drop_client(event_list[index].data.fd);
-                            } else {
-                                handle_file_descriptor_event(event_list[index].data.fd);
-                            }
-                        }
-                    }
-                }
-            } else {
-                handle_generic_event(ev);
-                delete ev;
+            drain_x_events(xcb_poll_for_event(c));
+            // Everything queued up has been handled; send what it did to the X server, before we go to sleep
+            commit();
+            // xcb reads while it writes, when the server is sending too. Whatever that brought in is off the socket; epoll won't tell us
+            if(auto ev = xcb_poll_for_queued_event(c)) {
+                drain_x_events(ev);
+                continue;
+            }
+            // IPC clients that had more to say than one iteration's budget, are not going to wake us up again; just look & come back. Same
+            // for X events that didn't fit in the event budget
+            if(reactor.run_once(ipc_interface->has_request() || !x_events.empty() ? 0 : -1) == -1) {
+                cx::println("Epoll error. Abort. Abort. Abort");
+                m_running = false;
             }
+            if(ipc_interface->has_request())
+                ipc_interface->poll_event();
         }
+        // Whatever the last iteration did, the X server gets to hear about. The IPC socket is unlinked as the manager goes away
+        commit();
+        format_stats();
+        cx::println("{}", stats_text);
+    }
+
+    auto Manager::drain_x_events(xcb_generic_event_t* first) -> void
+    {
+        if(uncommitted_keys == 0)
+            keys_read_at = std::chrono::steady_clock::now();
+        x_events.drain(get_conn(), first);
+        x_events.dispatch([this](xcb_generic_event_t* ev) { handle_generic_event(ev); }, EVENT_BUDGET);
     }
 
-    auto Manager::handle_file_descriptor_event(int fd) -> void
+    auto Manager::commit() -> void
+    {
+        // Nothing performed & nothing sent means nothing moved; the snapshot stays as it is
+        const auto sent = reconciler.stats().sent;
+        snapshot_stale |= !command_queue.empty();
+        // Commands go first. Some of them (i.e. MoveWindow) change the tree, which the layout has to see
+        command_queue.perform_all(get_conn(), reconciler);
+        for(auto& workspace : m_workspaces) {
+            if(auto changed_windows = workspace->layout(); !changed_windows.empty()) {
+                commands::UpdateWindows update{changed_windows};
+                TIMED_SCOPE_DYNAMIC("command", commands::command_type_names, update.command_type());
+                update.perform(get_conn(), reconciler);
+            }
+        }
+        reconciler.commit();
+        if(uncommitted_keys != 0) {
+            const auto latency = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - keys_read_at);
+            for(; uncommitted_keys != 0; --uncommitted_keys)
+                key_latency.record(static_cast<std::uint64_t>(latency.count()));
+        }
+        if(snapshot && (snapshot_stale || reconciler.stats().sent != sent))
+            publish_snapshot();
+        ipc_interface->flush_output();
+    }
+
+    auto Manager::format_stats() -> void
+    {
+        fmt::memory_buffer out;
+        const auto [received, handled, deferred] = x_events.stats();
+        fmt::format_to(std::back_inserter(out), "x events: {} received, {} handled, {} merged away, {} put off for lack of time\n", received,
+                       handled, received - handled, deferred);
+        const auto [sent, suppressed] = reconciler.stats();
+        fmt::format_to(std::back_inserter(out), "x requests: {} sent, {} suppressed as the server already had that state\n", sent, suppressed);
+        fmt::format_to(std::back_inserter(out), "commands: {} merged into the one queued before\n", command_queue.merged());
+        const auto [hits, misses, live_gcs] = gc_cache.stats();
+        fmt::format_to(std::back_inserter(out), "text gcs: {} hits, {} misses, {} live\n", hits, misses, live_gcs);
+        instrumentation::append_percentiles(out, "latency", "key press to action", key_latency);
+        instrumentation::report(out);
+        // The last line's newline is for whoever prints it, or not
+        stats_text.assign(out.data(), out.size() - 1);
+    }
+
+    auto Manager::publish_snapshot() -> void
+    {
+        snapshot_stale = false;
+        snapshot_builder.clear();
+        for(auto& workspace : m_workspaces) {
+            snapshot_builder.add_workspace(workspace->m_id, workspace->m_name);
+            in_order_window_map(workspace->m_root, [this, id = workspace->m_id](const ws::Window& window) {
+                const auto& g = window.geometry;
+                // add_window fills in where the title is
+                snapshot_builder.add_window(ipc::snapshot::Window{window.client_id, window.frame_id, id, g.pos.x, g.pos.y, g.width, g.height, 0, 0},
+                                            window.m_tag.m_tag);
+            });
+        }
+        if(focused_ws) {
+            const auto& focused = focused_ws->focused().client;
+            snapshot_builder.focus(focused_ws->m_id, focused ? focused->client_id : 0);
+        }
+        snapshot_builder.finish(snapshot_body);
+        if(!snapshot->publish(snapshot_body))
+            cx::println("Layout snapshot of {} bytes doesn't fit in {}; readers keep the last one", snapshot_body.size(), ipc::SNAPSHOT_CAPACITY);
+    }
+
+    auto Manager::handle_file_descriptor_event(int fd, u32 events) -> void
     {
         if(ipc_interface->is_connection_request(fd)) {
             ipc_interface->handle_incoming_connection();
-        } else {
-            ipc_interface->read_from_input(fd);
+            return;
         }
+        if(events & EPOLLOUT)
+            ipc_interface->write_to_output(fd);
+        if(events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))
+            ipc_interface->read_from_input(fd);
     }
 
     auto Manager::handle_generic_event(xcb_generic_event_t* evt) -> void
     {
+        if(evt->response_type == 0) {
+            TIMED_SCOPE("x", "error");
+            handle_x_error((xcb_generic_error_t*)evt);
+            return;
+        }
+        // Everything sent before this event has been processed by the server
+        x_errors.retire(evt->full_sequence);
         switch(evt->response_type /*& ~0x80 = 127 = 0b01111111*/) {
         case XCB_MAP_REQUEST: {
+            TIMED_SCOPE("x", "map request");
             handle_map_request((xcb_map_request_event_t*)(evt));
             break;
         }
         case XCB_MAP_NOTIFY: {
             break;
         }
-        case XCB_UNMAP_NOTIFY:
+        case XCB_UNMAP_NOTIFY: {
+            TIMED_SCOPE("x", "unmap notify");
             handle_unmap_request((xcb_unmap_window_request_t*)evt);
             break;
+        }
         case XCB_CONFIGURE_REQUEST: {
+            TIMED_SCOPE("x", "configure request");
             handle_config_request((xcb_configure_request_event_t*)evt);
             break;
         }
         case XCB_BUTTON_PRESS: {
-
+            TIMED_SCOPE("x", "button press");
             auto e = (xcb_button_press_event_t*)evt;
             auto id = (e->event == x_detail.root_window) ? e->child : e->event;
             if(auto cmd = focused_ws->focus_client_with_xid(id); cmd) {
                 // if we didn't click any client handled by focused_ws, check if we clicked the sys bar
-                execute(&cmd.value());
+                execute(std::make_unique<commands::FocusWindow>(std::move(*cmd)));
+                const auto& focused = focused_window();
+                notify(ipc::EventType::Focus, "focus {} {}", focused.client_id, focused.m_tag.m_tag);
             } else {
                 status_bar->clicked_workspace(id, [this](auto workspace_id) { this->change_workspace(workspace_id); });
             }
@@ -443,9 +595,12 @@ namespace cx
         }
         case XCB_BUTTON_RELEASE:
             break;
-        case XCB_KEY_PRESS:
+        case XCB_KEY_PRESS: {
+            TIMED_SCOPE("x", "key press");
+            ++uncommitted_keys;
             handle_key_press((xcb_key_press_event_t*)evt);
             break;
+        }
         case XCB_MAPPING_NOTIFY: // alerts us if a *key mapping* has been done, NOT a window one
             break;
         case XCB_MOTION_NOTIFY: // We just fall through all these for now, since we don't do anything right now anyway
@@ -457,6 +612,7 @@ namespace cx
         case XCB_KEY_RELEASE: // TODO(implement)? XCB_KEY_RELEASE
             break;
         case XCB_EXPOSE: {
+            TIMED_SCOPE("x", "expose");
             auto e = (xcb_expose_event_t*)evt;
             if(status_bar->has_child(e->window)) {
                 status_bar->draw();
@@ -466,23 +622,34 @@ namespace cx
             break; // TODO(implement) XCB_EXPOSE
         }
         case XCB_PROPERTY_NOTIFY: {
+            TIMED_SCOPE("x", "property notify");
             auto e = (xcb_property_notify_event_t*)evt;
-            if(e->atom == XCB_ATOM_WM_NAME) {
-                auto c = get_conn();
-                focused_ws->find_window_then(e->window, [c](auto& window) { window.draw_title(c, x11::get_client_wm_name(c, window.client_id)); });
-            }
+            if(e->atom == XCB_ATOM_WM_NAME && window_index.find(e->window))
+                title_updates.debounce(e->window);
             break;
         }
         }
     }
 
+    auto Manager::update_title(xcb_window_t xwin) -> void
+    {
+        // Gone by the time the title's due, if it was unmapped in between
+        if(auto location = window_index.find(xwin); location) {
+            auto c = get_conn();
+            auto& window = location->node->client.value();
+            window.draw_title(c, x11::get_client_wm_name(c, window.client_id));
+            notify(ipc::EventType::Title, "title {} {}", window.client_id, window.m_tag.m_tag);
+        }
+    }
+
     auto Manager::add_workspace(const std::string& workspace_tag, std::size_t screen_number) -> void
     {
         auto status_bar_height = 25;
         // FIXME: This has hardcoded screen width by height size, as during testing we know. This OBVIOUSLY has to be fixed so that correct size
         //  settings get passsed
         m_workspaces.emplace_back(
-            std::make_unique<ws::Workspace>(m_workspaces.size(), workspace_tag, geom::Geometry{0, status_bar_height, 800, 600 - status_bar_height}));
+            std::make_unique<ws::Workspace>(m_workspaces.size(), workspace_tag, geom::Geometry{0, status_bar_height, 800, 600 - status_bar_height},
+                                           &window_index));
     }
     auto Manager::setup_input_functions() -> void
     {
@@ -510,88 +677,162 @@ namespace cx
         event_dispatcher.register_action(KC{XK_Up, xkm::SUPER_CTRL}, &Manager::decrease_size_focused, Arg{ResizeArg{Dir::DOWN, 10}});
         event_dispatcher.register_action(KC{XK_Down, xkm::SUPER_CTRL}, &Manager::decrease_size_focused, Arg{ResizeArg{Dir::UP, 10}});
         event_dispatcher.register_action(KC{XK_q, xkm::SUPER_SHIFT}, &Manager::kill_client, Arg{std::nullopt});
+
+        ipc_interface->set_message_handler([this](int client_fd, std::string_view payload) { return handle_ipc_message(client_fd, payload); });
+        ipc_interface->set_command_handler([this](int, const ipc::Command& command) { return run_ipc_command(command); });
+    }
+
+    auto Manager::action_handler(ipc::Action action) -> std::variant<MFP, MFPWA>
+    {
+        using ipc::Action;
+        switch(action) {
+        case Action::RotateLayout:
+            return &Manager::rotate_focused_layout;
+        case Action::RotatePair:
+            return &Manager::rotate_focused_pair;
+        case Action::MoveFocused:
+            return &Manager::move_focused;
+        case Action::IncreaseSize:
+            return &Manager::increase_size_focused;
+        case Action::DecreaseSize:
+            return &Manager::decrease_size_focused;
+        case Action::KillClient:
+            return &Manager::kill_client;
+        case Action::FocusWorkspace:
+            return &Manager::focus_workspace;
+        }
+        // Only an Action cast from outside its range gets here; parse_command never makes one
+        assert(false && "Every ipc::Action needs a member function in action_handler");
+        __builtin_unreachable();
+    }
+
+    auto Manager::run_ipc_command(const ipc::Command& command) -> ipc::Response
+    {
+        TIMED_SCOPE_DYNAMIC("ipc", ipc::action_names, command.action);
+        action_failure = {};
+        std::visit(ipc::IPCResultVisitor{[this](MFP fn) { (this->*fn)(); }, [this, &command](MFPWA fn) { (this->*fn)(command.arg); }},
+                   action_handler(command.action));
+        if(!action_failure.empty())
+            return ipc::Response{false, action_failure, ipc::action_name(command.action)};
+        return ipc::Response{};
+    }
+
+    auto Manager::handle_ipc_message(int client_fd, std::string_view payload) -> ipc::Response
+    {
+        return std::visit(ipc::IPCResultVisitor{
+                              [this](const ipc::Command& command) { return run_ipc_command(command); },
+                              [this](const ipc::KeyBinding& binding) {
+                                  TIMED_SCOPE("ipc", "bindkey");
+                                  x11::grab_key(get_conn(), get_root(), x_detail.keysyms, binding.key.modifier, binding.key.symbol);
+                                  std::visit(ipc::IPCResultVisitor{[this, &binding](MFP fn) { event_dispatcher.register_action(binding.key, fn); },
+                                                                   [this, &binding](MFPWA fn) {
+                                                                       event_dispatcher.register_action(binding.key, fn, binding.command.arg);
+                                                                   }},
+                                             action_handler(binding.command.action));
+                                  return ipc::Response{};
+                              },
+                              // The IPC layer keeps track of subscriptions, they don't get this far
+                              [](const ipc::Subscription&) { return ipc::Response{}; },
+                              [](const ipc::SnapshotRequest&) { return ipc::Response{}; },
+                              [this](const ipc::StatsRequest&) {
+                                  format_stats();
+                                  return ipc::Response{true, {}, {}, stats_text};
+                              },
+                              [client_fd](const ipc::ParseError& error) {
+                                  cx::println("IPC client {}: {}: '{}'", client_fd, error.message, error.token);
+                                  return ipc::Response{false, error.message, error.token};
+                              }},
+                          ipc::parse_command(payload));
     }
 
     // Manager window/client actions
     auto Manager::rotate_focused_layout() -> void
     {
         focused_ws->rotate_focus_layout();
-        focused_ws->display_update(get_conn());
     }
 
     auto Manager::rotate_focused_pair() -> void
     {
         focused_ws->rotate_focus_pair();
-        focused_ws->display_update(get_conn());
     }
     auto Manager::noop() -> void { cx::println("Key combination not yet handled"); }
 
     auto Manager::move_focused(cx::events::EventArg arg) -> void
     {
+        // On an empty workspace the focused container is the root split
+        if(!focused_ws->focused().is_window()) {
+            action_failure = "No focused window";
+            return;
+        }
         auto cmd_arg = std::get<geom::ScreenSpaceDirection>(arg.arg);
-        auto move_command = focused_ws->move_focused(cmd_arg);
-        execute(&move_command);
+        execute(std::make_unique<commands::MoveWindow>(focused_ws->move_focused(cmd_arg)));
     }
     auto Manager::increase_size_focused(cx::events::EventArg arg) -> void
     {
         auto resize_arg = std::get<cx::events::ResizeArgument>(arg.arg);
-        auto cmd = focused_ws->increase_size_focused(resize_arg);
-        execute(&cmd);
+        if(!focused_ws->increase_size_focused(resize_arg)) {
+            DBGLOG("No split to resize in direction of focused window {}", "");
+            action_failure = "No split to resize in that direction";
+        }
     }
     auto Manager::decrease_size_focused(cx::events::EventArg arg) -> void
     {
         auto size_arg = std::get<cx::events::ResizeArgument>(arg.arg);
-        auto cmd = focused_ws->decrease_size_focused(size_arg);
-        execute(&cmd);
+        if(!focused_ws->decrease_size_focused(size_arg)) {
+            DBGLOG("No split to resize in direction of focused window {}", "");
+            action_failure = "No split to resize in that direction";
+        }
     }
 
-    auto Manager::change_workspace(std::size_t ws_id) -> void
+    auto Manager::change_workspace(std::size_t ws_id) -> bool
     {
-        if(ws_id < m_workspaces.size()) {
-            auto c = get_conn();
-            focused_ws->unmap_workspace([&c](xcb_window_t window) { xcb_unmap_window(c, window); });
-            focused_ws = m_workspaces[ws_id].get();
-            focused_ws->map_workspace([&c](xcb_window_t window) { xcb_map_window(c, window); });
-            xcb_flush(get_conn());
-        } else {
+        if(ws_id >= m_workspaces.size()) {
             cx::println("There is no workspace with id {}", ws_id);
+            return false;
         }
+        focused_ws->unmap_workspace([this](xcb_window_t window) { reconciler.unmap(window); });
+        focused_ws = m_workspaces[ws_id].get();
+        focused_ws->map_workspace([this](xcb_window_t window) { reconciler.map(window); });
+        notify(ipc::EventType::Workspace, "workspace {} {}", ws_id, focused_ws->m_name);
+        return true;
     }
-    auto Manager::kill_client(cx::events::EventArg arg) -> void
+    auto Manager::focus_workspace(cx::events::EventArg arg) -> void
     {
-        auto focused_client = focused_ws->focused().client->client_id;
-        auto cookie = xcb_kill_client_checked(get_conn(), focused_client);
-        if(auto err = xcb_request_check(get_conn(), cookie); err) {
-            cx::println("Failed to kill client");
+        // A negative index is as much not a workspace as one past the last
+        const auto ws_id = std::get<int>(arg.arg);
+        if(ws_id < 0 || !change_workspace(static_cast<std::size_t>(ws_id)))
+            action_failure = "No such workspace";
+    }
+    auto Manager::kill_client(cx::events::EventArg) -> void
+    {
+        if(!focused_ws->focused().is_window()) {
+            action_failure = "No focused window";
+            return;
         }
+        auto focused_client = focused_ws->focused().client->client_id;
+        x_errors.track(xcb_kill_client(get_conn(), focused_client), [](auto) { cx::println("Failed to kill client"); });
     }
-    void Manager::execute(commands::ManagerCommand* cmd)
+    void Manager::execute(std::unique_ptr<commands::ManagerCommand> cmd)
     {
-        cx::println("Executing command {}", cmd->command_name());
+        cx::println("Queueing command {}", cmd->command_name());
         cmd->request_state(this);
-        cmd->perform(get_conn());
+        command_queue.push(std::move(cmd));
     }
     ws::Window Manager::focused_window() const { return focused_ws->focused().client.value(); }
     const cfg::Configuration& Manager::get_config() const { return configuration; }
     void Manager::handle_expose_event(xcb_expose_event_t* pEvent)
     {
         const auto& c = get_conn();
-        if(auto con = focused_ws->find_window(pEvent->window); con) {
-            auto tag = x11::get_client_wm_name(c, con.value()->client.value().client_id);
-            con.value()->client.value().m_tag.m_tag = tag.value();
-            auto window = con.value()->client.value();
-            auto font_gc = x11::get_font_gc(c, pEvent->window, 0x000000, (u32)configuration.frame_background_color, "7x13");
-            auto text_extents_cookie = xcb_query_text_extents(c, font_gc.value(), window.m_tag.m_tag.length(),
-                                                              reinterpret_cast<const xcb_char2b_t*>(window.m_tag.m_tag.c_str()));
-            cx::x11::X11Resource text_extents = xcb_query_text_extents_reply(c, text_extents_cookie, nullptr);
-            auto [x_pos, y_pos] =
-                cx::draw::utils::align_vertical_middle_left_of(text_extents, window.geometry.width, configuration.frame_title_height);
+        if(auto location = window_index.find(pEvent->window); location) {
+            // The tag is kept up to date by PropertyNotify on WM_NAME, there's no need to ask the server for it on every expose
+            const auto& window = location->node->client.value();
+            if(!window.title_metrics)
+                return;
+            auto [x_pos, y_pos] = cx::draw::utils::align_vertical_middle_left_of(window.title_metrics->measure(window.m_tag.m_tag),
+                                                                                 window.geometry.width, configuration.frame_title_height);
             auto cookie_text =
-                xcb_image_text_8_checked(c, window.m_tag.m_tag.length(), window.frame_id, font_gc.value(), x_pos, y_pos, window.m_tag.m_tag.c_str());
-
-            if(auto error = xcb_request_check(c, cookie_text); error) {
-                cx::println("Could not draw text '{}' in window {}", window.m_tag.m_tag, window.frame_id);
-            }
+                xcb_image_text_8(c, window.m_tag.m_tag.length(), window.frame_id, window.title_gc, x_pos, y_pos, window.m_tag.m_tag.c_str());
+            x_errors.track(cookie_text, [frame = window.frame_id](auto) { cx::println("Could not draw title text in window {}", frame); });
         }
     }
 
@@ -8,20 +8,34 @@
 #include <string_view>
 
 // Third party headers
+#include <fmt/format.h>
 
 // Library/Application headers
 #include <datastructure/geometry.hpp>
 
 #include "configuration.hpp"
 #include "events.hpp"
+#include <coreutils/histogram.hpp>
+#include <coreutils/instrumentation.hpp>
+#include <coreutils/reactor.hpp>
+#include <coreutils/timer_wheel.hpp>
+#include <ipc/command_parser.hpp>
 #include <ipc/ipc.hpp>
+#include <ipc/snapshot.hpp>
+#include <cxprotocol/src/snapshot.h>
 #include <stack>
 #include <sys/epoll.h>
+#include <xcom/commands/command_queue.hpp>
 #include <xcom/commands/manager_command.hpp>
 #include <xcom/constants.hpp>
 #include <xcom/core.hpp>
 #include <xcom/status_bar.hpp>
+#include <xcom/utility/client_query.hpp>
+#include <xcom/utility/error_tracker.hpp>
+#include <xcom/utility/event_batch.hpp>
+#include <xcom/utility/gc_cache.hpp>
 #include <xcom/utility/key_config.hpp>
+#include <xcom/utility/reconciler.hpp>
 #include <xcom/utility/xinit.hpp>
 #include <xcom/workspace.hpp>
 namespace cx
@@ -56,10 +70,16 @@ namespace cx
             }
         }
 
-        void register_action(const config::KeyConfiguration& k_cfg, typename Receiver::MFP fnptr) { key_map[k_cfg] = fnptr; }
+        /// Binding a key that's already bound, replaces what it was bound to
+        void register_action(const config::KeyConfiguration& k_cfg, typename Receiver::MFP fnptr)
+        {
+            key_map_with_args.erase(k_cfg);
+            key_map[k_cfg] = fnptr;
+        }
         void register_action(const config::KeyConfiguration& k_cfg, typename Receiver::MFPWA fnptr, cx::events::EventArg arg)
         {
-            key_map_with_args.emplace(k_cfg, FunctionCall{fnptr, arg});
+            key_map.erase(k_cfg);
+            key_map_with_args.insert_or_assign(k_cfg, FunctionCall{fnptr, arg});
         }
 
         Receiver* r;
@@ -67,6 +87,11 @@ namespace cx
         std::map<config::KeyConfiguration, FunctionCall> key_map_with_args{};
     };
 
+    /// How long a title change waits for the ones after it, before it's drawn
+    constexpr auto TITLE_DEBOUNCE = std::chrono::milliseconds{16};
+    /// How long a loop iteration spends on X events other than input. What's left after that, waits until what it did has been sent
+    constexpr auto EVENT_BUDGET = std::chrono::milliseconds{4};
+
     class Manager
     {
       public:
@@ -78,12 +103,15 @@ namespace cx
         auto event_loop() -> void;
         /// called when we get an IO event on the xcb fd, in event loop
         auto handle_generic_event(xcb_generic_event_t* e) -> void;
-        auto handle_file_descriptor_event(int fd) -> void;
+        auto handle_file_descriptor_event(int fd, u32 events) -> void;
+        /// Performs the commands queued during this loop iteration, recomputes geometry of whatever got marked dirty since last time,
+        /// reconfigures the windows that changed & sends everything to the X server, in one flush
+        auto commit() -> void;
         [[nodiscard]] ws::Window focused_window() const;
         [[nodiscard]] const cfg::Configuration& get_config() const;
         Manager(x11::XCBConn* connection, x11::XCBScreen* screen, x11::XCBDrawable root_drawable, x11::XCBWindow root_window,
-                x11::XCBWindow ewmh_window, xcb_key_symbols_t* symbols, int xcb_fd, std::unique_ptr<ipc::IPCInterface> messenger,
-                int epoll_fd) noexcept;
+                x11::XCBWindow ewmh_window, xcb_key_symbols_t* symbols, int xcb_fd, x11::Atoms atoms,
+                std::unique_ptr<ipc::IPCInterface> messenger, Reactor reactor, std::unique_ptr<TimerWheel> timer_wheel) noexcept;
 
       private:
         [[nodiscard]] inline constexpr auto get_conn() const -> x11::XCBConn*;
@@ -94,26 +122,32 @@ namespace cx
         // and also sets up the workspace(s)
         auto setup() -> void;
         auto setup_root_workspace_container() -> void;
+        /// Frames the windows that were mapped before we started, i.e. when the WM gets restarted
+        auto adopt_existing_windows() -> void;
 
-        template<typename XCBCookieType, typename ErrHandler>
-        auto process_request(XCBCookieType cookie, ws::Window w, ErrHandler fn, bool abort_on_error = true)
+        /// Tracks an unchecked request made on behalf of window w. fn gets called with w, if the X server reports an error for it
+        template<typename ErrHandler>
+        auto process_request(xcb_void_cookie_t cookie, ws::Window w, ErrHandler fn)
         {
-            if(auto err = xcb_request_check(x_detail.c, cookie); err) {
-                fn(w);
-                delete err;
-                if(abort_on_error)
-                    std::abort();
-            }
+            x_errors.track(cookie, [w, fn](auto err) { fn(w, err); });
         }
 
         // EVENT MANAGING / Handlers
+        /// Handles first & everything xcb has queued behind it, without reading the socket again, minus what's redundant, input first
+        /// (see EventBatch). Whatever's left on the socket, epoll wakes us up for; whatever's left over of the batch, the next iteration
+        auto drain_x_events(xcb_generic_event_t* first) -> void;
         auto handle_map_request(xcb_map_request_event_t* event) -> void;
         auto handle_unmap_request(xcb_unmap_window_request_t* event) -> void;
         auto handle_config_request(xcb_configure_request_event_t* event) -> void;
         auto handle_key_press(xcb_key_press_event_t* event) -> void;
+        auto handle_x_error(xcb_generic_error_t* error) -> void;
+        /// Fetches & draws window's title, and tells subscribers about it
+        auto update_title(xcb_window_t window) -> void;
 
         // We assume that most windows were not mapped/created before our WM started
         auto frame_window(x11::XCBWindow window, bool create_before_wm = false) -> void;
+        /// Frames a client whose properties have already been collected
+        auto frame_client(const x11::ClientProperties& client, bool create_before_wm = false) -> void;
         auto unframe_window(const ws::Window& w, bool destroy_client = true) -> void;
         // Makes configure request to X so that it updates window, based on our representation of what it should be
         auto configure_window_geometry(const ws::Window& w) -> void;
@@ -131,17 +165,64 @@ namespace cx
         auto increase_size_focused(cx::events::EventArg arg) -> void;
         auto decrease_size_focused(cx::events::EventArg arg) -> void;
         auto kill_client(cx::events::EventArg arg) -> void;
+        auto focus_workspace(cx::events::EventArg arg) -> void;
+
+        /// Returns false if there's no workspace ws_id
+        auto change_workspace(std::size_t ws_id) -> bool;
+
+        /// The member function an action runs; the same whether it came from a key press or over IPC
+        static auto action_handler(ipc::Action action) -> std::variant<MFP, MFPWA>;
+        /// Runs the command in a message, or binds a key to it. Says what went wrong, if it couldn't
+        auto handle_ipc_message(int client_fd, std::string_view payload) -> ipc::Response;
+        /// Says what went wrong, if the action did nothing
+        auto run_ipc_command(const ipc::Command& command) -> ipc::Response;
+        /// Tells IPC subscribers of type about what happened. Formats nothing, if no one's listening
+        template<typename... Args>
+        auto notify(ipc::EventType type, fmt::format_string<Args...> format, Args&&... args) -> void
+        {
+            // Whatever subscribers would be told about, is in the snapshot too
+            snapshot_stale = true;
+            if(!ipc_interface->has_subscribers(type))
+                return;
+            fmt::memory_buffer message;
+            fmt::format_to(std::back_inserter(message), format, std::forward<Args>(args)...);
+            ipc_interface->publish(type, std::string_view{message.data(), message.size()});
+        }
 
-        auto change_workspace(std::size_t ws_id) -> void;
+        /// Puts what the loop has measured into stats_text: events merged & put off, requests sent & suppressed, commands merged, text GC
+        /// cache hits, key press latency & the probes, if instrumented
+        auto format_stats() -> void;
+        /// Writes the workspaces, their windows & what has focus, into the shared snapshot
+        auto publish_snapshot() -> void;
 
-        void execute(commands::ManagerCommand* cmd);
+        /// Queues cmd, to be performed when the loop iteration commits
+        void execute(std::unique_ptr<commands::ManagerCommand> cmd);
 
         // These are data types that are needed to talk to X. It's none of the logic, that our Window Manager
         // actually needs.
         x11::XInternals x_detail;
+        /// Requests sent unchecked, waiting to see if the X server reports an error for them
+        x11::ErrorTracker x_errors;
+        /// Drained events, kept between iterations so that it's only allocated for once
+        x11::EventBatch x_events;
+        /// From when the loop got hold of a key press, to the commit that sent the X server what it did
+        Histogram key_latency;
+        /// Key presses handled since the last commit, & when the first of them was read
+        std::size_t uncommitted_keys;
+        std::chrono::steady_clock::time_point keys_read_at;
+        /// What format_stats() came up with last; a reply to "stats" points into it
+        std::string stats_text;
+        /// Why the action that ran last did nothing, or empty if it did something. run_ipc_command tells the client; a key press goes unanswered
+        std::string_view action_failure;
+        /// GCs for drawing frame titles & the status bar, shared between everyone using the same colors
+        x11::GCCache gc_cache;
+        /// What we last told the X server about our windows. Commands go through it, so only what actually changed is sent
+        x11::Reconciler reconciler;
+        /// Commands issued during the current loop iteration
+        commands::CommandQueue command_queue;
         bool m_running;
-        std::map<xcb_window_t, xcb_window_t> client_to_frame_mapping;
-        std::map<xcb_window_t, xcb_window_t> frame_to_client_mapping;
+        /// Client & frame id -> (workspace, tree node), for every window we manage
+        ws::WindowIndex window_index;
         ws::Workspace* focused_ws;
         std::vector<std::unique_ptr<ws::Workspace>> m_workspaces;
         std::unique_ptr<ws::StatusBar> status_bar;
@@ -149,7 +230,18 @@ namespace cx
         WindowProperties inactive_windows;
         WindowProperties active_windows;
         std::unique_ptr<ipc::IPCInterface> ipc_interface;
-        int epoll_fd;
+        /// Nothing, if the kernel wouldn't give us one; clients asking for it are told so
+        std::unique_ptr<ipc::SharedSnapshot> snapshot;
+        /// Kept between commits, so that publishing allocates nothing once they've grown to fit the layout
+        ipc::snapshot::Builder snapshot_builder;
+        std::vector<std::byte> snapshot_body;
+        /// Something changed that the X server wasn't told about, i.e. a title
+        bool snapshot_stale;
+        Reactor reactor;
+        /// Runs its timers as a handler of reactor, which has to be around for as long as it is
+        std::unique_ptr<TimerWheel> timers;
+        /// Clients that change their title on every keystroke get it redrawn (and asked for) at most every TITLE_DEBOUNCE
+        Debouncer title_updates;
 
         cfg::Configuration configuration;
 
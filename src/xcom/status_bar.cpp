@@ -8,9 +8,10 @@
 #include <xcom/utility/raii.hpp>
 namespace cx::workspace
 {
-    StatusBar::StatusBar(xcb_connection_t* c, xcb_window_t assigned_id, geom::Geometry assigned_geometry,
+    StatusBar::StatusBar(xcb_connection_t* c, x11::ErrorTracker* errors, xcb_window_t assigned_id, geom::Geometry assigned_geometry,
                          std::vector<std::unique_ptr<WorkspaceBox>> boxes, xcb_gcontext_t active, xcb_gcontext_t inactive)
-        : geometry(assigned_geometry), drawable(assigned_id), items{}, active_workspace{0}, gc_active{active}, gc_inactive{inactive}, c(c)
+        : geometry(assigned_geometry), drawable(assigned_id), items{}, active_workspace{0}, gc_active{active}, gc_inactive{inactive}, c(c),
+          errors(errors)
     {
         for(auto&& item : boxes) {
             items.emplace(item->button_id, std::move(item));
@@ -19,7 +20,7 @@ namespace cx::workspace
     void StatusBar::draw(std::size_t active_workspace)
     {
         for(const auto& [k, v] : items)
-            v->draw(c);
+            v->draw(c, *errors);
     }
     void StatusBar::set_active(std::size_t item_index)
     {
@@ -33,7 +34,7 @@ namespace cx::workspace
     void StatusBar::update() {}
     bool StatusBar::has_child(xcb_window_t window) { return items.count(window) > 0; }
 
-    void WorkspaceBox::draw(xcb_connection_t* c)
+    void WorkspaceBox::draw(xcb_connection_t* c, x11::ErrorTracker& errors)
     {
         local_persist auto box_width = 25;
         local_persist auto box_height = 25;
@@ -42,29 +43,18 @@ namespace cx::workspace
         // draw graphics
         // close graphics context
         auto label = std::to_string(workspace_id);
-        auto extents_cookie = xcb_query_text_extents(c, draw_props, label.length(), reinterpret_cast<const xcb_char2b_t*>(label.c_str()));
-        cx::x11::X11Resource txt_extents = xcb_query_text_extents_reply(c, extents_cookie, nullptr);
-        if(txt_extents) {
-            auto [x_pos, y_pos] = cx::draw::utils::align_text_center_of(txt_extents, box_width, box_height);
-            auto cookie_text = xcb_image_text_8_checked(c, label.length(), button_id, draw_props, x_pos, y_pos, label.c_str());
-            if(auto error = xcb_request_check(c, cookie_text); error) {
-                cx::println("Could not draw text '{}' in window {}", label, this->button_id);
-            }
-        } else {
-            auto cookie_text = xcb_image_text_8_checked(c, label.length(), this->button_id, this->draw_props, 0, 10, label.c_str());
-            if(auto error = xcb_request_check(c, cookie_text); error) {
-                cx::println("Could not draw text '{}' in window {}", label, this->button_id);
-            }
-        }
+        auto [x_pos, y_pos] = cx::draw::utils::align_text_center_of(metrics->measure(label), box_width, box_height);
+        auto cookie_text = xcb_image_text_8(c, label.length(), button_id, draw_props, x_pos, y_pos, label.c_str());
+        errors.track(cookie_text, [label, button = button_id](auto) { cx::println("Could not draw text '{}' in window {}", label, button); });
     }
 
-    WorkspaceBox::WorkspaceBox(cx::uint ws_id, xcb_drawable_t xid, geom::Geometry geometry)
-        : workspace_id{ws_id}, button_id{xid}, dimension{geometry}, state{ItemState::INACTIVE}, draw_props{}
+    WorkspaceBox::WorkspaceBox(cx::uint ws_id, xcb_drawable_t xid, geom::Geometry geometry, const draw::FontMetrics* metrics)
+        : workspace_id{ws_id}, button_id{xid}, dimension{geometry}, state{ItemState::INACTIVE}, draw_props{}, metrics{metrics}
     {
     }
 
-    SysBar make_system_bar(xcb_connection_t* c, xcb_screen_t* screen, std::size_t workspace_count, geom::Geometry sys_bar_geometry,
-                           const cx::cfg::Configuration& wmcfg)
+    SysBar make_system_bar(xcb_connection_t* c, x11::ErrorTracker& errors, x11::GCCache& gc_cache, xcb_screen_t* screen,
+                           std::size_t workspace_count, geom::Geometry sys_bar_geometry, const cx::cfg::Configuration& wmcfg)
     {
         auto sys_bar_id = xcb_generate_id(c);
         const auto& [x, y, width, height] = sys_bar_geometry.xcb_value_list();
@@ -93,8 +83,10 @@ namespace cx::workspace
         auto green = 0x00ff00;
         auto blue = 0x0000ff;
 
-        auto active_draw_prop = x11::get_font_gc(c, sys_bar_id, 0x000000, (u32)green, "7x13");
-        auto inactive_drawprop = x11::get_font_gc(c, sys_bar_id, 0x000000, (u32)blue, "7x13");
+        // The bar lives as long as the WM does, so these are never released
+        auto active_draw_prop = gc_cache.acquire(0x000000, (u32)green, "7x13");
+        auto inactive_drawprop = gc_cache.acquire(0x000000, (u32)blue, "7x13");
+        const auto& label_metrics = gc_cache.metrics(active_draw_prop);
         auto x_anchor = 0;
 
         auto box_masks = XCB_CW_BACK_PIXEL | mask;
@@ -123,18 +115,18 @@ namespace cx::workspace
                 no_error_found = false;
             }
             if(no_error_found) {
-                auto wsb = std::make_unique<WorkspaceBox>(i, id, wsb_geom);
+                auto wsb = std::make_unique<WorkspaceBox>(i, id, wsb_geom, &label_metrics);
                 if(i == 0)
-                    wsb->draw_props = active_draw_prop.value();
+                    wsb->draw_props = active_draw_prop;
                 else
-                    wsb->draw_props = inactive_drawprop.value();
+                    wsb->draw_props = inactive_drawprop;
                 workspace_boxes.push_back(std::move(wsb));
             } else {
                 cx::println("Due to X error, workspace box item was not created");
             }
         }
-        auto sbar = std::make_unique<StatusBar>(c, sys_bar_id, sys_bar_geometry, std::move(workspace_boxes), active_draw_prop.value(),
-                                                inactive_drawprop.value());
+        auto sbar = std::make_unique<StatusBar>(c, &errors, sys_bar_id, sys_bar_geometry, std::move(workspace_boxes), active_draw_prop,
+                                                inactive_drawprop);
         sbar->active_workspace_button = awin;
         return sbar;
     }
@@ -5,6 +5,9 @@
 #pragma once
 
 #include "configuration.hpp"
+#include "xcom/utility/error_tracker.hpp"
+#include "xcom/utility/drawing/font_metrics.hpp"
+#include "xcom/utility/gc_cache.hpp"
 #include "xcom/utility/xinit.hpp"
 #include <datastructure/geometry.hpp>
 #include <map>
@@ -23,8 +26,9 @@ namespace cx::workspace
         geom::Geometry dimension;
         ItemState state;
         xcb_gcontext_t draw_props;
-        WorkspaceBox(cx::uint ws_id, xcb_drawable_t xid, geom::Geometry geometry);
-        void draw(xcb_connection_t* c);
+        const draw::FontMetrics* metrics;
+        WorkspaceBox(cx::uint ws_id, xcb_drawable_t xid, geom::Geometry geometry, const draw::FontMetrics* metrics);
+        void draw(xcb_connection_t* c, x11::ErrorTracker& errors);
 
         template<typename Cb>
         auto signal(Cb cb)
@@ -46,9 +50,10 @@ namespace cx::workspace
         xcb_gcontext_t gc_inactive;
         xcb_gcontext_t gc_active;
         xcb_connection_t* c;
+        x11::ErrorTracker* errors;
         xcb_window_t active_workspace_button;
-        StatusBar(xcb_connection_t* c, xcb_window_t assigned_id, geom::Geometry assigned_geometry, std::vector<std::unique_ptr<WorkspaceBox>> boxes,
-                  xcb_gcontext_t active, xcb_gcontext_t inactive);
+        StatusBar(xcb_connection_t* c, x11::ErrorTracker* errors, xcb_window_t assigned_id, geom::Geometry assigned_geometry,
+                  std::vector<std::unique_ptr<WorkspaceBox>> boxes, xcb_gcontext_t active, xcb_gcontext_t inactive);
         void draw(std::size_t active_workspace = 0);
         void set_active(std::size_t item);
         void update();
@@ -59,23 +64,17 @@ namespace cx::workspace
         void clicked_workspace(xcb_window_t item, CallBack cb)
         {
             if(this->items.count(item) && item != active_workspace_button) {
-                std::array<xcb_void_cookie_t, 4> cookies{};
                 items[item]->draw_props = gc_active;
                 items[active_workspace_button]->draw_props = gc_inactive;
 
                 auto bg_mask = XCB_CW_BACK_PIXEL;
                 auto color = 0x00ff00;
                 const auto& [x, y, w, h] = items[item]->dimension.xcb_value_list();
-                cookies[0] = xcb_change_window_attributes_checked(c, item, bg_mask, (int[]){color});
-                cookies[1] = xcb_clear_area_checked(c, 1, item, 0, 0, w, h);
-                cookies[2] = xcb_change_window_attributes_checked(c, active_workspace_button, bg_mask, (int[]){0x0000ff});
-                cookies[3] = xcb_clear_area_checked(c, 1, active_workspace_button, 0, 0, w, h);
-
-                for(const auto& cookie : cookies) {
-                    if(auto err = xcb_request_check(c, cookie); err) {
-                        cx::println("Failed to change attributes of window. Error code: {}", err->error_code);
-                    }
-                }
+                auto on_error = [](auto err) { cx::println("Failed to change attributes of window. Error code: {}", err->error_code); };
+                errors->track(xcb_change_window_attributes(c, item, bg_mask, (int[]){color}), on_error);
+                errors->track(xcb_clear_area(c, 1, item, 0, 0, w, h), on_error);
+                errors->track(xcb_change_window_attributes(c, active_workspace_button, bg_mask, (int[]){0x0000ff}), on_error);
+                errors->track(xcb_clear_area(c, 1, active_workspace_button, 0, 0, w, h), on_error);
                 active_workspace_button = item;
                 cb(items[item]->workspace_id);
             }
@@ -85,7 +84,7 @@ namespace cx::workspace
     using WBox = std::unique_ptr<WorkspaceBox>;
 
     /// Talks to X-server and creates the required x server resources, returns a well-formed StatusBar object
-    SysBar make_system_bar(xcb_connection_t* c, xcb_screen_t* screen, std::size_t workspace_count, geom::Geometry sys_bar_geometry,
-                           const cx::cfg::Configuration& wmcfg);
+    SysBar make_system_bar(xcb_connection_t* c, x11::ErrorTracker& errors, x11::GCCache& gc_cache, xcb_screen_t* screen,
+                           std::size_t workspace_count, geom::Geometry sys_bar_geometry, const cx::cfg::Configuration& wmcfg);
 
 } // namespace cx::workspace
\ No newline at end of file
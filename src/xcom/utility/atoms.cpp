@@ -0,0 +1,41 @@
+#include <xcom/utility/atoms.hpp>
+#include <xcom/utility/raii.hpp>
+
+namespace cx::x11
+{
+    auto Atoms::intern(xcb_connection_t* c) -> Atoms
+    {
+        std::array<xcb_intern_atom_cookie_t, ATOM_COUNT> cookies{};
+        for(auto i = 0U; i < ATOM_COUNT; ++i) {
+            cookies[i] = xcb_intern_atom(c, 0, atom_names[i].size(), atom_names[i].data());
+        }
+        Atoms atoms{};
+        for(auto i = 0U; i < ATOM_COUNT; ++i) {
+            if(X11Resource reply = xcb_intern_atom_reply(c, cookies[i], nullptr); reply) {
+                atoms.ids[i] = reply->atom;
+            } else {
+                cx::println("Failed to intern atom {}", atom_names[i]);
+                atoms.ids[i] = XCB_ATOM_NONE;
+            }
+        }
+        return atoms;
+    }
+
+    auto Atoms::find(xcb_atom_t id) const -> std::optional<Atom>
+    {
+        for(auto i = 0U; i < ATOM_COUNT; ++i) {
+            if(ids[i] == id)
+                return static_cast<Atom>(i);
+        }
+        return {};
+    }
+
+    auto Atoms::publish_supported(xcb_connection_t* c, xcb_window_t root) const -> xcb_void_cookie_t
+    {
+        std::array<xcb_atom_t, supported_atoms.size()> supported{};
+        for(auto i = 0U; i < supported_atoms.size(); ++i)
+            supported[i] = (*this)[supported_atoms[i]];
+        return xcb_change_property_checked(c, XCB_PROP_MODE_REPLACE, root, (*this)[Atom::NET_SUPPORTED], XCB_ATOM_ATOM, 32, supported.size(),
+                                           supported.data());
+    }
+} // namespace cx::x11
@@ -0,0 +1,127 @@
+#pragma once
+// System headers
+#include <array>
+#include <optional>
+#include <string_view>
+#include <xcb/xcb.h>
+
+// Library/Application headers
+#include <coreutils/core.hpp>
+
+namespace cx::x11
+{
+    /// Every atom we use, that X doesn't predefine. The enumerator is the atom's index in the Atoms registry, so looking one up is an
+    /// array access, never a string compare or a request to the server. Keep in the same order as atom_names
+    enum class Atom : std::size_t {
+        NET_SUPPORTED,
+        NET_SUPPORTING_WM_CHECK,
+        NET_WM_NAME,
+        NET_WM_VISIBLE_NAME,
+        NET_WM_MOVERESIZE,
+        NET_WM_STATE_STICKY,
+        NET_WM_STATE_FULLSCREEN,
+        NET_WM_STATE_DEMANDS_ATTENTION,
+        NET_WM_STATE_MODAL,
+        NET_WM_STATE_HIDDEN,
+        NET_WM_STATE_FOCUSED,
+        NET_WM_STATE,
+        NET_WM_WINDOW_TYPE,
+        NET_WM_WINDOW_TYPE_NORMAL,
+        NET_WM_WINDOW_TYPE_DOCK,
+        NET_WM_WINDOW_TYPE_DIALOG,
+        NET_WM_WINDOW_TYPE_UTILITY,
+        NET_WM_WINDOW_TYPE_TOOLBAR,
+        NET_WM_WINDOW_TYPE_SPLASH,
+        NET_WM_WINDOW_TYPE_MENU,
+        NET_WM_WINDOW_TYPE_DROPDOWN_MENU,
+        NET_WM_WINDOW_TYPE_POPUP_MENU,
+        NET_WM_WINDOW_TYPE_TOOLTIP,
+        NET_WM_WINDOW_TYPE_NOTIFICATION,
+        NET_WM_DESKTOP,
+        NET_WM_STRUT_PARTIAL,
+        NET_CLIENT_LIST,
+        NET_CLIENT_LIST_STACKING,
+        NET_CURRENT_DESKTOP,
+        NET_NUMBER_OF_DESKTOPS,
+        NET_DESKTOP_NAMES,
+        NET_DESKTOP_VIEWPORT,
+        NET_ACTIVE_WINDOW,
+        NET_CLOSE_WINDOW,
+        NET_MOVERESIZE_WINDOW,
+        Count
+    };
+
+    static constexpr std::string_view atom_names[]{"_NET_SUPPORTED",
+                                                   "_NET_SUPPORTING_WM_CHECK",
+                                                   "_NET_WM_NAME",
+                                                   "_NET_WM_VISIBLE_NAME",
+                                                   "_NET_WM_MOVERESIZE",
+                                                   "_NET_WM_STATE_STICKY",
+                                                   "_NET_WM_STATE_FULLSCREEN",
+                                                   "_NET_WM_STATE_DEMANDS_ATTENTION",
+                                                   "_NET_WM_STATE_MODAL",
+                                                   "_NET_WM_STATE_HIDDEN",
+                                                   "_NET_WM_STATE_FOCUSED",
+                                                   "_NET_WM_STATE",
+                                                   "_NET_WM_WINDOW_TYPE",
+                                                   "_NET_WM_WINDOW_TYPE_NORMAL",
+                                                   "_NET_WM_WINDOW_TYPE_DOCK",
+                                                   "_NET_WM_WINDOW_TYPE_DIALOG",
+                                                   "_NET_WM_WINDOW_TYPE_UTILITY",
+                                                   "_NET_WM_WINDOW_TYPE_TOOLBAR",
+                                                   "_NET_WM_WINDOW_TYPE_SPLASH",
+                                                   "_NET_WM_WINDOW_TYPE_MENU",
+                                                   "_NET_WM_WINDOW_TYPE_DROPDOWN_MENU",
+                                                   "_NET_WM_WINDOW_TYPE_POPUP_MENU",
+                                                   "_NET_WM_WINDOW_TYPE_TOOLTIP",
+                                                   "_NET_WM_WINDOW_TYPE_NOTIFICATION",
+                                                   "_NET_WM_DESKTOP",
+                                                   "_NET_WM_STRUT_PARTIAL",
+                                                   "_NET_CLIENT_LIST",
+                                                   "_NET_CLIENT_LIST_STACKING",
+                                                   "_NET_CURRENT_DESKTOP",
+                                                   "_NET_NUMBER_OF_DESKTOPS",
+                                                   "_NET_DESKTOP_NAMES",
+                                                   "_NET_DESKTOP_VIEWPORT",
+                                                   "_NET_ACTIVE_WINDOW",
+                                                   "_NET_CLOSE_WINDOW",
+                                                   "_NET_MOVERESIZE_WINDOW"};
+
+    constexpr auto ATOM_COUNT = static_cast<std::size_t>(Atom::Count);
+    static_assert(std::size(atom_names) == ATOM_COUNT, "Every Atom needs a name in atom_names, and vice versa");
+
+    constexpr auto atom_name(Atom atom) -> std::string_view { return atom_names[static_cast<std::size_t>(atom)]; }
+
+    /// The hints we actually handle, which is what goes in _NET_SUPPORTED. Pagers & clients take what's listed as implemented, so an atom
+    /// goes in here once something acts on it, not when it's interned
+    constexpr std::array supported_atoms{Atom::NET_SUPPORTING_WM_CHECK,
+                                         Atom::NET_WM_WINDOW_TYPE,
+                                         Atom::NET_WM_WINDOW_TYPE_NORMAL,
+                                         Atom::NET_WM_WINDOW_TYPE_DOCK,
+                                         Atom::NET_WM_WINDOW_TYPE_DIALOG,
+                                         Atom::NET_WM_WINDOW_TYPE_UTILITY,
+                                         Atom::NET_WM_WINDOW_TYPE_TOOLBAR,
+                                         Atom::NET_WM_WINDOW_TYPE_SPLASH,
+                                         Atom::NET_WM_WINDOW_TYPE_MENU,
+                                         Atom::NET_WM_WINDOW_TYPE_DROPDOWN_MENU,
+                                         Atom::NET_WM_WINDOW_TYPE_POPUP_MENU,
+                                         Atom::NET_WM_WINDOW_TYPE_TOOLTIP,
+                                         Atom::NET_WM_WINDOW_TYPE_NOTIFICATION};
+
+    /// The interned ids of every Atom. Intern all of them once, at start up
+    class Atoms
+    {
+      public:
+        /// Sends an intern request for every name in atom_names, then collects the replies. One round trip for the lot
+        static auto intern(xcb_connection_t* c) -> Atoms;
+
+        constexpr auto operator[](Atom atom) const -> xcb_atom_t { return ids[static_cast<std::size_t>(atom)]; }
+        /// Reverse lookup, for when the server tells us about an atom, i.e. in a PropertyNotify
+        [[nodiscard]] auto find(xcb_atom_t id) const -> std::optional<Atom>;
+        /// Sets _NET_SUPPORTED on root to supported_atoms
+        auto publish_supported(xcb_connection_t* c, xcb_window_t root) const -> xcb_void_cookie_t;
+
+      private:
+        std::array<xcb_atom_t, ATOM_COUNT> ids{};
+    };
+} // namespace cx::x11
@@ -0,0 +1,155 @@
+#include <xcom/utility/client_query.hpp>
+
+namespace cx::x11
+{
+    namespace
+    {
+        /// WM_SIZE_HINTS are 18 CARD32's, pre ICCCM version 1 clients set 15 of them
+        constexpr auto SIZE_HINTS_LENGTH = 18U;
+        constexpr auto OLD_SIZE_HINTS_LENGTH = 15U;
+        constexpr auto P_MIN_SIZE = 1U << 4U;
+        constexpr auto P_MAX_SIZE = 1U << 5U;
+        constexpr auto P_RESIZE_INC = 1U << 6U;
+        constexpr auto P_BASE_SIZE = 1U << 8U;
+
+        constexpr std::pair<Atom, WindowType> window_types[]{
+            {Atom::NET_WM_WINDOW_TYPE_NORMAL, WindowType::Normal},
+            {Atom::NET_WM_WINDOW_TYPE_DIALOG, WindowType::Dialog},
+            {Atom::NET_WM_WINDOW_TYPE_DOCK, WindowType::Dock},
+            {Atom::NET_WM_WINDOW_TYPE_UTILITY, WindowType::Utility},
+            {Atom::NET_WM_WINDOW_TYPE_TOOLBAR, WindowType::Toolbar},
+            {Atom::NET_WM_WINDOW_TYPE_SPLASH, WindowType::Splash},
+            {Atom::NET_WM_WINDOW_TYPE_MENU, WindowType::Menu},
+            {Atom::NET_WM_WINDOW_TYPE_DROPDOWN_MENU, WindowType::DropdownMenu},
+            {Atom::NET_WM_WINDOW_TYPE_POPUP_MENU, WindowType::PopupMenu},
+            {Atom::NET_WM_WINDOW_TYPE_TOOLTIP, WindowType::Tooltip},
+            {Atom::NET_WM_WINDOW_TYPE_NOTIFICATION, WindowType::Notification},
+        };
+
+        auto class_property(xcb_get_property_reply_t* reply) -> std::optional<std::string>
+        {
+            // WM_CLASS is "instance\0class\0". The class is what identifies the application
+            auto instance_and_class = string_property(reply);
+            if(!instance_and_class)
+                return {};
+            std::string_view value{*instance_and_class};
+            auto separator = value.find('\0');
+            if(separator == std::string_view::npos)
+                return std::string{value};
+            value.remove_prefix(separator + 1);
+            if(auto end = value.find('\0'); end != std::string_view::npos)
+                value = value.substr(0, end);
+            return value.empty() ? std::nullopt : std::make_optional(std::string{value});
+        }
+
+        auto size_hints_property(xcb_get_property_reply_t* reply) -> std::optional<SizeHints>
+        {
+            if(!reply || reply->format != 32 || xcb_get_property_value_length(reply) < (int)(OLD_SIZE_HINTS_LENGTH * sizeof(u32)))
+                return {};
+            auto fields = (const u32*)xcb_get_property_value(reply);
+            SizeHints hints{fields[0], 0, 0, 0, 0, 0, 0, 0, 0};
+            if(hints.flags & P_MIN_SIZE) {
+                hints.min_width = (int)fields[5];
+                hints.min_height = (int)fields[6];
+            }
+            if(hints.flags & P_MAX_SIZE) {
+                hints.max_width = (int)fields[7];
+                hints.max_height = (int)fields[8];
+            }
+            if(hints.flags & P_RESIZE_INC) {
+                hints.width_increment = (int)fields[9];
+                hints.height_increment = (int)fields[10];
+            }
+            if(hints.flags & P_BASE_SIZE && xcb_get_property_value_length(reply) >= (int)(SIZE_HINTS_LENGTH * sizeof(u32))) {
+                hints.base_width = (int)fields[15];
+                hints.base_height = (int)fields[16];
+            }
+            return hints;
+        }
+
+        auto window_type_property(xcb_get_property_reply_t* reply, const Atoms& atoms) -> WindowType
+        {
+            if(!reply || reply->format != 32)
+                return WindowType::Normal;
+            auto types = (const xcb_atom_t*)xcb_get_property_value(reply);
+            auto count = xcb_get_property_value_length(reply) / (int)sizeof(xcb_atom_t);
+            // The list is in order of preference, so the first one we know of wins
+            for(auto i = 0; i < count; ++i) {
+                for(const auto& [atom, type] : window_types) {
+                    if(atoms[atom] == types[i])
+                        return type;
+                }
+            }
+            return WindowType::Normal;
+        }
+    } // namespace
+
+    auto ClientProperties::title() const -> std::string
+    {
+        if(wm_name)
+            return *wm_name;
+        if(wm_class)
+            return *wm_class;
+        return "cxw_" + std::to_string(window);
+    }
+
+    auto ClientProperties::wants_frame() const -> bool
+    {
+        switch(window_type) {
+        case WindowType::Dock:
+        case WindowType::Menu:
+        case WindowType::DropdownMenu:
+        case WindowType::PopupMenu:
+        case WindowType::Tooltip:
+        case WindowType::Notification:
+            return false;
+        default:
+            return !override_redirect;
+        }
+    }
+
+    auto request_client_properties(XCBConn* c, xcb_window_t window, const Atoms& atoms) -> ClientQuery
+    {
+        return ClientQuery{window,
+                           xcb_get_window_attributes(c, window),
+                           xcb_get_geometry(c, window),
+                           xcb_get_property(c, 0, window, XCB_ATOM_WM_NAME, XCB_ATOM_STRING, 0, 45),
+                           xcb_get_property(c, 0, window, XCB_ATOM_WM_CLASS, XCB_ATOM_STRING, 0, 32),
+                           xcb_get_property(c, 0, window, XCB_ATOM_WM_NORMAL_HINTS, XCB_ATOM_WM_SIZE_HINTS, 0, SIZE_HINTS_LENGTH),
+                           xcb_get_property(c, 0, window, atoms[Atom::NET_WM_WINDOW_TYPE], XCB_ATOM_ATOM, 0, 16)};
+    }
+
+    auto collect_client_properties(XCBConn* c, const ClientQuery& query, const Atoms& atoms) -> std::optional<ClientProperties>
+    {
+        // Every reply is collected, even if the first one tells us the window is gone, or xcb would keep them around for us
+        X11Resource attributes = xcb_get_window_attributes_reply(c, query.attributes, nullptr);
+        X11Resource geometry = xcb_get_geometry_reply(c, query.geometry, nullptr);
+        X11Resource wm_name = xcb_get_property_reply(c, query.wm_name, nullptr);
+        X11Resource wm_class = xcb_get_property_reply(c, query.wm_class, nullptr);
+        X11Resource size_hints = xcb_get_property_reply(c, query.size_hints, nullptr);
+        X11Resource window_type = xcb_get_property_reply(c, query.window_type, nullptr);
+        if(!attributes || !geometry) {
+            DBGLOG("Window {} disappeared before we could query it", query.window);
+            return {};
+        }
+        return ClientProperties{query.window,
+                                (bool)attributes->override_redirect,
+                                attributes->map_state,
+                                geom::Geometry{geometry->x, geometry->y, geometry->width, geometry->height},
+                                string_property(wm_name),
+                                class_property(wm_class),
+                                size_hints_property(size_hints),
+                                window_type_property(window_type, atoms)};
+    }
+
+    auto string_property(xcb_get_property_reply_t* reply) -> std::optional<std::string>
+    {
+        if(!reply)
+            return {};
+        auto str_length = xcb_get_property_value_length(reply);
+        if(str_length <= 0)
+            return {};
+        auto start = (const char*)xcb_get_property_value(reply);
+        return std::string{start, (std::size_t)str_length};
+    }
+} // namespace cx::x11
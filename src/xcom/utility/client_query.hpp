@@ -0,0 +1,71 @@
+#pragma once
+// System headers
+#include <optional>
+#include <string>
+#include <xcb/xcb.h>
+
+// Library/Application headers
+#include <datastructure/geometry.hpp>
+#include <xcom/utility/xinit.hpp>
+
+namespace cx::x11
+{
+    enum class WindowType {
+        Normal,
+        Dialog,
+        Dock,
+        Utility,
+        Toolbar,
+        Splash,
+        Menu,
+        DropdownMenu,
+        PopupMenu,
+        Tooltip,
+        Notification,
+    };
+
+    /// WM_NORMAL_HINTS, as laid out in ICCCM 4.1.2.3. Only the fields flagged in flags carry meaningful values
+    struct SizeHints {
+        u32 flags;
+        int min_width, min_height;
+        int max_width, max_height;
+        int width_increment, height_increment;
+        int base_width, base_height;
+    };
+
+    /// Cookies for every request we need answered before we can frame a client. Sending them all before asking for a single reply, means
+    /// we wait for the X server once, instead of once per property
+    struct ClientQuery {
+        xcb_window_t window;
+        xcb_get_window_attributes_cookie_t attributes;
+        xcb_get_geometry_cookie_t geometry;
+        xcb_get_property_cookie_t wm_name;
+        xcb_get_property_cookie_t wm_class;
+        xcb_get_property_cookie_t size_hints;
+        xcb_get_property_cookie_t window_type;
+    };
+
+    /// What we know about a client window, before it's been framed
+    struct ClientProperties {
+        xcb_window_t window;
+        bool override_redirect;
+        std::uint8_t map_state;
+        geom::Geometry geometry;
+        std::optional<std::string> wm_name;
+        std::optional<std::string> wm_class;
+        std::optional<SizeHints> size_hints;
+        WindowType window_type;
+        /// Returns the name that should go in the title of the frame
+        [[nodiscard]] auto title() const -> std::string;
+        /// Docks, menus, tooltips & notifications place themselves. We map them as is, instead of tiling them
+        [[nodiscard]] auto wants_frame() const -> bool;
+    };
+
+    /// Sends all requests for window's properties, without waiting for any of them
+    auto request_client_properties(XCBConn* c, xcb_window_t window, const Atoms& atoms) -> ClientQuery;
+    /// Collects the replies of requests made by request_client_properties. Returns nothing if the window no longer exists
+    auto collect_client_properties(XCBConn* c, const ClientQuery& query, const Atoms& atoms) -> std::optional<ClientProperties>;
+
+    /// Reads a STRING property reply. Returns nothing if the reply is missing or the property is empty
+    auto string_property(xcb_get_property_reply_t* reply) -> std::optional<std::string>;
+} // namespace cx::x11
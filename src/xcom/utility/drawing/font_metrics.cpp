@@ -0,0 +1,57 @@
+#include "font_metrics.hpp"
+#include <algorithm>
+#include <numeric>
+#include <xcom/utility/raii.hpp>
+
+namespace cx::draw
+{
+    auto FontMetrics::from_reply(const xcb_query_font_reply_t* reply) -> FontMetrics
+    {
+        FontMetrics metrics{};
+        metrics.ascent = reply->font_ascent;
+        metrics.descent = reply->font_descent;
+        auto char_infos = xcb_query_font_char_infos(reply);
+        auto char_infos_length = xcb_query_font_char_infos_length(reply);
+        // 8-bit text is looked up as if byte1 was 0. Fonts without that row, have nothing we could draw
+        if(reply->min_byte1 != 0)
+            return metrics;
+        const auto first = reply->min_char_or_byte2;
+        const auto last = std::min<int>(reply->max_char_or_byte2, 255);
+        auto advance_of = [&](int ch) -> std::int16_t {
+            if(ch < first || ch > last)
+                return -1;
+            // An empty list means every glyph looks like max_bounds, which is what monospaced fonts often send
+            if(char_infos_length == 0)
+                return reply->max_bounds.character_width;
+            const auto& info = char_infos[ch - first];
+            // A glyph with all metrics zero, doesn't exist
+            if(info.character_width == 0 && info.left_side_bearing == 0 && info.right_side_bearing == 0 && info.ascent == 0 && info.descent == 0)
+                return -1;
+            return info.character_width;
+        };
+        // Characters the font doesn't have are drawn as default_char. If that doesn't exist either, they're not drawn at all
+        auto default_advance = std::max<std::int16_t>(advance_of(reply->default_char), 0);
+        for(auto ch = 0; ch < 256; ++ch) {
+            auto advance = advance_of(ch);
+            metrics.advances[ch] = advance < 0 ? default_advance : advance;
+        }
+        return metrics;
+    }
+
+    auto FontMetrics::query(xcb_connection_t* c, xcb_fontable_t font) -> std::optional<FontMetrics>
+    {
+        if(cx::x11::X11Resource reply = xcb_query_font_reply(c, xcb_query_font(c, font), nullptr); reply) {
+            return from_reply(reply);
+        }
+        return {};
+    }
+
+    auto FontMetrics::width(std::string_view text) const noexcept -> int
+    {
+        // A table lookup per byte, summed in whatever order the compiler sees fit, which lets it vectorize the sum
+        return std::transform_reduce(text.begin(), text.end(), 0, std::plus<>{},
+                                     [this](char ch) -> int { return advances[static_cast<unsigned char>(ch)]; });
+    }
+
+    auto FontMetrics::measure(std::string_view text) const noexcept -> TextExtents { return TextExtents{width(text), ascent, descent}; }
+} // namespace cx::draw
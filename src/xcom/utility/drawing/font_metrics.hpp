@@ -0,0 +1,36 @@
+#pragma once
+// System headers
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <xcb/xcb.h>
+
+namespace cx::draw
+{
+    /// What xcb_query_text_extents would have answered, for the parts of it we use
+    struct TextExtents {
+        int width;
+        int ascent;
+        int descent;
+    };
+
+    /// Glyph advances of a font, so that text can be measured without asking the X server. Only covers the 8-bit range, which is all
+    /// xcb_image_text_8 can draw anyway
+    class FontMetrics
+    {
+      public:
+        /// Builds the table from a QueryFont reply
+        static auto from_reply(const xcb_query_font_reply_t* reply) -> FontMetrics;
+        /// Blocks on xcb_query_font. Do this once per font, not once per draw
+        static auto query(xcb_connection_t* c, xcb_fontable_t font) -> std::optional<FontMetrics>;
+
+        [[nodiscard]] auto measure(std::string_view text) const noexcept -> TextExtents;
+        [[nodiscard]] auto width(std::string_view text) const noexcept -> int;
+
+      private:
+        std::array<std::int16_t, 256> advances{};
+        int ascent = 0;
+        int descent = 0;
+    };
+} // namespace cx::draw
@@ -0,0 +1,47 @@
+#include <xcom/utility/error_tracker.hpp>
+
+namespace cx::x11
+{
+    /// Sequence numbers wrap around, so "a comes before b" has to be answered by looking at the signed distance between them
+    constexpr auto sequence_before(u32 a, u32 b) -> bool { return static_cast<std::int32_t>(a - b) < 0; }
+
+    void ErrorTracker::track(xcb_void_cookie_t cookie, ErrorHandler handler)
+    {
+        if(requests.size() == MAX_PENDING) {
+            DBGLOG("Error tracker full. Dropping tracking of request {}", requests.front().sequence);
+            requests.pop_front();
+        }
+        requests.push_back(TrackedRequest{cookie.sequence, std::move(handler)});
+    }
+
+    auto ErrorTracker::handle_error(const xcb_generic_error_t* err) -> bool
+    {
+        // Everything sent before the failed request has been processed. Had any of those failed, we would have seen that error first
+        while(!requests.empty() && sequence_before(requests.front().sequence, err->full_sequence)) {
+            requests.pop_front();
+        }
+        if(!requests.empty() && requests.front().sequence == err->full_sequence) {
+            auto handler = std::move(requests.front().handler);
+            requests.pop_front();
+            if(handler)
+                handler(err);
+            return true;
+        }
+        return false;
+    }
+
+    void ErrorTracker::retire(u32 sequence)
+    {
+        while(!requests.empty() && !sequence_before(sequence, requests.front().sequence)) {
+            requests.pop_front();
+        }
+    }
+
+    auto ErrorTracker::pending() const -> std::size_t { return requests.size(); }
+
+    void log_untracked_error(const xcb_generic_error_t* err)
+    {
+        cx::println("X error {} on resource {} (request {}:{}, sequence {})", err->error_code, err->resource_id, err->major_code, err->minor_code,
+                    err->full_sequence);
+    }
+} // namespace cx::x11
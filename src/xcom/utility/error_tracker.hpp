@@ -0,0 +1,44 @@
+#pragma once
+// System headers
+#include <deque>
+#include <functional>
+#include <xcb/xcb.h>
+
+// Library/Application headers
+#include <coreutils/core.hpp>
+
+namespace cx::x11
+{
+    /// Called with the error the X server sent back for a tracked request. The error is owned by the event loop, don't free it.
+    using ErrorHandler = std::function<void(const xcb_generic_error_t*)>;
+
+    /// Matches errors from requests sent *unchecked* with the request that caused them. Unchecked requests don't cost a round trip;
+    /// if they fail, the error shows up in the event queue (response_type == 0) with the sequence number of the request that failed.
+    /// X processes requests in order, so once we see an event or error with sequence number N, every request sent before N is done,
+    /// which is how entries get retired without ever asking the server.
+    class ErrorTracker
+    {
+      public:
+        ErrorTracker() noexcept = default;
+        /// Records cookie.sequence & the handler to call if that request turns out to have failed
+        void track(xcb_void_cookie_t cookie, ErrorHandler handler);
+        /// Calls handler of the tracked request that err refers to. Returns false if nobody was tracking that request
+        auto handle_error(const xcb_generic_error_t* err) -> bool;
+        /// Retires every tracked request with a sequence number up to & including sequence. Call with the full_sequence of every event
+        void retire(u32 sequence);
+        [[nodiscard]] auto pending() const -> std::size_t;
+
+      private:
+        struct TrackedRequest {
+            u32 sequence;
+            ErrorHandler handler;
+        };
+        /// Upper bound for requests we wait on. If the server goes quiet for a very long time while we keep sending, the oldest entries
+        /// are dropped, and an error for them gets reported as untracked instead
+        static constexpr std::size_t MAX_PENDING = 1U << 14U;
+        std::deque<TrackedRequest> requests{};
+    };
+
+    /// Logs an X error that no tracked request claimed
+    void log_untracked_error(const xcb_generic_error_t* err);
+} // namespace cx::x11
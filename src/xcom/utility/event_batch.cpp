@@ -0,0 +1,155 @@
+#include <xcom/utility/event_batch.hpp>
+
+#include <algorithm>
+
+namespace cx::x11
+{
+    namespace
+    {
+        auto key_of(xcb_window_t window, xcb_atom_t atom = XCB_ATOM_NONE) -> std::uint64_t
+        {
+            return (static_cast<std::uint64_t>(atom) << 32) | window;
+        }
+
+        /// Takes what later doesn't ask for, from earlier
+        void merge_configure(xcb_configure_request_event_t& later, const xcb_configure_request_event_t& earlier)
+        {
+            const auto missing = earlier.value_mask & ~later.value_mask;
+            if(missing & XCB_CONFIG_WINDOW_X)
+                later.x = earlier.x;
+            if(missing & XCB_CONFIG_WINDOW_Y)
+                later.y = earlier.y;
+            if(missing & XCB_CONFIG_WINDOW_WIDTH)
+                later.width = earlier.width;
+            if(missing & XCB_CONFIG_WINDOW_HEIGHT)
+                later.height = earlier.height;
+            if(missing & XCB_CONFIG_WINDOW_BORDER_WIDTH)
+                later.border_width = earlier.border_width;
+            if(missing & XCB_CONFIG_WINDOW_SIBLING)
+                later.sibling = earlier.sibling;
+            if(missing & XCB_CONFIG_WINDOW_STACK_MODE)
+                later.stack_mode = earlier.stack_mode;
+            later.value_mask |= earlier.value_mask;
+        }
+    } // namespace
+
+    void EventBatch::push(xcb_generic_event_t* raw)
+    {
+        ++received;
+        // The last of the series is on its way; that's the one that gets the redraw
+        if(raw->response_type == XCB_EXPOSE && reinterpret_cast<xcb_expose_event_t*>(raw)->count != 0) {
+            std::free(raw);
+            return;
+        }
+        events.emplace_back(raw);
+        merge(events.size() - 1);
+    }
+
+    void EventBatch::merge(std::size_t position)
+    {
+        auto event = events[position].get();
+        if(is_barrier(event)) {
+            reset_merging();
+            return;
+        }
+        // Sent by a client (0x80) isn't the server's word on anything, so it's neither merged nor merged into
+        switch(event->response_type) {
+        case XCB_EXPOSE:
+            replace(exposes, key_of(reinterpret_cast<xcb_expose_event_t*>(event)->window), position);
+            break;
+        case XCB_PROPERTY_NOTIFY: {
+            auto e = reinterpret_cast<xcb_property_notify_event_t*>(event);
+            replace(properties, key_of(e->window, e->atom), position);
+            break;
+        }
+        case XCB_CONFIGURE_REQUEST: {
+            auto e = reinterpret_cast<xcb_configure_request_event_t*>(event);
+            const auto key = key_of(e->window);
+            if(auto found = configures.find(key); found != configures.end())
+                merge_configure(*e, *reinterpret_cast<xcb_configure_request_event_t*>(events[found->second].get()));
+            replace(configures, key, position);
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    void EventBatch::drain(xcb_connection_t* c, xcb_generic_event_t* first)
+    {
+        for(auto ev = first; ev != nullptr; ev = xcb_poll_for_queued_event(c))
+            push(ev);
+    }
+
+    void EventBatch::replace(std::unordered_map<std::uint64_t, std::size_t>& index, std::uint64_t key, std::size_t position)
+    {
+        auto [found, added] = index.try_emplace(key, position);
+        if(!added) {
+            events[found->second].reset();
+            found->second = position;
+        }
+    }
+
+    void EventBatch::reset_merging()
+    {
+        exposes.clear();
+        properties.clear();
+        configures.clear();
+    }
+
+    void EventBatch::compact()
+    {
+        events.erase(std::remove(events.begin(), events.end(), nullptr), events.end());
+        deferred += events.size();
+        reset_merging();
+        for(std::size_t position = 0; position < events.size(); ++position)
+            merge(position);
+    }
+
+    auto EventBatch::empty() const -> bool { return events.empty(); }
+
+    auto EventBatch::priority_of(const xcb_generic_event_t* event) -> Priority
+    {
+        switch(event->response_type & ~0x80) {
+        case 0:
+        case XCB_KEY_PRESS:
+        case XCB_KEY_RELEASE:
+        case XCB_BUTTON_PRESS:
+        case XCB_BUTTON_RELEASE:
+        case XCB_MOTION_NOTIFY:
+            return Priority::Input;
+        case XCB_MAP_REQUEST:
+        case XCB_MAP_NOTIFY:
+        case XCB_UNMAP_NOTIFY:
+        case XCB_DESTROY_NOTIFY:
+        case XCB_REPARENT_NOTIFY:
+        case XCB_FOCUS_IN:
+        case XCB_FOCUS_OUT:
+        case XCB_ENTER_NOTIFY:
+        case XCB_LEAVE_NOTIFY:
+        case XCB_MAPPING_NOTIFY:
+            return Priority::Structure;
+        case XCB_CONFIGURE_REQUEST:
+        case XCB_CONFIGURE_NOTIFY:
+            return Priority::Configure;
+        default:
+            return Priority::Cosmetic;
+        }
+    }
+
+    auto EventBatch::is_barrier(const xcb_generic_event_t* event) -> bool
+    {
+        switch(event->response_type) {
+        case XCB_MAP_REQUEST:
+        case XCB_MAP_NOTIFY:
+        case XCB_UNMAP_NOTIFY:
+        case XCB_DESTROY_NOTIFY:
+        case XCB_REPARENT_NOTIFY:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    auto EventBatch::stats() const -> EventBatchStats { return EventBatchStats{received, handled, deferred}; }
+} // namespace cx::x11
@@ -0,0 +1,119 @@
+#pragma once
+// System headers
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <initializer_list>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include <xcb/xcb.h>
+
+// Library/Application headers
+#include <coreutils/core.hpp>
+
+namespace cx::x11
+{
+    struct EventBatchStats {
+        /// Events that came in from the X server
+        std::size_t received;
+        /// Events that were left to be handled, once the redundant ones had been merged away
+        std::size_t handled;
+        /// Times an event was left for the next dispatch, because the budget had run out
+        std::size_t deferred;
+    };
+
+    /// What gets handled first. Whatever the user does, before anything else: a key press waiting behind a terminal's title spam is lag
+    /// you can feel. Then what changes which windows there are or which has focus; then the geometry clients ask for; then what is only
+    /// drawn
+    enum class Priority : std::uint8_t { Input, Structure, Configure, Cosmetic };
+
+    /// The X events queued up at one point, with the ones made redundant by a later one merged into it: of a series of Exposes only the
+    /// last one (count == 0) is kept, and only one per window; PropertyNotify is kept once per (window, atom), the last one; & the
+    /// ConfigureRequests of a window become one, the last, with whatever it doesn't ask for taken from those before it. What's merged
+    /// ends up where the last of them was. Events that make or unmake windows (map, unmap, destroy, reparent) are kept in order with
+    /// everything before them; nothing gets merged across one. Input is handled first, all of it. The rest goes by priority, & in the order
+    /// it came in within one, but never past one of those: a ConfigureRequest that came before a MapRequest is handled before it
+    class EventBatch
+    {
+      public:
+        EventBatch() = default;
+        EventBatch(const EventBatch&) = delete;
+        EventBatch& operator=(const EventBatch&) = delete;
+
+        /// Takes event, which xcb allocated, & merges it with what it makes redundant
+        void push(xcb_generic_event_t* event);
+        /// Pushes first & everything xcb has queued behind it, without reading the socket again
+        void drain(xcb_connection_t* c, xcb_generic_event_t* first);
+        /// Calls handler with each event, highest priority first, & frees them. Input is always handled in full; the rest only for as long
+        /// as budget lasts, counted from the start. What's left over stays, for the next dispatch, & keeps being merged with what comes in.
+        /// handler must not push
+        template<typename Handler>
+        void dispatch(Handler&& handler, std::chrono::nanoseconds budget = std::chrono::nanoseconds::max())
+        {
+            const auto start = std::chrono::steady_clock::now();
+            auto handle = [this, &handler](Event& event) {
+                auto taken = std::move(event);
+                ++handled;
+                handler(taken.get());
+            };
+            for(auto& event : events) {
+                if(event && priority_of(event.get()) == Priority::Input)
+                    handle(event);
+            }
+            // Up to & including the next barrier, by priority; the barrier itself goes last
+            for(std::size_t first = 0; first < events.size();) {
+                auto barrier = first;
+                while(barrier < events.size() && !(events[barrier] && is_barrier(events[barrier].get())))
+                    ++barrier;
+                for(auto priority : {Priority::Structure, Priority::Configure, Priority::Cosmetic}) {
+                    for(auto i = first; i < barrier; ++i) {
+                        if(!events[i] || priority_of(events[i].get()) != priority)
+                            continue;
+                        if(std::chrono::steady_clock::now() - start >= budget)
+                            return compact();
+                        handle(events[i]);
+                    }
+                }
+                if(barrier == events.size())
+                    break;
+                if(std::chrono::steady_clock::now() - start >= budget)
+                    return compact();
+                handle(events[barrier]);
+                first = barrier + 1;
+            }
+            compact();
+        }
+        [[nodiscard]] auto empty() const -> bool;
+        [[nodiscard]] auto stats() const -> EventBatchStats;
+        /// X errors go with input: they have to be seen before any event with a later sequence number, which retires the requests
+        /// they're about (see ErrorTracker)
+        static auto priority_of(const xcb_generic_event_t* event) -> Priority;
+        /// Makes or unmakes a window; nothing is merged across it, nor handled after it that came in before it
+        static auto is_barrier(const xcb_generic_event_t* event) -> bool;
+
+      private:
+        struct Free {
+            void operator()(xcb_generic_event_t* event) const { std::free(event); }
+        };
+        using Event = std::unique_ptr<xcb_generic_event_t, Free>;
+
+        /// Merges the event at position with what came before it
+        void merge(std::size_t position);
+        /// Drops the event index had for key, if any, & makes it point at position
+        void replace(std::unordered_map<std::uint64_t, std::size_t>& index, std::uint64_t key, std::size_t position);
+        void reset_merging();
+        /// Closes the holes that merging & dispatching left, & indexes what's left over, to be merged with
+        void compact();
+
+        /// Merged events leave a hole where they were
+        std::vector<Event> events{};
+        /// Where the last event of each kind, for each window (& atom), is in events
+        std::unordered_map<std::uint64_t, std::size_t> exposes{};
+        std::unordered_map<std::uint64_t, std::size_t> properties{};
+        std::unordered_map<std::uint64_t, std::size_t> configures{};
+        std::size_t received = 0;
+        std::size_t handled = 0;
+        std::size_t deferred = 0;
+    };
+} // namespace cx::x11
@@ -0,0 +1,80 @@
+#include <xcom/utility/gc_cache.hpp>
+#include <xcom/utility/raii.hpp>
+
+namespace cx::x11
+{
+    GCCache::GCCache(xcb_connection_t* c, xcb_window_t root, ErrorTracker* errors) noexcept : c(c), root(root), errors(errors) {}
+
+    GCCache::~GCCache()
+    {
+        for(const auto& [key, entry] : gcs)
+            xcb_free_gc(c, entry.gc);
+        for(auto& [name, font] : fonts) {
+            if(!font.metrics)
+                xcb_discard_reply(c, font.query.sequence);
+            xcb_close_font(c, font.id);
+        }
+    }
+
+    auto GCCache::acquire(u32 fg_color, u32 bg_color, std::string_view font_name) -> xcb_gcontext_t
+    {
+        Key key{fg_color, bg_color, std::string{font_name}};
+        if(auto it = gcs.find(key); it != gcs.end()) {
+            ++hits;
+            ++it->second.references;
+            return it->second.gc;
+        }
+        ++misses;
+        auto gc = xcb_generate_id(c);
+        auto mask = XCB_GC_FOREGROUND | XCB_GC_BACKGROUND | XCB_GC_FONT;
+        uint32_t v_list[]{fg_color, bg_color, font(font_name).id};
+        errors->track(xcb_create_gc(c, gc, root, mask, v_list),
+                      [](auto err) { cx::println("Could not create graphics context. Error code {}", err->error_code); });
+        keys.emplace(gc, key);
+        gcs.emplace(std::move(key), Entry{gc, 1});
+        return gc;
+    }
+
+    void GCCache::release(xcb_gcontext_t gc)
+    {
+        auto key = keys.find(gc);
+        if(key == keys.end()) {
+            DBGLOG("Released GC {} which isn't handed out by the cache", gc);
+            return;
+        }
+        auto entry = gcs.find(key->second);
+        if(--entry->second.references == 0) {
+            xcb_free_gc(c, gc);
+            gcs.erase(entry);
+            keys.erase(key);
+        }
+    }
+
+    auto GCCache::stats() const -> GCCacheStats { return GCCacheStats{hits, misses, gcs.size()}; }
+
+    auto GCCache::metrics(xcb_gcontext_t gc) -> const draw::FontMetrics&
+    {
+        auto& font_entry = font(std::get<2>(keys.at(gc)));
+        if(!font_entry.metrics) {
+            if(cx::x11::X11Resource reply = xcb_query_font_reply(c, font_entry.query, nullptr); reply) {
+                font_entry.metrics = draw::FontMetrics::from_reply(reply);
+            } else {
+                cx::println("Could not query metrics of font {}. Text will not be aligned", font_entry.id);
+                font_entry.metrics = draw::FontMetrics{};
+            }
+        }
+        return *font_entry.metrics;
+    }
+
+    auto GCCache::font(std::string_view font_name) -> Font&
+    {
+        if(auto it = fonts.find(font_name); it != fonts.end())
+            return it->second;
+        auto font = xcb_generate_id(c);
+        errors->track(xcb_open_font(c, font, font_name.length(), font_name.data()),
+                      [](auto err) { cx::println("Could not open font. Error code: {}", err->error_code); });
+        // Ask for the metrics right away; the reply gets picked up whenever someone first needs to measure text in this font
+        auto query = xcb_query_font(c, font);
+        return fonts.emplace(std::string{font_name}, Font{font, query, std::nullopt}).first->second;
+    }
+} // namespace cx::x11
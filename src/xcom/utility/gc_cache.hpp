@@ -0,0 +1,64 @@
+#pragma once
+// System headers
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <xcb/xcb.h>
+
+// Library/Application headers
+#include <coreutils/core.hpp>
+#include <xcom/utility/drawing/font_metrics.hpp>
+#include <xcom/utility/error_tracker.hpp>
+
+namespace cx::x11
+{
+    struct GCCacheStats {
+        std::size_t hits;
+        std::size_t misses;
+        std::size_t live_gcs;
+    };
+
+    /// Hands out graphics contexts for drawing text, keyed by (foreground, background, font). Everyone asking for the same colors & font
+    /// shares one GC, which is freed once the last user has released it. Fonts are opened once and stay open for as long as the cache lives.
+    /// GCs are created on the root window, so they can be used to draw in any window on that screen with the root's depth
+    class GCCache
+    {
+      public:
+        GCCache(xcb_connection_t* c, xcb_window_t root, ErrorTracker* errors) noexcept;
+        ~GCCache();
+        GCCache(const GCCache&) = delete;
+        GCCache& operator=(const GCCache&) = delete;
+
+        /// Returns a GC for the colors & font, creating it if no one holds one already. Every acquire must be paired with a release
+        auto acquire(u32 fg_color, u32 bg_color, std::string_view font_name) -> xcb_gcontext_t;
+        void release(xcb_gcontext_t gc);
+        /// Metrics of the font gc draws with. The font is queried when it's opened, so the reply is usually in by the time we get here.
+        /// The metrics live as long as the cache does
+        auto metrics(xcb_gcontext_t gc) -> const draw::FontMetrics&;
+        [[nodiscard]] auto stats() const -> GCCacheStats;
+
+      private:
+        using Key = std::tuple<u32, u32, std::string>;
+        struct Entry {
+            xcb_gcontext_t gc;
+            std::size_t references;
+        };
+        struct Font {
+            xcb_font_t id;
+            xcb_query_font_cookie_t query;
+            std::optional<draw::FontMetrics> metrics;
+        };
+        auto font(std::string_view font_name) -> Font&;
+
+        xcb_connection_t* c;
+        xcb_window_t root;
+        ErrorTracker* errors;
+        std::map<Key, Entry> gcs{};
+        std::map<xcb_gcontext_t, Key> keys{};
+        std::map<std::string, Font, std::less<>> fonts{};
+        std::size_t hits = 0;
+        std::size_t misses = 0;
+    };
+} // namespace cx::x11
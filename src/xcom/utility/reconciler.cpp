@@ -0,0 +1,142 @@
+#include <xcom/utility/reconciler.hpp>
+
+#include <algorithm>
+
+namespace cx::x11
+{
+    Reconciler::Reconciler(xcb_connection_t* c, ErrorTracker* errors) noexcept : c(c), errors(errors) {}
+
+    void Reconciler::place(xcb_window_t window, const geom::Geometry& geometry)
+    {
+        auto& desired = desire(window).desired;
+        desired.x = geometry.x();
+        desired.y = geometry.y();
+        desired.width = geometry.width;
+        desired.height = geometry.height;
+    }
+
+    void Reconciler::resize(xcb_window_t window, geom::GU width, geom::GU height)
+    {
+        auto& desired = desire(window).desired;
+        desired.width = width;
+        desired.height = height;
+    }
+
+    void Reconciler::map(xcb_window_t window) { desire(window).desired.mapped = true; }
+
+    void Reconciler::unmap(xcb_window_t window) { desire(window).desired.mapped = false; }
+
+    void Reconciler::set_border_color(xcb_window_t window, u32 pixel) { desire(window).desired.border_pixel = pixel; }
+
+    void Reconciler::raise(xcb_window_t window) { desire(window).raise = true; }
+
+    void Reconciler::invalidate(xcb_window_t window)
+    {
+        if(auto it = windows.find(window); it != windows.end())
+            it->second.shadow = State{};
+        // It may have restacked itself as well
+        topmost = XCB_WINDOW_NONE;
+    }
+
+    void Reconciler::forget(xcb_window_t window)
+    {
+        windows.erase(window);
+        forgotten.push_back(window);
+        if(topmost == window)
+            topmost = XCB_WINDOW_NONE;
+    }
+
+    void Reconciler::manage(xcb_window_t window) { forgotten.erase(std::remove(forgotten.begin(), forgotten.end(), window), forgotten.end()); }
+
+    void Reconciler::commit()
+    {
+        for(auto window : queued) {
+            // Forgotten since it was queued
+            if(auto it = windows.find(window); it != windows.end())
+                reconcile(window, it->second);
+        }
+        queued.clear();
+        forgotten.clear();
+        xcb_flush(c);
+    }
+
+    auto Reconciler::stats() const -> ReconcilerStats { return ReconcilerStats{sent, suppressed}; }
+
+    auto Reconciler::desire(xcb_window_t window) -> Entry&
+    {
+        if(std::find(forgotten.begin(), forgotten.end(), window) != forgotten.end()) {
+            discarded = Entry{};
+            return discarded;
+        }
+        auto [it, inserted] = windows.try_emplace(window);
+        // A window we haven't seen before is most likely newly created, which puts it on top of everything
+        if(inserted)
+            topmost = XCB_WINDOW_NONE;
+        if(!it->second.queued) {
+            it->second.queued = true;
+            queued.push_back(window);
+        }
+        return it->second;
+    }
+
+    void Reconciler::reconcile(xcb_window_t window, Entry& entry)
+    {
+        auto& [shadow, desired, raise, is_queued] = entry;
+        // If the server says no, we no longer know what state the window is in
+        auto on_error = [this, window](auto err) {
+            DBGLOG("Failed to update window {}. Error code: {}", window, err->error_code);
+            invalidate(window);
+        };
+        auto count = [this](bool send) { send ? ++sent : ++suppressed; };
+
+        // Geometry & stacking share one ConfigureWindow request. Values go in the order of their bits in the mask
+        u16 mask = 0;
+        u32 values[5];
+        auto i = 0;
+        auto configure_field = [&](const std::optional<geom::GU>& want, std::optional<geom::GU>& known, u16 bit) {
+            if(want && want != known) {
+                mask |= bit;
+                values[i++] = static_cast<u32>(*want);
+                known = want;
+            }
+        };
+        const auto wants_configure = desired.x || desired.y || desired.width || desired.height || raise;
+        configure_field(desired.x, shadow.x, XCB_CONFIG_WINDOW_X);
+        configure_field(desired.y, shadow.y, XCB_CONFIG_WINDOW_Y);
+        configure_field(desired.width, shadow.width, XCB_CONFIG_WINDOW_WIDTH);
+        configure_field(desired.height, shadow.height, XCB_CONFIG_WINDOW_HEIGHT);
+        if(raise && topmost != window) {
+            mask |= XCB_CONFIG_WINDOW_STACK_MODE;
+            values[i++] = XCB_STACK_MODE_ABOVE;
+            topmost = window;
+        }
+        if(wants_configure) {
+            count(mask != 0);
+            if(mask != 0)
+                errors->track(xcb_configure_window(c, window, mask, values), on_error);
+        }
+
+        if(desired.border_pixel) {
+            auto send = desired.border_pixel != shadow.border_pixel;
+            count(send);
+            if(send) {
+                errors->track(xcb_change_window_attributes(c, window, XCB_CW_BORDER_PIXEL, &*desired.border_pixel), on_error);
+                shadow.border_pixel = desired.border_pixel;
+            }
+        }
+
+        // Mapping comes last, so the window shows up where it's supposed to be
+        if(desired.mapped) {
+            auto send = desired.mapped != shadow.mapped;
+            count(send);
+            if(send) {
+                errors->track(*desired.mapped ? xcb_map_window(c, window) : xcb_unmap_window(c, window), on_error);
+                shadow.mapped = desired.mapped;
+            }
+        }
+
+        desired = State{};
+        raise = false;
+        is_queued = false;
+    }
+} // namespace cx::x11
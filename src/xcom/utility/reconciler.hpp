@@ -0,0 +1,82 @@
+#pragma once
+// System headers
+#include <optional>
+#include <unordered_map>
+#include <vector>
+#include <xcb/xcb.h>
+
+// Library/Application headers
+#include <coreutils/core.hpp>
+#include <datastructure/geometry.hpp>
+#include <xcom/utility/error_tracker.hpp>
+
+namespace cx::x11
+{
+    struct ReconcilerStats {
+        /// Requests that went out to the X server
+        std::size_t sent;
+        /// Requests that would have gone out, had we not known the server already has that state
+        std::size_t suppressed;
+    };
+
+    /// Keeps a shadow of what we last told the X server about each window: geometry, map state, border color & whether it's on top.
+    /// Commands say what they want a window to look like; on commit that is compared against the shadow and only what differs gets sent,
+    /// followed by a single flush. Whoever changes a window behind the reconciler's back, must invalidate it
+    class Reconciler
+    {
+      public:
+        Reconciler(xcb_connection_t* c, ErrorTracker* errors) noexcept;
+        Reconciler(const Reconciler&) = delete;
+        Reconciler& operator=(const Reconciler&) = delete;
+
+        /// Position & size of a top level window, i.e. a frame
+        void place(xcb_window_t window, const geom::Geometry& geometry);
+        /// Size only; for windows positioned relative to their parent, i.e. a client inside its frame
+        void resize(xcb_window_t window, geom::GU width, geom::GU height);
+        void map(xcb_window_t window);
+        void unmap(xcb_window_t window);
+        void set_border_color(xcb_window_t window, u32 pixel);
+        /// Puts window on top of its siblings
+        void raise(xcb_window_t window);
+
+        /// Someone else changed window; whatever is wanted of it next, gets sent as is
+        void invalidate(xcb_window_t window);
+        /// The window is gone. Drops both the shadow and whatever changes were still pending for it. Until the next commit (or manage()),
+        /// whatever is still wanted of it is ignored; commands queued before it went, still have a copy of it
+        void forget(xcb_window_t window);
+        /// The window is ours again, i.e. framed anew after it was forgotten in the same iteration; what's wanted of it counts again
+        void manage(xcb_window_t window);
+        /// Sends the difference between desired & known state of every window touched since the last commit, then flushes
+        void commit();
+        [[nodiscard]] auto stats() const -> ReconcilerStats;
+
+      private:
+        /// A field without value is not known (shadow) or not asked for (desired)
+        struct State {
+            std::optional<geom::GU> x, y, width, height;
+            std::optional<bool> mapped;
+            std::optional<u32> border_pixel;
+        };
+        struct Entry {
+            State shadow;
+            State desired;
+            bool raise = false;
+            bool queued = false;
+        };
+        auto desire(xcb_window_t window) -> Entry&;
+        void reconcile(xcb_window_t window, Entry& entry);
+
+        xcb_connection_t* c;
+        ErrorTracker* errors;
+        std::unordered_map<xcb_window_t, Entry> windows{};
+        /// Windows with pending changes, in the order they were first touched
+        std::vector<xcb_window_t> queued{};
+        /// Windows forgotten since the last commit, & where changes to them go, to be thrown away
+        std::vector<xcb_window_t> forgotten{};
+        Entry discarded{};
+        /// The window we last raised, if nothing has been put above it since
+        xcb_window_t topmost = XCB_WINDOW_NONE;
+        std::size_t sent = 0;
+        std::size_t suppressed = 0;
+    };
+} // namespace cx::x11
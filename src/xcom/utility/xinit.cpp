@@ -72,6 +72,19 @@ namespace cx::x11
                           mp(KM::SUPER_CTRL, XK_Up), mp(KM::SUPER_CTRL, XK_Down), mp(KM::SUPER_SHIFT, XK_Q));
     }
 
+    void grab_key(XCBConn* conn, XCBWindow root, xcb_key_symbols_t* symbols, u16 modifier, xcb_keysym_t keysym)
+    {
+        auto key_codes = xcb_key_symbols_get_keycode(symbols, keysym);
+        if(key_codes) {
+            auto pos = 0;
+            while(key_codes[pos] != XCB_NO_SYMBOL) {
+                xcb_grab_key(conn, 1, root, modifier, key_codes[pos], XCB_GRAB_MODE_ASYNC, XCB_GRAB_MODE_ASYNC);
+                pos++;
+            }
+        }
+        free(key_codes);
+    }
+
     void setup_key_press_listening(XCBConn* conn, XCBWindow root)
     {
         namespace KM = xcb_key_masks;
@@ -80,15 +93,7 @@ namespace cx::x11
 
         std::for_each(std::begin(bindings), std::end(bindings), [&](auto& binding) {
             auto& [modifier, keysym] = binding;
-            auto key_codes = xcb_key_symbols_get_keycode(keysyms_data, keysym);
-            if(key_codes) {
-                auto pos = 0;
-                while(key_codes[pos] != XCB_NO_SYMBOL) {
-                    xcb_grab_key(conn, 1, root, modifier, key_codes[pos], XCB_GRAB_MODE_ASYNC, XCB_GRAB_MODE_ASYNC);
-                    pos++;
-                }
-            }
-            free(key_codes);
+            grab_key(conn, root, keysyms_data, modifier, keysym);
         });
         free(keysyms_data);
     }
@@ -112,27 +117,4 @@ namespace cx::x11
             return {};
         }
     }
-    auto get_font_gc(XCBConn* c, XCBWindow window, cx::u32 fg_color, cx::u32 bg_color, std::string_view font_name) -> std::optional<xcb_gcontext_t>
-    {
-        auto font = xcb_generate_id(c);
-        auto font_cookie = xcb_open_font_checked(c, font, font_name.length(), font_name.data());
-        if(auto err = xcb_request_check(c, font_cookie); err) {
-            cx::println("Could not open font. Error code: {}", err->error_code);
-            return {};
-        }
-        auto gfx_context = xcb_generate_id(c);
-        auto mask = XCB_GC_FOREGROUND | XCB_GC_BACKGROUND | XCB_GC_FONT;
-        uint32_t v_list[]{fg_color, bg_color, font};
-        auto gc_cookie = xcb_create_gc_checked(c, gfx_context, window, mask, v_list);
-        if(auto err = xcb_request_check(c, gc_cookie); err) {
-            cx::println("Could not create graphics context. Error code {}", err->error_code);
-            return {};
-        }
-        font_cookie = xcb_close_font_checked(c, font);
-        if(auto err = xcb_request_check(c, font_cookie); err) {
-            cx::println("Could not close font. Error code: {}", err->error_code);
-            return {};
-        }
-        return std::make_optional(gfx_context);
-    }
 } // namespace cx::x11
\ No newline at end of file
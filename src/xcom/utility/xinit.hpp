@@ -16,6 +16,7 @@
 #include <X11/keysym.h>
 #include <X11/keysymdef.h>
 #include "raii.hpp"
+#include "atoms.hpp"
 
 
 
@@ -33,50 +34,15 @@ namespace cx::x11
         [[maybe_unused]] void print_modifiers(std::uint32_t mask);
     }
 
-    static constexpr std::string_view atom_names[]{"_NET_SUPPORTED",
-                                                   "_NET_SUPPORTING_WM_CHECK",
-                                                   "_NET_WM_NAME",
-                                                   "_NET_WM_VISIBLE_NAME",
-                                                   "_NET_WM_MOVERESIZE",
-                                                   "_NET_WM_STATE_STICKY",
-                                                   "_NET_WM_STATE_FULLSCREEN",
-                                                   "_NET_WM_STATE_DEMANDS_ATTENTION",
-                                                   "_NET_WM_STATE_MODAL",
-                                                   "_NET_WM_STATE_HIDDEN",
-                                                   "_NET_WM_STATE_FOCUSED",
-                                                   "_NET_WM_STATE",
-                                                   "_NET_WM_WINDOW_TYPE",
-                                                   "_NET_WM_WINDOW_TYPE_NORMAL",
-                                                   "_NET_WM_WINDOW_TYPE_DOCK",
-                                                   "_NET_WM_WINDOW_TYPE_DIALOG",
-                                                   "_NET_WM_WINDOW_TYPE_UTILITY",
-                                                   "_NET_WM_WINDOW_TYPE_TOOLBAR",
-                                                   "_NET_WM_WINDOW_TYPE_SPLASH",
-                                                   "_NET_WM_WINDOW_TYPE_MENU",
-                                                   "_NET_WM_WINDOW_TYPE_DROPDOWN_MENU",
-                                                   "_NET_WM_WINDOW_TYPE_POPUP_MENU",
-                                                   "_NET_WM_WINDOW_TYPE_TOOLTIP",
-                                                   "_NET_WM_WINDOW_TYPE_NOTIFICATION",
-                                                   "_NET_WM_DESKTOP",
-                                                   "_NET_WM_STRUT_PARTIAL",
-                                                   "_NET_CLIENT_LIST",
-                                                   "_NET_CLIENT_LIST_STACKING",
-                                                   "_NET_CURRENT_DESKTOP",
-                                                   "_NET_NUMBER_OF_DESKTOPS",
-                                                   "_NET_DESKTOP_NAMES",
-                                                   "_NET_DESKTOP_VIEWPORT",
-                                                   "_NET_ACTIVE_WINDOW",
-                                                   "_NET_CLOSE_WINDOW",
-                                                   "_NET_MOVERESIZE_WINDOW"};
-
     using XCBConn = xcb_connection_t;
     using XCBScreen = xcb_screen_t;
     using XCBDrawable = xcb_drawable_t;
     using XCBWindow = xcb_window_t;
 
     struct XInternals {
-        XInternals(XCBConn* c, XCBScreen* scr, XCBDrawable rd, XCBWindow w, XCBWindow ewmh, xcb_key_symbols_t* symbols, int fd)
-            : c(c), screen(scr), root_drawable(rd), root_window(w), ewmh_window(ewmh), keysyms(symbols), xcb_file_descriptor(fd)
+        XInternals(XCBConn* c, XCBScreen* scr, XCBDrawable rd, XCBWindow w, XCBWindow ewmh, xcb_key_symbols_t* symbols, int fd,
+                   Atoms atoms)
+            : c(c), screen(scr), root_drawable(rd), root_window(w), ewmh_window(ewmh), keysyms(symbols), xcb_file_descriptor(fd), atoms(atoms)
         {
         }
         ~XInternals() { free(keysyms); }
@@ -87,6 +53,7 @@ namespace cx::x11
         XCBWindow ewmh_window;
         xcb_key_symbols_t* keysyms;
         int xcb_file_descriptor;
+        Atoms atoms;
     };
 
     // Yanked from the define in i3, to be used for our root window as well
@@ -114,21 +81,8 @@ namespace cx::x11
     void setup_mouse_button_request_handling(XCBConn* conn, XCBWindow window);
 
     void setup_key_press_listening(XCBConn* conn, XCBWindow root);
-
-    // TODO(implement): Get all 35 atoms that i3 support, and filter out the ones we probably won't need
-    template<typename StrView, std::size_t N>
-    auto get_supported_atoms(XCBConn* c, const StrView (&names)[N] = atom_names) -> std::array<xcb_atom_t, N>
-    {
-        std::array<xcb_atom_t, N> atoms{};
-        std::transform(std::begin(names), std::begin(names) + N, std::begin(atoms), [c](auto str) {
-            auto cookie = xcb_intern_atom(c, 0, str.size(), str.data());
-            cx::x11::X11Resource resource = xcb_intern_atom_reply(c, cookie, nullptr);
-            return resource->atom;
-        });
-        return atoms;
-    }
+    /// Grabs every key code that produces keysym, with modifier held, so that we get the key presses instead of whichever client has focus
+    void grab_key(XCBConn* conn, XCBWindow root, xcb_key_symbols_t* symbols, u16 modifier, xcb_keysym_t keysym);
 
     auto get_client_wm_name(XCBConn* c, xcb_window_t window) -> std::optional<std::string>;
-    // NOTE: On linux type xlsfonts to list X font names, that can be used as font_name
-    auto get_font_gc(XCBConn* c, XCBWindow window, u32 fg_color, u32 bg_color, std::string_view font_name) -> std::optional<xcb_gcontext_t>;
 } // namespace cx::x11
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 #include "configuration.hpp"
 #include <datastructure/geometry.hpp>
+#include <xcom/utility/drawing/font_metrics.hpp>
 #include <string>
 #include <xcb/xcb.h>
 
@@ -25,6 +26,8 @@ namespace cx::workspace
         xcb_window_t frame_id;            /// id of our frame, that holds client application window
         Tag m_tag;
         cx::cfg::Configuration configuration;
+        xcb_gcontext_t title_gc = XCB_NONE; /// shared GC from the GCCache, released when the window gets unframed
+        const draw::FontMetrics* title_metrics = nullptr; /// metrics of the font title_gc draws with, owned by the GCCache
 
         void set_geometry(geom::Geometry g) noexcept;
         friend bool operator==(const Window& lhs, const Window& rhs) { return lhs.client_id == rhs.client_id && lhs.frame_id == rhs.frame_id; }
@@ -8,10 +8,10 @@
 
 namespace cx::workspace
 {
-    Workspace::Workspace(cx::uint ws_id, std::string ws_name, cx::geom::Geometry space) noexcept
-        : m_id(ws_id), m_name(std::move(ws_name)), m_space(space),
+    Workspace::Workspace(cx::uint ws_id, std::string ws_name, cx::geom::Geometry space, WindowIndex* index) noexcept
+        : m_id(ws_id), m_name(std::move(ws_name)), m_space(space), is_pristine(true),
           m_containers(nullptr), m_floating_containers{}, m_root{ContainerTree::make_root("root container", space, Layout::Horizontal)},
-          foc_con(nullptr), is_pristine(true)
+          foc_con(nullptr), index(index)
     {
         // std::make_unique<ContainerTree>("root container", geom::Geometry::default_new())
         foc_con = m_root.get();
@@ -24,11 +24,15 @@ namespace cx::workspace
         if(tiled) {
             if(!foc_con->is_window()) {
                 foc_con->push_client(window);
+                index->assign(window.client_id, window.frame_id, this, foc_con);
                 return commands::ConfigureWindows{foc_con->client.value()};
             } else {
                 foc_con->push_client(window);
                 auto existing_win = foc_con->left->client.value();
                 auto new_win = foc_con->right->client.value();
+                // The node foc_con was is now a split container; the window it held, moved down into its left child
+                index->assign(existing_win.client_id, existing_win.frame_id, this, foc_con->left.get());
+                index->assign(new_win.client_id, new_win.frame_id, this, foc_con->right.get());
                 foc_con = foc_con->right.get();
                 return commands::ConfigureWindows{existing_win, new_win};
             }
@@ -44,6 +48,8 @@ namespace cx::workspace
         auto& right_sibling = t->parent->right;
         bool set_new_focus = (foc_con == t);
         if(t->is_window()) {
+            // Promoting & re-anchoring moves the sibling's node as a whole, so nodes of the remaining windows keep their addresses
+            index->erase(t->client->client_id, t->client->frame_id);
             if(left_sibling && right_sibling) {
                 if(!t->parent->is_root()) {
                     if(left_sibling.get() == t) {
@@ -69,7 +75,7 @@ namespace cx::workspace
                         anchor_new_root(std::move(t->parent->left), root_tag);
                         right_sibling.reset();
                     }
-                    m_root->update_subtree_geometry();
+                    m_root->mark_dirty();
                 }
             } else {
                 auto root_tag = m_root->tag;
@@ -84,36 +90,28 @@ namespace cx::workspace
 
     auto Workspace::find_window(xcb_window_t xwin) -> std::optional<ContainerTree*>
     {
-        return tree_in_order_find(m_root, [xwin](auto& c_tree) {
-            if(c_tree->is_window())
-                return c_tree->client->client_id == xwin || c_tree->client->frame_id == xwin;
-            else
-                return false;
-        });
+        if(auto location = index->find(xwin); location && location->workspace == this)
+            return location->node;
+        return {};
     }
 
-    auto Workspace::display_update(xcb_connection_t* c) -> void
+    auto Workspace::display_update(x11::Reconciler& x) -> void
     {
-        auto mapper = [c](auto& window) {
-            // auto window = window_opt;
-            namespace xcm = cx::xcb_config_masks;
-            const auto& [x, y, width, height] = window.geometry.xcb_value_list();
-            auto frame_properties = xcm::TELEPORT;
-            auto child_properties = xcm::RESIZE;
-            cx::uint frame_values[] = {(cx::uint)x, (cx::uint)y, (cx::uint)width, (cx::uint)height};
-            cx::uint child_values[] = {(cx::uint)width, (cx::uint)height};
-            auto cookies = std::array<xcb_void_cookie_t, 2>{xcb_configure_window_checked(c, window.frame_id, frame_properties, frame_values),
-                                                            xcb_configure_window_checked(c, window.client_id, child_properties, child_values)};
-            for(const auto& cookie : cookies) {
-                if(auto err = xcb_request_check(c, cookie); err) {
-                    DBGLOG("Failed to configure item {}. Error code: {}", err->resource_id, err->error_code);
-                }
-            }
+        auto mapper = [&x](auto& window) {
+            x.place(window.frame_id, window.geometry);
+            x.resize(window.client_id, window.geometry.width, window.geometry.height);
         };
         in_order_window_map(m_root, mapper);
         std::for_each(m_floating_containers.begin(), m_floating_containers.end(), mapper);
     }
 
+    auto Workspace::layout() -> std::vector<ContainerTree*>
+    {
+        std::vector<ContainerTree*> changed_windows{};
+        m_root->layout(changed_windows);
+        return changed_windows;
+    }
+
     void Workspace::rotate_focus_layout() const { foc_con->rotate_container_layout(); }
 
     void Workspace::rotate_focus_pair() const { foc_con->rotate_children(); }
@@ -122,126 +120,112 @@ namespace cx::workspace
     {
         return commands::MoveWindow{foc_con->client.value(), dir, this};
     }
-    auto Workspace::increase_size_focused(cx::events::ResizeArgument arg) -> commands::UpdateWindows
+    auto Workspace::increase_size_focused(cx::events::ResizeArgument arg) -> bool
     {
         using Dir = geom::ScreenSpaceDirection;
         using Vector = Pos; // To just illustrate further what Pos actually represents in this function
         switch(arg.dir) {
         case Dir::UP: {
-            auto items = increase_height(
+            return increase_height(
                 arg.get_value(), [](auto& child, auto& parent) { return parent->policy == Layout::Vertical && parent->right.get() == child; });
-            return commands::UpdateWindows{items};
         }
         case Dir::DOWN: {
-            auto items = increase_height(arg.get_value(),
-                                         [](auto& child, auto& parent) { return parent->policy == Layout::Vertical && parent->left.get() == child; });
-            return commands::UpdateWindows{items};
+            return increase_height(arg.get_value(),
+                                   [](auto& child, auto& parent) { return parent->policy == Layout::Vertical && parent->left.get() == child; });
         }
         case Dir::LEFT: {
-            auto items = increase_width(
+            return increase_width(
                 arg.get_value(), [](auto& child, auto& parent) { return parent->policy == Layout::Horizontal && parent->right.get() == child; });
-            return commands::UpdateWindows{items};
         }
         case Dir::RIGHT: {
-            auto items = increase_width(
+            return increase_width(
                 arg.get_value(), [](auto& child, auto& parent) { return parent->policy == Layout::Horizontal && parent->left.get() == child; });
-            return commands::UpdateWindows{items};
         }
         }
     }
 
-    auto Workspace::decrease_size_focused(cx::events::ResizeArgument arg) -> commands::UpdateWindows
+    auto Workspace::decrease_size_focused(cx::events::ResizeArgument arg) -> bool
     {
         using Dir = geom::ScreenSpaceDirection;
         using Vector = Pos; // To just illustrate further what Pos actually represents in this function
         switch(arg.dir) {
         case Dir::UP: {
-            auto items = decrease_height(
+            return decrease_height(
                 arg.get_value(), [](auto& child, auto& parent) { return parent->policy == Layout::Vertical && parent->right.get() == child; });
-            return commands::UpdateWindows{items};
         }
         case Dir::DOWN: {
-            auto items = decrease_height(arg.get_value(),
-                                         [](auto& child, auto& parent) { return parent->policy == Layout::Vertical && parent->left.get() == child; });
-            return commands::UpdateWindows{items};
+            return decrease_height(arg.get_value(),
+                                   [](auto& child, auto& parent) { return parent->policy == Layout::Vertical && parent->left.get() == child; });
         }
         case Dir::LEFT: {
-            auto items = decrease_width(
+            return decrease_width(
                 arg.get_value(), [](auto& child, auto& parent) { return parent->policy == Layout::Horizontal && parent->right.get() == child; });
-            return commands::UpdateWindows{items};
         }
         case Dir::RIGHT: {
-            auto items = decrease_width(
+            return decrease_width(
                 arg.get_value(), [](auto& child, auto& parent) { return parent->policy == Layout::Horizontal && parent->left.get() == child; });
-            return commands::UpdateWindows{items};
         }
         }
     }
 
     template<typename Predicate>
-    auto Workspace::increase_width(int steps, Predicate child_of) -> std::vector<ContainerTree*>
+    auto Workspace::increase_width(int steps, Predicate child_of) -> bool
     {
         auto [child, parent] = focused().begin_bubble();
         for(; !child->is_root(); next_up(child, parent)) {
             if(child_of(child, parent)) { // Means it is this "parent" that needs a _decrease_ in size from it's left
                 parent->split_position.x += steps;
-                parent->update_subtree_geometry();
-                return collect_treenodes_by(parent, [](auto& t) { return t->is_window(); });
+                parent->mark_dirty();
+                return true;
             }
         }
-        return {};
+        return false;
     }
     template<typename Predicate>
-    auto Workspace::increase_height(int steps, Predicate child_of) -> std::vector<ContainerTree*>
+    auto Workspace::increase_height(int steps, Predicate child_of) -> bool
     {
         /// this would otherwise become:
         /// auto child = foc_con; auto parent = foc_con->parent;
         for(auto [child, parent] = focused().begin_bubble(); !child->is_root(); next_up(child, parent)) {
             if(child_of(child, parent)) { // Means it is this "parent" that needs a _decrease_ in size from it's left
                 parent->split_position.y += steps;
-                parent->update_subtree_geometry();
-                return collect_treenodes_by(parent, [](auto& t) { return t->is_window(); });
+                parent->mark_dirty();
+                return true;
             }
         }
-        return std::vector<ContainerTree*>{};
+        return false;
     }
     template<typename Predicate>
-    auto Workspace::decrease_width(int steps, Predicate child_of) -> std::vector<ContainerTree*>
+    auto Workspace::decrease_width(int steps, Predicate child_of) -> bool
     {
         auto [child, parent] = focused().begin_bubble();
         for(; !child->is_root(); next_up(child, parent)) {
             if(child_of(child, parent)) { // Means it is this "parent" that needs a _decrease_ in size from it's left
                 parent->split_position.x -= steps;
-                parent->update_subtree_geometry();
-                return collect_treenodes_by(parent, [](auto& t) { return t->is_window(); });
+                parent->mark_dirty();
+                return true;
             }
         }
-        return std::vector<ContainerTree*>{};
+        return false;
     }
     template<typename Predicate>
-    auto Workspace::decrease_height(int steps, Predicate child_of) -> std::vector<ContainerTree*>
+    auto Workspace::decrease_height(int steps, Predicate child_of) -> bool
     {
         /// this would otherwise become:
         /// auto child = foc_con; auto parent = foc_con->parent;
         for(auto [child, parent] = focused().begin_bubble(); !child->is_root(); next_up(child, parent)) {
             if(child_of(child, parent)) { // Means it is this "parent" that needs a _decrease_ in size from it's left
                 parent->split_position.y -= steps;
-                parent->update_subtree_geometry();
-                return collect_treenodes_by(parent, [](auto& t) { return t->is_window(); });
+                parent->mark_dirty();
+                return true;
             }
         }
-        return std::vector<ContainerTree*>{};
+        return false;
     }
 
     std::optional<commands::FocusWindow> Workspace::focus_client_with_xid(const xcb_window_t xwin)
     {
-        auto c = tree_in_order_find(m_root, [xwin](auto& tree) {
-            if(tree->is_window()) {
-                return tree->client->client_id == xwin || tree->client->frame_id == xwin;
-            }
-            return false;
-        });
-        if(c) {
+        if(auto c = find_window(xwin); c) {
             auto client = c.value()->client.value();
             DBGLOG("Focused client: [Frame: {}, Client: {}] @ (x:{},y:{}) (w:{} x h:{})", client.frame_id, client.client_id, client.geometry.x(),
                    client.geometry.y(), client.geometry.width, client.geometry.height);
@@ -285,12 +269,8 @@ namespace cx::workspace
         m_root = std::move(new_root);
         m_root->tag = tag;
         m_root->geometry = m_space;
-        if(m_root->is_window()) { // means we have 1 window, full screened
-            m_root->client->set_geometry(m_space);
-            m_root->parent = m_root.get();
-        } else {
-            m_root->geometry = m_space;
-            m_root->parent = m_root.get();
-        }
+        m_root->parent = m_root.get();
+        // If it's a window, it's the only one left, and gets the entire workspace
+        m_root->mark_dirty();
     }
 }; // namespace cx::workspace
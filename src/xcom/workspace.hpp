@@ -8,6 +8,7 @@
 #include <coreutils/core.hpp>
 #include <datastructure/container.hpp>
 #include <datastructure/geometry.hpp>
+#include <datastructure/window_index.hpp>
 #include <xcom/commands/manager_command.hpp>
 #include <xcom/constants.hpp>
 #include <xcom/events.hpp>
@@ -27,7 +28,7 @@ namespace cx::workspace
         using Pos = geom::Position;
         using TreeOwned = ContainerTree::TreeOwned;
         // Constructors & initializers
-        Workspace(cx::uint ws_id, std::string ws_name, cx::geom::Geometry space) noexcept;
+        Workspace(cx::uint ws_id, std::string ws_name, cx::geom::Geometry space, WindowIndex* index) noexcept;
         // This destructor has to be handled... very well defined. When we throw away a workspace, where will the windows end up?
         Workspace(Workspace&&) noexcept = default;
         ~Workspace() noexcept = default;
@@ -41,6 +42,8 @@ namespace cx::workspace
         std::vector<Window> m_floating_containers;
         std::unique_ptr<ContainerTree> m_root;
         ContainerTree* foc_con;
+        /// Shared by all workspaces; kept up to date with where in m_root each of our windows lives
+        WindowIndex* index;
         [[nodiscard]] constexpr inline auto& focused() const { return *foc_con; }
 
         /**
@@ -49,37 +52,41 @@ namespace cx::workspace
          */
         auto register_window(Window w, bool tiled = true) -> std::optional<commands::ConfigureWindows>;
         auto unregister_window(ContainerTree* t) -> void;
-        /// Searches the ContainerTree in order, for a window with the id of xwin
+        /// Looks up the tree node of xwin (client or frame id) in the window index. Returns nothing if xwin lives on another workspace
         auto find_window(xcb_window_t xwin) -> std::optional<ContainerTree*>;
         template <typename Fn>
         auto find_window_then(xcb_window_t xwin, Fn then) -> void {
-            find_window_and_then(m_root, xwin, std::move(then));
+            if(auto node = find_window(xwin); node)
+                then(node.value()->client.value());
         }
-        /// Traverses the ContainerTree for this workspace in order, and calls xcb_configure for each window with
-        /// the properties stored in each ws::Window, updating the display so that any and all changes made, will show up on screen
-        auto display_update(xcb_connection_t* c) -> void;
+        /// Traverses the ContainerTree for this workspace in order, and hands the geometry stored in each ws::Window to the reconciler,
+        /// so that any and all changes made, will show up on screen on the next commit
+        auto display_update(x11::Reconciler& x) -> void;
+        /// Runs the layout pass over the dirty parts of the tree. Returns the window nodes whose geometry changed
+        auto layout() -> std::vector<ContainerTree*>;
         /// rotates the focused client tile-pair layouts
         void rotate_focus_layout() const;
         /// rotates the focused client tile-pair positions
         void rotate_focus_pair() const;
         // This moves this window from it's anchor, in vector's dir.
         auto move_focused(geom::ScreenSpaceDirection dir) -> commands::MoveWindow;
-        /// Increases width or height of window, in all four directions, depending on the parameter arg
-        auto increase_size_focused(cx::events::ResizeArgument arg) -> commands::UpdateWindows;
+        /// Increases width or height of window, in all four directions, depending on the parameter arg. Returns false if there was no split
+        /// to move. The windows affected get reconfigured in the next layout pass
+        auto increase_size_focused(cx::events::ResizeArgument arg) -> bool;
         /// Decreases width or height of window, in all four directions, depending on the parameter arg
-        auto decrease_size_focused(cx::events::ResizeArgument arg) -> commands::UpdateWindows;
+        auto decrease_size_focused(cx::events::ResizeArgument arg) -> bool;
         // Depending if sp_dir is negative or positive, determines what direction (left/right) the width will be increased to
         template<typename Predicate>
-        auto increase_width(int sp_dir, Predicate child_of) -> std::vector<ContainerTree*>;
+        auto increase_width(int sp_dir, Predicate child_of) -> bool;
 
         template<typename Predicate>
-        auto increase_height(int sp_dir, Predicate child_of) -> std::vector<ContainerTree*>;
+        auto increase_height(int sp_dir, Predicate child_of) -> bool;
 
         template<typename Predicate>
-        auto decrease_height(int sp_dir, Predicate child_of) -> std::vector<ContainerTree*>;
+        auto decrease_height(int sp_dir, Predicate child_of) -> bool;
 
         template<typename Predicate>
-        auto decrease_width(int sp_dir, Predicate child_of) -> std::vector<ContainerTree*>;
+        auto decrease_width(int sp_dir, Predicate child_of) -> bool;
 
         std::optional<commands::FocusWindow> focus_client_with_xid(const xcb_window_t xwin);
 
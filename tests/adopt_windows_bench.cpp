@@ -0,0 +1,114 @@
+// Measures what adopting pre-existing windows costs, when properties are queried one window at a time, versus in one pipelined batch.
+// Run it against a throw away X server, with no WM running:
+//      Xvfb :99 & DISPLAY=:99 ./adopt_windows_bench 200
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <xcb/xcb.h>
+
+#include <xcom/utility/client_query.hpp>
+
+using namespace std::chrono;
+
+/// A round trip is spent every time we block on a reply for a request that went out after we last blocked. Replies for requests
+/// sent in the same burst as the one we waited on, are already sitting in xcb's queue
+struct RoundTripCounter {
+    void wait_for(unsigned sequence)
+    {
+        if(sequence > awaited) {
+            ++round_trips;
+            awaited = last_sent;
+        }
+    }
+    void sent(unsigned sequence) { last_sent = sequence; }
+    unsigned awaited = 0;
+    unsigned last_sent = 0;
+    int round_trips = 0;
+};
+
+auto create_windows(xcb_connection_t* c, xcb_screen_t* screen, int count) -> std::vector<xcb_window_t>
+{
+    std::vector<xcb_window_t> windows;
+    for(auto i = 0; i < count; ++i) {
+        auto w = xcb_generate_id(c);
+        xcb_create_window(c, XCB_COPY_FROM_PARENT, w, screen->root, (i * 3) % 700, (i * 7) % 500, 100, 100, 1, XCB_WINDOW_CLASS_INPUT_OUTPUT,
+                          screen->root_visual, 0, nullptr);
+        auto name = "bench window " + std::to_string(i);
+        xcb_change_property(c, XCB_PROP_MODE_REPLACE, w, XCB_ATOM_WM_NAME, XCB_ATOM_STRING, 8, name.size(), name.c_str());
+        xcb_map_window(c, w);
+        windows.push_back(w);
+    }
+    // Make sure the server has mapped every window before we start measuring
+    cx::x11::X11Resource sync = xcb_get_input_focus_reply(c, xcb_get_input_focus(c), nullptr);
+    return windows;
+}
+
+/// What framing did before; the next window isn't asked about until the previous one's replies are in
+auto adopt_one_by_one(xcb_connection_t* c, xcb_window_t root, const cx::x11::Atoms& atoms) -> std::pair<int, std::size_t>
+{
+    RoundTripCounter counter{};
+    auto tree_cookie = xcb_query_tree(c, root);
+    counter.sent(tree_cookie.sequence);
+    counter.wait_for(tree_cookie.sequence);
+    cx::x11::X11Resource tree = xcb_query_tree_reply(c, tree_cookie, nullptr);
+    auto children = xcb_query_tree_children(tree);
+    std::size_t viewable = 0;
+    for(auto i = 0; i < xcb_query_tree_children_length(tree); ++i) {
+        auto query = cx::x11::request_client_properties(c, children[i], atoms);
+        counter.sent(query.window_type.sequence);
+        counter.wait_for(query.attributes.sequence);
+        if(auto client = cx::x11::collect_client_properties(c, query, atoms); client && client->map_state == XCB_MAP_STATE_VIEWABLE)
+            ++viewable;
+    }
+    return {counter.round_trips, viewable};
+}
+
+/// What Manager::adopt_existing_windows does
+auto adopt_batched(xcb_connection_t* c, xcb_window_t root, const cx::x11::Atoms& atoms) -> std::pair<int, std::size_t>
+{
+    RoundTripCounter counter{};
+    auto tree_cookie = xcb_query_tree(c, root);
+    counter.sent(tree_cookie.sequence);
+    counter.wait_for(tree_cookie.sequence);
+    cx::x11::X11Resource tree = xcb_query_tree_reply(c, tree_cookie, nullptr);
+    auto children = xcb_query_tree_children(tree);
+    std::vector<cx::x11::ClientQuery> queries;
+    for(auto i = 0; i < xcb_query_tree_children_length(tree); ++i) {
+        queries.push_back(cx::x11::request_client_properties(c, children[i], atoms));
+        counter.sent(queries.back().window_type.sequence);
+    }
+    std::size_t viewable = 0;
+    for(const auto& query : queries) {
+        counter.wait_for(query.attributes.sequence);
+        if(auto client = cx::x11::collect_client_properties(c, query, atoms); client && client->map_state == XCB_MAP_STATE_VIEWABLE)
+            ++viewable;
+    }
+    return {counter.round_trips, viewable};
+}
+
+int main(int argc, const char** argv)
+{
+    auto count = argc > 1 ? std::atoi(argv[1]) : 200;
+    auto c = xcb_connect(nullptr, nullptr);
+    if(xcb_connection_has_error(c)) {
+        cx::println("Could not connect to X server. Is DISPLAY pointing at an Xvfb instance?");
+        return 1;
+    }
+    auto screen = xcb_setup_roots_iterator(xcb_get_setup(c)).data;
+    auto atoms = cx::x11::Atoms::intern(c);
+    auto windows = create_windows(c, screen, count);
+
+    auto measure = [&](auto name, auto adopt) {
+        auto start = steady_clock::now();
+        auto [round_trips, viewable] = adopt(c, screen->root, atoms);
+        auto elapsed = duration_cast<microseconds>(steady_clock::now() - start).count();
+        cx::println("{:<12} {} viewable windows: {} round trips, {}us", name, viewable, round_trips, elapsed);
+    };
+    measure("one by one", adopt_one_by_one);
+    measure("batched", adopt_batched);
+
+    for(auto w : windows)
+        xcb_destroy_window(c, w);
+    xcb_disconnect(c);
+}
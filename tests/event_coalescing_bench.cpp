@@ -0,0 +1,151 @@
+// What's left of an event storm, once the event batch has merged away what's redundant. No X server needed; the events are made up: a
+// number of windows with a terminal's worth of WM_NAME changes each, a few series of Exposes & a client that configures itself one field
+// at a time, with key presses in between, & a MapRequest halfway, which nothing may be merged across. Key presses have to come out
+// first, in order; then everything that came in before the MapRequest, then it, then the rest. Then the same storm over & over, for what
+// pushing & dispatching costs per event.
+//      ./event_coalescing_bench [windows = 20]
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+#include <xcb/xcb.h>
+
+#include <coreutils/core.hpp>
+#include <xcom/utility/event_batch.hpp>
+
+using namespace std::chrono;
+
+template<typename Event>
+auto make(std::uint8_t type) -> Event*
+{
+    // xcb hands out events of at least 32 bytes & the full sequence
+    auto event = static_cast<Event*>(std::calloc(1, std::max(sizeof(Event), sizeof(xcb_generic_event_t))));
+    event->response_type = type;
+    return event;
+}
+
+auto property(xcb_window_t window, xcb_atom_t atom) -> xcb_generic_event_t*
+{
+    auto e = make<xcb_property_notify_event_t>(XCB_PROPERTY_NOTIFY);
+    e->window = window;
+    e->atom = atom;
+    return reinterpret_cast<xcb_generic_event_t*>(e);
+}
+
+auto expose(xcb_window_t window, std::uint16_t count) -> xcb_generic_event_t*
+{
+    auto e = make<xcb_expose_event_t>(XCB_EXPOSE);
+    e->window = window;
+    e->count = count;
+    return reinterpret_cast<xcb_generic_event_t*>(e);
+}
+
+auto configure(xcb_window_t window, std::uint16_t mask, std::uint16_t value) -> xcb_generic_event_t*
+{
+    auto e = make<xcb_configure_request_event_t>(XCB_CONFIGURE_REQUEST);
+    e->window = window;
+    e->value_mask = mask;
+    e->x = e->y = static_cast<int16_t>(value);
+    e->width = e->height = value;
+    return reinterpret_cast<xcb_generic_event_t*>(e);
+}
+
+auto key_press(std::uint8_t keycode) -> xcb_generic_event_t*
+{
+    auto e = make<xcb_key_press_event_t>(XCB_KEY_PRESS);
+    e->detail = keycode;
+    return reinterpret_cast<xcb_generic_event_t*>(e);
+}
+
+auto map_request(xcb_window_t window) -> xcb_generic_event_t*
+{
+    auto e = make<xcb_map_request_event_t>(XCB_MAP_REQUEST);
+    e->window = window;
+    return reinterpret_cast<xcb_generic_event_t*>(e);
+}
+
+void push_storm(cx::x11::EventBatch& batch, xcb_window_t windows)
+{
+    constexpr std::uint16_t fields[] = {XCB_CONFIG_WINDOW_X, XCB_CONFIG_WINDOW_Y, XCB_CONFIG_WINDOW_WIDTH, XCB_CONFIG_WINDOW_HEIGHT};
+    for(auto half = 0; half < 2; ++half) {
+        for(std::uint16_t round = 0; round < 25; ++round) {
+            for(xcb_window_t w = 1; w <= windows; ++w) {
+                batch.push(property(w, XCB_ATOM_WM_NAME));
+                batch.push(configure(w, fields[round % 4], round));
+                if(round % 5 == 0) {
+                    for(std::uint16_t count = 4; count-- > 0;)
+                        batch.push(expose(w, count));
+                }
+            }
+            batch.push(key_press(static_cast<std::uint8_t>(half * 25 + round)));
+        }
+        if(half == 0)
+            batch.push(map_request(windows + 1));
+    }
+}
+
+int main(int argc, const char** argv)
+{
+    const auto windows = static_cast<xcb_window_t>(argc > 1 ? std::atoi(argv[1]) : 20);
+    cx::x11::EventBatch batch{};
+    push_storm(batch, windows);
+
+    std::size_t properties = 0, exposes = 0, configures = 0, maps = 0, out_of_order = 0, bad_configures = 0, before_map = 0;
+    int last_key = -1;
+    auto others_seen = false;
+    batch.dispatch([&](xcb_generic_event_t* ev) {
+        others_seen |= ev->response_type != XCB_KEY_PRESS;
+        switch(ev->response_type) {
+        case XCB_PROPERTY_NOTIFY:
+            ++properties;
+            break;
+        case XCB_EXPOSE:
+            ++exposes;
+            break;
+        case XCB_CONFIGURE_REQUEST: {
+            ++configures;
+            // Each half ends on round 24, which set x; the three rounds before it set the rest
+            auto e = reinterpret_cast<xcb_configure_request_event_t*>(ev);
+            constexpr std::uint16_t all = XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y | XCB_CONFIG_WINDOW_WIDTH | XCB_CONFIG_WINDOW_HEIGHT;
+            if(e->value_mask != all || e->x != 24 || e->y != 21 || e->width != 22 || e->height != 23)
+                ++bad_configures;
+            break;
+        }
+        case XCB_KEY_PRESS: {
+            auto key = reinterpret_cast<xcb_key_press_event_t*>(ev)->detail;
+            if(key <= last_key || others_seen)
+                ++out_of_order;
+            last_key = key;
+            break;
+        }
+        case XCB_MAP_REQUEST:
+            ++maps;
+            before_map = properties + exposes + configures;
+            break;
+        }
+    });
+    const auto [received, handled, deferred] = batch.stats();
+    cx::println("{} windows: {} events received, {} handled ({:.1f}x fewer)", windows, received, handled,
+                static_cast<double>(received) / static_cast<double>(handled));
+    cx::println("  PropertyNotify {}, Expose {}, ConfigureRequest {} ({} merged wrong), MapRequest {} ({} handled before it), key presses out "
+                "of order {}",
+                properties, exposes, configures, bad_configures, maps, before_map, out_of_order);
+    // Once per window & half, the MapRequest being the one thing in between
+    const auto expected = 2 * windows;
+    const auto merged_ok = deferred == 0 && properties == expected && exposes == expected && configures == expected && bad_configures == 0 &&
+                           maps == 1 && before_map == 3 * windows && out_of_order == 0;
+
+    constexpr auto rounds = 2000;
+    const auto before = batch.stats().received;
+    auto start = steady_clock::now();
+    for(auto i = 0; i < rounds; ++i) {
+        push_storm(batch, windows);
+        batch.dispatch([](xcb_generic_event_t*) {});
+    }
+    const auto pushed = batch.stats().received - before;
+    cx::println("{:.1f}ns per event received, pushed & dispatched, allocating & freeing it included",
+                static_cast<double>(duration_cast<nanoseconds>(steady_clock::now() - start).count()) / static_cast<double>(pushed));
+    return merged_ok ? 0 : 1;
+}
@@ -0,0 +1,104 @@
+// Key press latency during an event storm, when events are handled in the order they came in, the way the event loop used to, vs.
+// input first with a budget for the rest. No X server needed; the events are made up. Every loop iteration brings Exposes &
+// WM_NAME changes for a number of windows, each costing 10us to handle, like a redraw, & one key press somewhere in between. The latency
+// is from when the iteration got its events to when the key press was handled.
+//      ./event_priority_bench [windows = 300] [iterations = 200]
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+#include <xcb/xcb.h>
+
+#include <coreutils/core.hpp>
+#include <coreutils/histogram.hpp>
+#include <xcom/utility/event_batch.hpp>
+
+using namespace std::chrono;
+
+constexpr auto HANDLING = microseconds{10};
+constexpr auto BUDGET = milliseconds{4};
+
+template<typename Event>
+auto make(std::uint8_t type, xcb_window_t window) -> xcb_generic_event_t*
+{
+    auto event = static_cast<Event*>(std::calloc(1, std::max(sizeof(Event), sizeof(xcb_generic_event_t))));
+    event->response_type = type;
+    if constexpr(requires { event->window; })
+        event->window = window;
+    if constexpr(requires { event->atom; })
+        event->atom = XCB_ATOM_WM_NAME;
+    return reinterpret_cast<xcb_generic_event_t*>(event);
+}
+
+/// One iteration's worth of events, the key press at a different place every time
+auto storm(xcb_window_t windows, std::size_t iteration) -> std::vector<xcb_generic_event_t*>
+{
+    std::vector<xcb_generic_event_t*> events;
+    const auto key_at = (iteration * 7919) % (2 * windows);
+    for(xcb_window_t w = 1; w <= windows; ++w) {
+        if(events.size() == key_at)
+            events.push_back(make<xcb_key_press_event_t>(XCB_KEY_PRESS, 0));
+        events.push_back(make<xcb_expose_event_t>(XCB_EXPOSE, w));
+        if(events.size() == key_at)
+            events.push_back(make<xcb_key_press_event_t>(XCB_KEY_PRESS, 0));
+        events.push_back(make<xcb_property_notify_event_t>(XCB_PROPERTY_NOTIFY, w));
+    }
+    return events;
+}
+
+struct Handler {
+    void operator()(xcb_generic_event_t* event)
+    {
+        if(event->response_type == XCB_KEY_PRESS) {
+            key_latency.record(static_cast<std::uint64_t>(duration_cast<nanoseconds>(steady_clock::now() - read_at).count()));
+            return;
+        }
+        ++redraws;
+        for(auto until = steady_clock::now() + HANDLING; steady_clock::now() < until;) {
+        }
+    }
+    steady_clock::time_point read_at{};
+    cx::Histogram key_latency{};
+    std::size_t redraws = 0;
+};
+
+void report(const char* name, const Handler& handler, std::size_t iterations)
+{
+    const auto& h = handler.key_latency;
+    cx::println("{:<24} key press to action: p50 {:>6}us  p99 {:>6}us  max {:>6}us; {:.0f} redraws per iteration", name, h.percentile(50) / 1000,
+                h.percentile(99) / 1000, h.max() / 1000, static_cast<double>(handler.redraws) / static_cast<double>(iterations));
+}
+
+int main(int argc, const char** argv)
+{
+    const auto windows = static_cast<xcb_window_t>(argc > 1 ? std::atoi(argv[1]) : 300);
+    const auto iterations = static_cast<std::size_t>(argc > 2 ? std::atoi(argv[2]) : 200);
+
+    Handler in_order{};
+    for(std::size_t i = 0; i < iterations; ++i) {
+        auto events = storm(windows, i);
+        in_order.read_at = steady_clock::now();
+        for(auto event : events) {
+            in_order(event);
+            std::free(event);
+        }
+    }
+    report("in order", in_order, iterations);
+
+    Handler prioritised{};
+    cx::x11::EventBatch batch{};
+    for(std::size_t i = 0; i < iterations; ++i) {
+        auto events = storm(windows, i);
+        prioritised.read_at = steady_clock::now();
+        for(auto event : events)
+            batch.push(event);
+        batch.dispatch(prioritised, BUDGET);
+    }
+    report("input first, 4ms budget", prioritised, iterations);
+    const auto [received, handled, deferred] = batch.stats();
+    cx::println("{} events received, {} handled, {} put off to a later iteration", received, handled, deferred);
+    // Flat: the worst key press waits no longer than the handling of one event that was already going
+    return prioritised.key_latency.percentile(99) < in_order.key_latency.percentile(50) ? 0 : 1;
+}
@@ -0,0 +1,173 @@
+// What TIMED_SCOPE costs per scope, with one probe (TIMED_SCOPE) & one picked by index (TIMED_SCOPE_DYNAMIC), and whether the
+// percentiles it comes up with are right: work of a known length, 1us, 10us & 100us, timed under a probe each. Then "stats" over the IPC
+// socket, the way a client asks the manager for them; the reply has to carry every probe.
+//      ./instrumentation_bench [scopes = 10000000]
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+
+#include <coreutils/core.hpp>
+#include <coreutils/instrumentation.hpp>
+#include <cxprotocol/src/library.h>
+#include <ipc/command_parser.hpp>
+#include <ipc/ipc.hpp>
+
+using namespace std::chrono;
+
+void spin(nanoseconds length)
+{
+    for(auto until = steady_clock::now() + length; steady_clock::now() < until;) {
+    }
+}
+
+/// Probes picked by index, the way commands & IPC actions are timed by their type
+constexpr std::array<std::string_view, 2> indexed_names{"empty scope, even", "empty scope, odd"};
+
+/// Something for the compiler to not optimise away
+static volatile std::uint64_t sink = 0;
+
+template<typename Body>
+auto ns_per_iteration(std::size_t iterations, Body body) -> double
+{
+    auto start = steady_clock::now();
+    for(std::size_t i = 0; i < iterations; ++i)
+        body(i);
+    return static_cast<double>(duration_cast<nanoseconds>(steady_clock::now() - start).count()) / static_cast<double>(iterations);
+}
+
+auto connect_to(const std::string& path) -> int
+{
+    auto fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::copy(path.begin(), path.end(), address.sun_path);
+    while(connect(fd, (sockaddr*)&address, sizeof(address)) == -1)
+        std::this_thread::yield();
+    return fd;
+}
+
+/// Hands socket readiness to the interface, the same way Manager::handle_file_descriptor_event does
+void dispatch(cx::ipc::IPCInterface& ipc, int epoll_fd)
+{
+    epoll_event event_list[32];
+    auto event_count = epoll_wait(epoll_fd, event_list, 32, 10);
+    for(auto i = 0; i < event_count; ++i) {
+        auto fd = event_list[i].data.fd;
+        if(ipc.is_connection_request(fd)) {
+            ipc.handle_incoming_connection();
+            continue;
+        }
+        if(event_list[i].events & EPOLLOUT)
+            ipc.write_to_output(fd);
+        if(event_list[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))
+            ipc.read_from_input(fd);
+    }
+    ipc.flush_output();
+}
+
+/// Asks for "stats" & returns the reply's one record
+auto request_stats(const std::string& path, cx::ipc::IPCInterface& ipc, int epoll_fd) -> std::string
+{
+    std::string reply;
+    std::atomic<bool> replied = false;
+    std::thread client{[&] {
+        auto fd = connect_to(path);
+        cx::ipc::Batch request{cx::ipc::MessageType::Request, 7};
+        request.add("stats");
+        auto frame = request.frame();
+        write(fd, frame.data(), frame.size());
+        std::string received;
+        char buffer[4096];
+        for(auto bytes = read(fd, buffer, sizeof(buffer)); bytes > 0; bytes = read(fd, buffer, sizeof(buffer))) {
+            received.append(buffer, static_cast<std::size_t>(bytes));
+            auto header = cx::ipc::decode_header(received);
+            if(header && received.size() >= cx::ipc::V2_HEADER_SIZE + header->length) {
+                cx::ipc::RecordReader records{std::string_view{received}.substr(cx::ipc::V2_HEADER_SIZE, header->length)};
+                if(auto record = records.next())
+                    reply.assign(*record);
+                replied = true;
+                break;
+            }
+        }
+        close(fd);
+    }};
+    for(auto start = steady_clock::now(); !replied && steady_clock::now() - start < seconds{2};)
+        dispatch(ipc, epoll_fd);
+    client.join();
+    return reply;
+}
+
+int main(int argc, const char** argv)
+{
+    const auto scopes = static_cast<std::size_t>(argc > 1 ? std::atoll(argv[1]) : 10'000'000);
+
+    const auto bare = ns_per_iteration(scopes, [](std::size_t i) { sink = sink + i; });
+    const auto timed = ns_per_iteration(scopes, [](std::size_t i) {
+        TIMED_SCOPE("bench", "empty scope");
+        sink = sink + i;
+    });
+    const auto dynamic = ns_per_iteration(scopes, [](std::size_t i) {
+        TIMED_SCOPE_DYNAMIC("bench", indexed_names, i % 2);
+        sink = sink + i;
+    });
+    cx::println("per scope: {:.1f}ns timed, {:.1f}ns with the probe picked by index, on top of {:.1f}ns for the loop", timed - bare,
+                dynamic - bare, bare);
+
+    constexpr std::array lengths{nanoseconds{1000}, nanoseconds{10'000}, nanoseconds{100'000}};
+    for(auto i = 0; i < 2000; ++i) {
+        {
+            TIMED_SCOPE("bench", "spin 1us");
+            spin(lengths[0]);
+        }
+        {
+            TIMED_SCOPE("bench", "spin 10us");
+            spin(lengths[1]);
+        }
+        if(i % 10 == 0) {
+            TIMED_SCOPE("bench", "spin 100us");
+            spin(lengths[2]);
+        }
+    }
+
+    const auto path = "/tmp/cxwm_ipc_instrumentation_" + std::to_string(getpid());
+    unlink(path.c_str());
+    auto epoll_fd = epoll_create1(0);
+    auto ipc = cx::ipc::factory::ipc_setup_unix_socket(path, epoll_fd);
+    std::string stats_text;
+    ipc->set_message_handler([&stats_text](int, std::string_view payload) {
+        if(!std::holds_alternative<cx::ipc::StatsRequest>(cx::ipc::parse_command(payload)))
+            return cx::ipc::Response{false, "Not stats", payload};
+        fmt::memory_buffer out;
+        cx::instrumentation::report(out);
+        stats_text.assign(out.data(), out.size());
+        return cx::ipc::Response{true, {}, {}, stats_text};
+    });
+    const auto reply = request_stats(path, *ipc, epoll_fd);
+    ipc.reset();
+    close(epoll_fd);
+    cx::println("\"stats\" over IPC:\n{}", reply);
+
+    // The p50 of each spin has to be within a bucket (1/16) of its length, plus what a scope & reading the clock costs
+    auto accurate = true;
+    for(auto [length, name] : {std::pair{lengths[0], "spin 1us"}, std::pair{lengths[1], "spin 10us"}, std::pair{lengths[2], "spin 100us"}}) {
+        const auto at = reply.find(name);
+        if(at == std::string::npos) {
+            accurate = false;
+            continue;
+        }
+        const auto p50 = std::strtod(reply.c_str() + reply.find("p50 ", at) + 4, nullptr);
+        const auto target = static_cast<double>(length.count());
+        accurate &= p50 >= target && p50 <= target * (1.0 + 1.0 / 16) + 200;
+    }
+    cx::println("{}", accurate ? "percentiles match what was timed" : "percentiles are off, or missing from the reply");
+    return accurate && cx::instrumentation::enabled ? 0 : 1;
+}
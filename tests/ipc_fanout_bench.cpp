@@ -0,0 +1,153 @@
+// Fan-out test for IPC subscriptions: N clients subscribe to every event, then the server publishes M events, flushing every K the way
+// Manager::commit does, and writing the rest out on EPOLLOUT. Reports how long publishing took (the time Manager::event_loop spends on it),
+// the slowest single flush, and how many frames made it to the subscribers vs. were coalesced away. With slow = 1, one of the subscribers
+// reads in small bites with a nap in between; the other subscribers, and publishing, should not notice.
+//      ./ipc_fanout_bench [subscribers = 100] [events = 20000] [events per flush = 16] [slow = 0]
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include <coreutils/core.hpp>
+#include <cxprotocol/src/library.h>
+#include <ipc/ipc.hpp>
+
+using namespace std::chrono;
+
+auto connect_to(const std::string& path) -> int
+{
+    auto fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::copy(path.begin(), path.end(), address.sun_path);
+    while(connect(fd, (sockaddr*)&address, sizeof(address)) == -1)
+        std::this_thread::yield();
+    return fd;
+}
+
+auto send_payload(int fd, std::string_view payload) -> void
+{
+    cx::ipc::FrameHeaderBytes header;
+    auto frame = cx::ipc::encode_iovec(payload, header);
+    writev(fd, frame->data(), static_cast<int>(frame->size()));
+}
+
+/// Subscribes, tells the server it has, then counts frames until the server hangs up
+void run_subscriber(const std::string& path, bool slow, std::atomic<std::size_t>& delivered)
+{
+    auto fd = connect_to(path);
+    send_payload(fd, "subscribe all");
+    // Messages from one client are handled in order; once the server sees this, the subscription is in place
+    send_payload(fd, "window rotate");
+
+    std::vector<unsigned char> buffer(slow ? 256 : 64 * 1024);
+    std::size_t filled = 0;
+    std::size_t frames = 0;
+    for(;;) {
+        auto bytes = read(fd, buffer.data() + filled, buffer.size() - filled);
+        if(bytes <= 0)
+            break;
+        filled += static_cast<std::size_t>(bytes);
+        std::size_t offset = 0;
+        while(filled - offset >= cx::ipc::HEADER_SIZE) {
+            auto length = cx::ipc::deserialize_payload_length(buffer.data() + offset + cx::ipc::HEADER_IDENTIFIER.size());
+            auto frame_size = cx::ipc::FIXED_FIELDS_SIZE + length;
+            if(filled - offset < frame_size)
+                break;
+            offset += frame_size;
+            ++frames;
+        }
+        std::copy(buffer.begin() + static_cast<long>(offset), buffer.begin() + static_cast<long>(filled), buffer.begin());
+        filled -= offset;
+        if(slow)
+            std::this_thread::sleep_for(milliseconds{1});
+    }
+    delivered += frames;
+    close(fd);
+}
+
+/// Hands socket readiness to the interface, the same way Manager::handle_file_descriptor_event does
+auto dispatch(cx::ipc::IPCInterface& ipc, int epoll_fd, int timeout) -> int
+{
+    epoll_event event_list[32];
+    auto event_count = epoll_wait(epoll_fd, event_list, 32, timeout);
+    for(auto i = 0; i < event_count; ++i) {
+        auto fd = event_list[i].data.fd;
+        if(ipc.is_connection_request(fd)) {
+            ipc.handle_incoming_connection();
+            continue;
+        }
+        if(event_list[i].events & EPOLLOUT)
+            ipc.write_to_output(fd);
+        if(event_list[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))
+            ipc.read_from_input(fd);
+    }
+    if(ipc.has_request())
+        ipc.poll_event();
+    return event_count;
+}
+
+int main(int argc, const char** argv)
+{
+    auto subscribers = argc > 1 ? std::atoi(argv[1]) : 100;
+    auto events = argc > 2 ? std::atoi(argv[2]) : 20000;
+    auto per_flush = argc > 3 ? std::max(std::atoi(argv[3]), 1) : 16;
+    auto slow = argc > 4 && std::atoi(argv[4]) != 0;
+    const auto path = "/tmp/cxwm_ipc_fanout_" + std::to_string(getpid());
+    unlink(path.c_str());
+
+    auto epoll_fd = epoll_create1(0);
+    auto ipc = cx::ipc::factory::ipc_setup_unix_socket(path, epoll_fd);
+    auto subscribed = 0;
+    ipc->set_message_handler([&subscribed](int, std::string_view) {
+        ++subscribed;
+        return cx::ipc::Response{};
+    });
+
+    std::atomic<std::size_t> delivered = 0;
+    std::vector<std::thread> subscriber_threads;
+    for(auto i = 0; i < subscribers; ++i)
+        subscriber_threads.emplace_back(run_subscriber, path, slow && i == 0, std::ref(delivered));
+    while(subscribed < subscribers)
+        dispatch(*ipc, epoll_fd, 1000);
+
+    const cx::ipc::EventType types[]{cx::ipc::EventType::Focus, cx::ipc::EventType::Title, cx::ipc::EventType::Workspace};
+    std::string payload;
+    nanoseconds worst_flush{0};
+    auto start = steady_clock::now();
+    for(auto i = 0; i < events; ++i) {
+        auto type = types[i % 3];
+        payload = fmt::format("{} {} {}", i % 3 == 0 ? "focus" : i % 3 == 1 ? "title" : "workspace", 0x400000 + i % 64, i);
+        ipc->publish(type, payload);
+        if((i + 1) % per_flush == 0) {
+            auto flush_start = steady_clock::now();
+            ipc->flush_output();
+            dispatch(*ipc, epoll_fd, 0);
+            worst_flush = std::max(worst_flush, duration_cast<nanoseconds>(steady_clock::now() - flush_start));
+        }
+    }
+    ipc->flush_output();
+    auto publish_time = duration_cast<microseconds>(steady_clock::now() - start).count();
+
+    // Whatever is still queued goes out as subscribers make room
+    while(dispatch(*ipc, epoll_fd, 200) > 0) {}
+    auto drain_time = duration_cast<microseconds>(steady_clock::now() - start).count();
+    ipc.reset();
+    for(auto& thread : subscriber_threads)
+        thread.join();
+    close(epoll_fd);
+
+    const auto published = static_cast<std::size_t>(events) * static_cast<std::size_t>(subscribers);
+    cx::println("{} subscribers x {} events, flushed every {}{}", subscribers, events, per_flush, slow ? ", one slow subscriber" : "");
+    cx::println("publishing: {}us, {:.0f} events/s, slowest flush {}us", publish_time, events * 1e6 / static_cast<double>(publish_time),
+                duration_cast<microseconds>(worst_flush).count());
+    cx::println("delivered {} of {} frames in {}us, {} coalesced", delivered.load(), published, drain_time, published - delivered.load());
+    return 0;
+}
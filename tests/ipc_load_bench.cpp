@@ -0,0 +1,158 @@
+// Load test for the IPC socket: N clients connect at once and each fires off M commands as fast as the socket takes them. The server side
+// runs the same way Manager::event_loop drives it, and reports how long it took to get every message & how many trips through epoll_wait
+// that cost. With a batch size above 1, clients send v2 frames of that many commands each, and wait for a reply to every frame.
+//      ./ipc_load_bench [clients = 64] [commands per client = 10000] [commands per frame = 1]
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include <coreutils/core.hpp>
+#include <cxprotocol/src/library.h>
+#include <ipc/ipc.hpp>
+
+using namespace std::chrono;
+
+/// Counts reply frames until there have been expected of them, or the server hangs up
+auto read_replies(int fd, int expected) -> int
+{
+    std::string buffer;
+    std::array<char, 16 * 1024> chunk{};
+    auto replies = 0;
+    while(replies < expected) {
+        auto bytes = read(fd, chunk.data(), chunk.size());
+        if(bytes <= 0)
+            break;
+        buffer.append(chunk.data(), static_cast<std::size_t>(bytes));
+        std::string_view rest{buffer};
+        while(auto header = cx::ipc::decode_header(rest)) {
+            if(rest.size() < cx::ipc::V2_HEADER_SIZE + header->length)
+                break;
+            rest.remove_prefix(cx::ipc::V2_HEADER_SIZE + header->length);
+            ++replies;
+        }
+        buffer.erase(0, buffer.size() - rest.size());
+    }
+    return replies;
+}
+
+/// Writes all of the commands, in as few write calls as the socket allows
+void run_client(const std::string& path, int commands, int batch_size, std::atomic<int>& replies)
+{
+    auto fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::copy(path.begin(), path.end(), address.sun_path);
+    while(connect(fd, (sockaddr*)&address, sizeof(address)) == -1)
+        std::this_thread::yield();
+    std::string stream;
+    auto frames = 0;
+    if(batch_size > 1) {
+        for(auto first = 0; first < commands; first += batch_size, ++frames) {
+            cx::ipc::Batch batch{cx::ipc::MessageType::Request, static_cast<std::uint32_t>(frames)};
+            for(auto i = first; i < std::min(first + batch_size, commands); ++i)
+                batch.add("window move left " + std::to_string(i));
+            stream.append(batch.frame());
+        }
+    } else {
+        for(auto i = 0; i < commands; ++i) {
+            auto payload = "window move left " + std::to_string(i);
+            auto offset = stream.size();
+            stream.resize(offset + cx::ipc::FIXED_FIELDS_SIZE + payload.size());
+            cx::ipc::encode_into(payload, std::as_writable_bytes(std::span{stream}.subspan(offset)));
+        }
+    }
+    std::string_view remaining{stream};
+    while(!remaining.empty()) {
+        auto written = write(fd, remaining.data(), remaining.size());
+        if(written <= 0)
+            break;
+        remaining.remove_prefix(static_cast<std::size_t>(written));
+    }
+    if(frames > 0)
+        replies += read_replies(fd, frames);
+    close(fd);
+}
+
+int main(int argc, const char** argv)
+{
+    auto clients = argc > 1 ? std::atoi(argv[1]) : 64;
+    auto commands = argc > 2 ? std::atoi(argv[2]) : 10000;
+    auto batch_size = argc > 3 ? std::atoi(argv[3]) : 1;
+    const auto expected = static_cast<std::size_t>(clients) * static_cast<std::size_t>(commands);
+    const auto path = "/tmp/cxwm_ipc_bench_" + std::to_string(getpid());
+    unlink(path.c_str());
+
+    auto epoll_fd = epoll_create1(0);
+    auto ipc = cx::ipc::factory::ipc_setup_unix_socket(path, epoll_fd);
+    std::size_t received = 0;
+    ipc->set_message_handler([&received](int, std::string_view) {
+        ++received;
+        return cx::ipc::Response{};
+    });
+
+    std::atomic<int> replies = 0;
+    std::vector<std::thread> client_threads;
+    auto start = steady_clock::now();
+    for(auto i = 0; i < clients; ++i)
+        client_threads.emplace_back(run_client, path, commands, batch_size, std::ref(replies));
+
+    std::size_t wakeups = 0;
+    while(received < expected) {
+        epoll_event event_list[10];
+        auto event_count = epoll_wait(epoll_fd, event_list, 10, ipc->has_request() ? 0 : 1000);
+        ++wakeups;
+        if(event_count == 0 && !ipc->has_request()) {
+            cx::println("Timed out with {} of {} messages received", received, expected);
+            break;
+        }
+        for(auto i = 0; i < event_count; ++i) {
+            auto fd = event_list[i].data.fd;
+            if(ipc->is_connection_request(fd)) {
+                ipc->handle_incoming_connection();
+                continue;
+            }
+            if(event_list[i].events & EPOLLOUT)
+                ipc->write_to_output(fd);
+            if(event_list[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))
+                ipc->read_from_input(fd);
+        }
+        if(ipc->has_request())
+            ipc->poll_event();
+        ipc->flush_output();
+    }
+    auto elapsed = duration_cast<microseconds>(steady_clock::now() - start).count();
+    // Replies still queued go out as the clients read them
+    while(batch_size > 1 && replies < clients * ((commands + batch_size - 1) / batch_size)) {
+        epoll_event event_list[10];
+        auto event_count = epoll_wait(epoll_fd, event_list, 10, 1000);
+        if(event_count == 0)
+            break;
+        for(auto i = 0; i < event_count; ++i) {
+            auto fd = event_list[i].data.fd;
+            if(event_list[i].events & EPOLLOUT)
+                ipc->write_to_output(fd);
+            if(event_list[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))
+                ipc->read_from_input(fd);
+        }
+    }
+    for(auto& thread : client_threads)
+        thread.join();
+
+    cx::println("{} clients x {} commands{}: {} messages in {}us", clients, commands,
+                batch_size > 1 ? fmt::format(", {} per frame", batch_size) : std::string{}, received, elapsed);
+    if(batch_size > 1)
+        cx::println("{} replies received", replies.load());
+    cx::println("{:.0f} messages/s, {} epoll_wait calls ({:.1f} messages per wakeup)", received * 1e6 / static_cast<double>(elapsed), wakeups,
+                static_cast<double>(received) / static_cast<double>(wakeups));
+    ipc.reset();
+    close(epoll_fd);
+    return received == expected ? 0 : 1;
+}
@@ -0,0 +1,234 @@
+// Shared layout snapshot: the server publishes a new layout at a fixed rate, handling IPC in between like Manager::event_loop does, while
+// R readers ask for the snapshot over the socket, map the file descriptor that comes back & read it as fast as they can. Every field of
+// every window in generation g is g, and so is the number in each title; a read that mixes two generations is torn, and there must be
+// none. Reports what a read costs the readers, what a publish costs the server, and that the readers can't write to the mapping.
+//      ./ipc_snapshot_bench [readers = 4] [milliseconds = 2000] [publishes per second = 1000] [windows = 64]
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include <coreutils/core.hpp>
+#include <cxprotocol/src/library.h>
+#include <cxprotocol/src/snapshot.h>
+#include <ipc/ipc.hpp>
+#include <ipc/snapshot.hpp>
+
+using namespace std::chrono;
+namespace snapshot = cx::ipc::snapshot;
+
+constexpr std::uint32_t WORKSPACES = 4;
+
+auto connect_to(const std::string& path) -> int
+{
+    auto fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::copy(path.begin(), path.end(), address.sun_path);
+    while(connect(fd, (sockaddr*)&address, sizeof(address)) == -1)
+        std::this_thread::yield();
+    return fd;
+}
+
+/// Sends "snapshot" & waits for the reply it comes with. -1 if it didn't
+auto request_snapshot(int socket_fd) -> int
+{
+    cx::ipc::Batch request{cx::ipc::MessageType::Request, 1};
+    request.add("snapshot");
+    auto frame = request.frame();
+    write(socket_fd, frame.data(), frame.size());
+
+    char reply[256];
+    iovec iov{reply, sizeof(reply)};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+    msghdr message{};
+    message.msg_iov = &iov;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+    if(recvmsg(socket_fd, &message, MSG_CMSG_CLOEXEC) <= 0)
+        return -1;
+    auto* header = CMSG_FIRSTHDR(&message);
+    if(!header || header->cmsg_level != SOL_SOCKET || header->cmsg_type != SCM_RIGHTS)
+        return -1;
+    int fd;
+    std::memcpy(&fd, CMSG_DATA(header), sizeof(int));
+    return fd;
+}
+
+struct ReaderStats {
+    std::size_t reads = 0;
+    std::size_t torn = 0;
+    std::size_t generations = 0;
+    nanoseconds spent{0};
+    bool writable = false;
+};
+
+/// True if every window in body says generation
+auto consistent(std::span<const std::byte> body, std::uint64_t generation) -> bool
+{
+    auto view = snapshot::View::parse(body);
+    if(!view)
+        return false;
+    const auto g = static_cast<std::uint32_t>(generation);
+    const auto title = "window " + std::to_string(g);
+    if(view->focused_window() != g)
+        return false;
+    for(const auto& window : view->windows()) {
+        if(window.client != g || window.frame != g || static_cast<std::uint32_t>(window.x) != g || static_cast<std::uint32_t>(window.y) != g ||
+           static_cast<std::uint32_t>(window.width) != g || static_cast<std::uint32_t>(window.height) != g || view->title(window) != title)
+            return false;
+    }
+    return true;
+}
+
+void run_reader(const std::string& path, const std::atomic<bool>& done, ReaderStats& stats)
+{
+    auto socket_fd = connect_to(path);
+    auto fd = request_snapshot(socket_fd);
+    close(socket_fd);
+    if(fd == -1) {
+        cx::println("Didn't get the snapshot's file descriptor");
+        return;
+    }
+    struct stat info{};
+    fstat(fd, &info);
+    const auto size = static_cast<std::size_t>(info.st_size);
+    // The seals must keep us from mapping it writable
+    auto writable = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    stats.writable = writable != MAP_FAILED;
+    if(writable != MAP_FAILED)
+        munmap(writable, size);
+    auto* mapping = static_cast<const std::byte*>(mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0));
+    close(fd);
+
+    std::vector<std::byte> body;
+    std::uint64_t last = 0;
+    auto start = steady_clock::now();
+    while(!done.load(std::memory_order_relaxed)) {
+        auto generation = snapshot::read(mapping, size, body);
+        ++stats.reads;
+        if(!generation || *generation == 0)
+            continue;
+        if(!consistent(body, *generation))
+            ++stats.torn;
+        if(*generation != last) {
+            ++stats.generations;
+            last = *generation;
+        }
+    }
+    stats.spent = duration_cast<nanoseconds>(steady_clock::now() - start);
+    munmap(const_cast<std::byte*>(mapping), size);
+}
+
+/// Hands socket readiness to the interface, the same way Manager::handle_file_descriptor_event does
+auto dispatch(cx::ipc::IPCInterface& ipc, int epoll_fd, int timeout) -> int
+{
+    epoll_event event_list[32];
+    auto event_count = epoll_wait(epoll_fd, event_list, 32, timeout);
+    for(auto i = 0; i < event_count; ++i) {
+        auto fd = event_list[i].data.fd;
+        if(ipc.is_connection_request(fd)) {
+            ipc.handle_incoming_connection();
+            continue;
+        }
+        if(event_list[i].events & EPOLLOUT)
+            ipc.write_to_output(fd);
+        if(event_list[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))
+            ipc.read_from_input(fd);
+    }
+    if(ipc.has_request())
+        ipc.poll_event();
+    ipc.flush_output();
+    return event_count;
+}
+
+void build(snapshot::Builder& builder, std::uint32_t generation, int windows)
+{
+    const auto title = "window " + std::to_string(generation);
+    const auto g = static_cast<std::int32_t>(generation);
+    builder.clear();
+    for(std::uint32_t ws = 0; ws < WORKSPACES; ++ws) {
+        builder.add_workspace(ws, std::to_string(ws + 1));
+        for(auto i = ws; i < static_cast<std::uint32_t>(windows); i += WORKSPACES)
+            builder.add_window(snapshot::Window{generation, generation, ws, g, g, g, g}, title);
+    }
+    builder.focus(0, generation);
+}
+
+int main(int argc, const char** argv)
+{
+    auto readers = argc > 1 ? std::atoi(argv[1]) : 4;
+    auto run_for = milliseconds{argc > 2 ? std::atoi(argv[2]) : 2000};
+    auto rate = argc > 3 ? std::max(std::atoi(argv[3]), 1) : 1000;
+    auto windows = argc > 4 ? std::atoi(argv[4]) : 64;
+    const auto path = "/tmp/cxwm_ipc_snapshot_" + std::to_string(getpid());
+    unlink(path.c_str());
+
+    auto epoll_fd = epoll_create1(0);
+    auto ipc = cx::ipc::factory::ipc_setup_unix_socket(path, epoll_fd);
+    auto shared = cx::ipc::SharedSnapshot::create(cx::ipc::SNAPSHOT_CAPACITY);
+    if(!shared)
+        return 1;
+    ipc->share_snapshot(shared->fd());
+
+    snapshot::Builder builder;
+    std::vector<std::byte> body;
+    std::uint32_t generation = 1;
+    build(builder, generation, windows);
+    builder.finish(body);
+    shared->publish(body);
+
+    std::atomic<bool> done = false;
+    std::vector<ReaderStats> stats(static_cast<std::size_t>(readers));
+    std::vector<std::thread> reader_threads;
+    for(auto i = 0; i < readers; ++i)
+        reader_threads.emplace_back(run_reader, path, std::cref(done), std::ref(stats[static_cast<std::size_t>(i)]));
+
+    const auto interval = nanoseconds{1'000'000'000 / rate};
+    nanoseconds publishing{0};
+    nanoseconds worst{0};
+    auto start = steady_clock::now();
+    auto next = start + interval;
+    while(steady_clock::now() - start < run_for) {
+        dispatch(*ipc, epoll_fd, 0);
+        if(steady_clock::now() < next)
+            continue;
+        next += interval;
+        auto publish_start = steady_clock::now();
+        build(builder, ++generation, windows);
+        builder.finish(body);
+        shared->publish(body);
+        auto took = duration_cast<nanoseconds>(steady_clock::now() - publish_start);
+        publishing += took;
+        worst = std::max(worst, took);
+    }
+    done = true;
+    for(auto& thread : reader_threads)
+        thread.join();
+    ipc.reset();
+    close(epoll_fd);
+
+    cx::println("{} readers, {} windows ({} byte snapshot), {} publishes over {}ms", readers, windows, body.size(), generation - 1,
+                run_for.count());
+    cx::println("publish: {:.0f}ns on average, {}ns at worst (building the layout included)",
+                static_cast<double>(publishing.count()) / std::max<std::uint32_t>(generation - 1, 1), worst.count());
+    std::size_t torn = 0;
+    for(auto i = 0; i < readers; ++i) {
+        const auto& s = stats[static_cast<std::size_t>(i)];
+        torn += s.torn;
+        cx::println("reader {}: {} reads, {:.0f}ns per read, {} generations seen, {} torn{}", i, s.reads,
+                    static_cast<double>(s.spent.count()) / static_cast<double>(std::max<std::size_t>(s.reads, 1)), s.generations, s.torn,
+                    s.writable ? ", COULD MAP IT WRITABLE" : "");
+    }
+    return torn == 0 ? 0 : 1;
+}
@@ -0,0 +1,274 @@
+// The epoll & io_uring IPC backends, side by side. Two runs each: N clients firing off M v1 commands as fast as they can (throughput), and one
+// client doing request/reply round trips with single command v2 frames, waiting for each reply before sending the next (latency). The
+// server is driven the way Manager::event_loop drives it. System calls are counted on the server thread only, by wrapping the libc functions
+// the backends make them through (see the link options of this target in CMakeLists.txt).
+//      ./ipc_uring_bench [clients = 16] [commands per client = 20000] [round trips = 20000]
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdarg>
+#include <cstdlib>
+#include <string>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include <coreutils/core.hpp>
+#include <cxprotocol/src/library.h>
+#include <ipc/UringSocket.h>
+#include <ipc/ipc.hpp>
+
+using namespace std::chrono;
+
+/// Only the server thread counts
+thread_local bool counting = false;
+std::size_t syscalls = 0;
+
+extern "C" {
+ssize_t __real_read(int fd, void* buffer, size_t count);
+ssize_t __real_sendmsg(int fd, const msghdr* message, int flags);
+int __real_epoll_wait(int epoll_fd, epoll_event* events, int max_events, int timeout);
+int __real_epoll_ctl(int epoll_fd, int op, int fd, epoll_event* event);
+int __real_accept4(int fd, sockaddr* address, socklen_t* length, int flags);
+int __real_eventfd_read(int fd, eventfd_t* value);
+int __real_shutdown(int fd, int how);
+long __real_syscall(long number, ...);
+
+ssize_t __wrap_read(int fd, void* buffer, size_t count)
+{
+    syscalls += counting;
+    return __real_read(fd, buffer, count);
+}
+ssize_t __wrap_sendmsg(int fd, const msghdr* message, int flags)
+{
+    syscalls += counting;
+    return __real_sendmsg(fd, message, flags);
+}
+int __wrap_epoll_wait(int epoll_fd, epoll_event* events, int max_events, int timeout)
+{
+    syscalls += counting;
+    return __real_epoll_wait(epoll_fd, events, max_events, timeout);
+}
+int __wrap_epoll_ctl(int epoll_fd, int op, int fd, epoll_event* event)
+{
+    syscalls += counting;
+    return __real_epoll_ctl(epoll_fd, op, fd, event);
+}
+int __wrap_accept4(int fd, sockaddr* address, socklen_t* length, int flags)
+{
+    syscalls += counting;
+    return __real_accept4(fd, address, length, flags);
+}
+int __wrap_eventfd_read(int fd, eventfd_t* value)
+{
+    syscalls += counting;
+    return __real_eventfd_read(fd, value);
+}
+int __wrap_shutdown(int fd, int how)
+{
+    syscalls += counting;
+    return __real_shutdown(fd, how);
+}
+/// io_uring_enter & friends. Every system call takes at most 6 arguments; passing all of them on is harmless
+long __wrap_syscall(long number, ...)
+{
+    va_list args;
+    va_start(args, number);
+    long a[6];
+    for(auto& arg : a)
+        arg = va_arg(args, long);
+    va_end(args);
+    syscalls += counting;
+    return __real_syscall(number, a[0], a[1], a[2], a[3], a[4], a[5]);
+}
+}
+
+auto connect_to(const std::string& path) -> int
+{
+    auto fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::copy(path.begin(), path.end(), address.sun_path);
+    while(connect(fd, (sockaddr*)&address, sizeof(address)) == -1)
+        std::this_thread::yield();
+    return fd;
+}
+
+void write_all(int fd, std::string_view data)
+{
+    while(!data.empty()) {
+        auto written = write(fd, data.data(), data.size());
+        if(written <= 0)
+            return;
+        data.remove_prefix(static_cast<std::size_t>(written));
+    }
+}
+
+void run_sender(const std::string& path, int commands)
+{
+    auto fd = connect_to(path);
+    std::string stream;
+    for(auto i = 0; i < commands; ++i) {
+        auto payload = "window move left " + std::to_string(i);
+        auto offset = stream.size();
+        stream.resize(offset + cx::ipc::FIXED_FIELDS_SIZE + payload.size());
+        cx::ipc::encode_into(payload, std::as_writable_bytes(std::span{stream}.subspan(offset)));
+    }
+    write_all(fd, stream);
+    close(fd);
+}
+
+/// Sends a request, waits for its reply, and so on. Returns how long each round trip took
+auto run_pinger(const std::string& path, int round_trips) -> std::vector<nanoseconds>
+{
+    auto fd = connect_to(path);
+    std::vector<nanoseconds> times;
+    times.reserve(static_cast<std::size_t>(round_trips));
+    std::array<char, 4096> reply{};
+    for(auto i = 0; i < round_trips; ++i) {
+        cx::ipc::Batch batch{cx::ipc::MessageType::Request, static_cast<std::uint32_t>(i)};
+        batch.add("window move left");
+        auto start = steady_clock::now();
+        write_all(fd, batch.frame());
+        std::size_t filled = 0;
+        for(;;) {
+            auto bytes = read(fd, reply.data() + filled, reply.size() - filled);
+            if(bytes <= 0)
+                return times;
+            filled += static_cast<std::size_t>(bytes);
+            auto header = cx::ipc::decode_header(std::string_view{reply.data(), filled});
+            if(header && filled >= cx::ipc::V2_HEADER_SIZE + header->length)
+                break;
+        }
+        times.push_back(duration_cast<nanoseconds>(steady_clock::now() - start));
+    }
+    close(fd);
+    return times;
+}
+
+/// One trip through the loop, the way Manager::event_loop & Manager::commit take it
+auto dispatch(cx::ipc::IPCInterface& ipc, int epoll_fd, int timeout) -> int
+{
+    epoll_event event_list[10];
+    auto event_count = epoll_wait(epoll_fd, event_list, 10, ipc.has_request() ? 0 : timeout);
+    for(auto i = 0; i < event_count; ++i) {
+        auto fd = event_list[i].data.fd;
+        if(ipc.is_connection_request(fd)) {
+            ipc.handle_incoming_connection();
+            continue;
+        }
+        if(event_list[i].events & EPOLLOUT)
+            ipc.write_to_output(fd);
+        if(event_list[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))
+            ipc.read_from_input(fd);
+    }
+    if(ipc.has_request())
+        ipc.poll_event();
+    ipc.flush_output();
+    return event_count;
+}
+
+using Setup = std::unique_ptr<cx::ipc::IPCInterface> (*)(const std::string& path, int epoll_fd);
+
+auto setup_epoll(const std::string& path, int epoll_fd) -> std::unique_ptr<cx::ipc::IPCInterface>
+{
+    return cx::ipc::factory::ipc_setup_unix_socket(path, epoll_fd);
+}
+
+auto setup_uring(const std::string& path, int epoll_fd) -> std::unique_ptr<cx::ipc::IPCInterface>
+{
+    return cx::ipc::UringSocket::initialize(path, 10, epoll_fd);
+}
+
+void throughput(const char* backend, Setup setup, int clients, int commands)
+{
+    const auto path = "/tmp/cxwm_ipc_uring_bench_" + std::to_string(getpid());
+    unlink(path.c_str());
+    auto epoll_fd = epoll_create1(0);
+    auto ipc = setup(path, epoll_fd);
+    if(!ipc) {
+        cx::println("{:<9} unavailable", backend);
+        close(epoll_fd);
+        return;
+    }
+    std::size_t received = 0;
+    ipc->set_message_handler([&received](int, std::string_view) {
+        ++received;
+        return cx::ipc::Response{};
+    });
+    const auto expected = static_cast<std::size_t>(clients) * static_cast<std::size_t>(commands);
+    syscalls = 0;
+    counting = true;
+    std::vector<std::thread> senders;
+    auto start = steady_clock::now();
+    for(auto i = 0; i < clients; ++i)
+        senders.emplace_back(run_sender, path, commands);
+    while(received < expected) {
+        // With clients left over from the last round, dispatch only looks, it doesn't wait
+        const auto waits = !ipc->has_request();
+        if(dispatch(*ipc, epoll_fd, 1000) == 0 && waits) {
+            cx::println("Timed out with {} of {} messages received", received, expected);
+            break;
+        }
+    }
+    auto elapsed = duration_cast<microseconds>(steady_clock::now() - start).count();
+    counting = false;
+    for(auto& thread : senders)
+        thread.join();
+    cx::println("{:<9} throughput  {:>10.0f} commands/s {:>8.4f} syscalls/command", backend, received * 1e6 / static_cast<double>(elapsed),
+                static_cast<double>(syscalls) / static_cast<double>(received));
+    ipc.reset();
+    close(epoll_fd);
+}
+
+void latency(const char* backend, Setup setup, int round_trips)
+{
+    const auto path = "/tmp/cxwm_ipc_uring_bench_" + std::to_string(getpid());
+    unlink(path.c_str());
+    auto epoll_fd = epoll_create1(0);
+    auto ipc = setup(path, epoll_fd);
+    if(!ipc) {
+        close(epoll_fd);
+        return;
+    }
+    ipc->set_message_handler([](int, std::string_view) { return cx::ipc::Response{}; });
+    std::atomic<bool> done = false;
+    std::vector<nanoseconds> times;
+    syscalls = 0;
+    counting = true;
+    std::thread pinger{[&] {
+        times = run_pinger(path, round_trips);
+        done = true;
+    }};
+    while(!done)
+        dispatch(*ipc, epoll_fd, 10);
+    counting = false;
+    pinger.join();
+    if(times.empty()) {
+        cx::println("{:<9} latency     no replies", backend);
+        return;
+    }
+    std::sort(times.begin(), times.end());
+    auto percentile = [&times](double p) { return times[static_cast<std::size_t>(p * static_cast<double>(times.size() - 1))].count() / 1000.0; };
+    cx::println("{:<9} latency     p50 {:>6.1f}us p99 {:>6.1f}us  {:>8.3f} syscalls/round trip", backend, percentile(0.5), percentile(0.99),
+                static_cast<double>(syscalls) / static_cast<double>(times.size()));
+    ipc.reset();
+    close(epoll_fd);
+}
+
+int main(int argc, const char** argv)
+{
+    auto clients = argc > 1 ? std::atoi(argv[1]) : 16;
+    auto commands = argc > 2 ? std::atoi(argv[2]) : 20000;
+    auto round_trips = argc > 3 ? std::atoi(argv[3]) : 20000;
+    cx::println("{} clients x {} commands; {} round trips", clients, commands, round_trips);
+    throughput("epoll", setup_epoll, clients, commands);
+    throughput("io_uring", setup_uring, clients, commands);
+    latency("epoll", setup_epoll, round_trips);
+    latency("io_uring", setup_uring, round_trips);
+    return 0;
+}
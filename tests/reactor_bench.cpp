@@ -0,0 +1,157 @@
+// Wakeups of the event loop, the way it used to register the X socket vs. the reactor. A peer thread plays the X server: it sends bursts
+// of 32 byte events over a socket pair, and the loop answers every one with a 32 byte request, like handling an event does. The old way,
+// EPOLLET | EPOLLIN | EPOLLOUT, wakes up for every bit of room the peer's reads make in the socket; the reactor, level triggered EPOLLIN
+// only, wakes up when there's something to read. Then timers & signals on the reactor: a 1ms periodic timer, a thousand one shot timers
+// that get cancelled before they're due (none of them may fire), and SIGTERM, which has to end the loop the way Manager::event_loop ends.
+//      ./reactor_bench [events = 200000] [burst = 16]
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include <coreutils/core.hpp>
+#include <coreutils/reactor.hpp>
+
+using namespace std::chrono;
+
+constexpr std::size_t EVENT_SIZE = 32;
+
+/// Sends events in bursts & reads back whatever requests come in, until it's sent them all & got an answer to each
+void run_server(int fd, int events, int burst)
+{
+    std::vector<char> out(EVENT_SIZE * static_cast<std::size_t>(burst), 'e');
+    std::vector<char> in(64 * 1024);
+    std::size_t answered = 0;
+    for(auto sent = 0; sent < events; sent += burst) {
+        write(fd, out.data(), out.size());
+        // Like the server, it's doing other things between bursts
+        std::this_thread::sleep_for(microseconds{20});
+        for(auto bytes = recv(fd, in.data(), in.size(), MSG_DONTWAIT); bytes > 0; bytes = recv(fd, in.data(), in.size(), MSG_DONTWAIT))
+            answered += static_cast<std::size_t>(bytes) / EVENT_SIZE;
+    }
+    while(answered < static_cast<std::size_t>(events)) {
+        auto bytes = read(fd, in.data(), in.size());
+        if(bytes <= 0)
+            break;
+        answered += static_cast<std::size_t>(bytes) / EVENT_SIZE;
+    }
+    shutdown(fd, SHUT_WR);
+}
+
+struct LoopStats {
+    std::size_t wakeups = 0;
+    /// Woke up & found nothing to read
+    std::size_t empty = 0;
+    std::size_t handled = 0;
+};
+
+/// Reads what's there & answers each event with a request. Returns false once the peer is done
+auto handle_readable(int fd, LoopStats& stats) -> bool
+{
+    char in[4096];
+    char request[EVENT_SIZE]{};
+    auto found = false;
+    for(;;) {
+        auto bytes = recv(fd, in, sizeof(in), MSG_DONTWAIT);
+        if(bytes == 0)
+            return false;
+        if(bytes < 0)
+            break;
+        found = true;
+        for(auto i = 0; i < bytes / static_cast<long>(EVENT_SIZE); ++i) {
+            send(fd, request, sizeof(request), MSG_DONTWAIT);
+            ++stats.handled;
+        }
+    }
+    if(!found)
+        ++stats.empty;
+    return true;
+}
+
+auto run_edge_triggered(int events, int burst) -> LoopStats
+{
+    int fds[2];
+    socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+    std::thread server{run_server, fds[1], events, burst};
+    LoopStats stats{};
+    auto epoll_fd = epoll_create1(0);
+    epoll_event event{};
+    event.events = EPOLLET | EPOLLIN | EPOLLOUT;
+    event.data.fd = fds[0];
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fds[0], &event);
+    for(auto running = true; running;) {
+        epoll_event ready[4];
+        if(epoll_wait(epoll_fd, ready, 4, -1) <= 0)
+            continue;
+        ++stats.wakeups;
+        running = handle_readable(fds[0], stats);
+    }
+    server.join();
+    close(epoll_fd);
+    close(fds[0]);
+    close(fds[1]);
+    return stats;
+}
+
+auto run_reactor(int events, int burst) -> LoopStats
+{
+    int fds[2];
+    socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+    std::thread server{run_server, fds[1], events, burst};
+    LoopStats stats{};
+    auto reactor = cx::Reactor::create();
+    auto running = true;
+    reactor->watch(fds[0], EPOLLIN, [&](int fd, cx::u32) { running = handle_readable(fd, stats); });
+    while(running) {
+        if(reactor->run_once(-1) > 0)
+            ++stats.wakeups;
+    }
+    server.join();
+    close(fds[0]);
+    close(fds[1]);
+    return stats;
+}
+
+int main(int argc, const char** argv)
+{
+    auto events = argc > 1 ? std::atoi(argv[1]) : 200000;
+    auto burst = argc > 2 ? std::max(std::atoi(argv[2]), 1) : 16;
+
+    for(auto [name, stats] : {std::pair{"EPOLLET | EPOLLIN | EPOLLOUT", run_edge_triggered(events, burst)},
+                              std::pair{"reactor, EPOLLIN", run_reactor(events, burst)}}) {
+        cx::println("{:<28} {} events handled, {} wakeups ({:.2f} per burst), {} of them to nothing", name, stats.handled, stats.wakeups,
+                    static_cast<double>(stats.wakeups) * burst / std::max(static_cast<double>(stats.handled), 1.0), stats.empty);
+    }
+
+    auto reactor = cx::Reactor::create();
+    auto running = true;
+    std::size_t ticks = 0;
+    std::size_t cancelled_fired = 0;
+    std::size_t wakeups = 0;
+    reactor->handle_signals({SIGTERM}, [&](int) { running = false; });
+    reactor->add_timer(milliseconds{1}, milliseconds{1}, [&] { ++ticks; });
+    std::vector<int> doomed;
+    for(auto i = 0; i < 1000; ++i)
+        doomed.push_back(reactor->add_timer(milliseconds{50 + i % 50}, nanoseconds{0}, [&] { ++cancelled_fired; }));
+    // Cancelled from inside the loop, like a debounce would
+    reactor->add_timer(milliseconds{10}, nanoseconds{0}, [&] {
+        for(auto timer : doomed)
+            reactor->cancel_timer(timer);
+    });
+    reactor->add_timer(milliseconds{200}, nanoseconds{0}, [] { kill(getpid(), SIGTERM); });
+    auto start = steady_clock::now();
+    while(running) {
+        if(reactor->run_once(-1) > 0)
+            ++wakeups;
+    }
+    auto elapsed = duration_cast<milliseconds>(steady_clock::now() - start).count();
+    cx::println("timers: {} ticks of a 1ms timer in {}ms, {} wakeups, {} of 1000 cancelled timers fired", ticks, elapsed, wakeups,
+                cancelled_fired);
+    cx::println("SIGTERM ended the loop{}", cancelled_fired == 0 ? "" : "; cancelled timers fired, which they must not");
+    return cancelled_fired == 0 ? 0 : 1;
+}
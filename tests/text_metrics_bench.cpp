@@ -0,0 +1,77 @@
+// Measures 10k window titles, once by asking the X server (xcb_query_text_extents, one round trip per title), once with FontMetrics.
+// Run it against any X server, i.e.
+//      Xvfb :99 & DISPLAY=:99 ./text_metrics_bench 10000
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <xcb/xcb.h>
+
+#include <coreutils/core.hpp>
+#include <xcom/utility/drawing/font_metrics.hpp>
+#include <xcom/utility/raii.hpp>
+
+using namespace std::chrono;
+
+auto make_titles(int count) -> std::vector<std::string>
+{
+    std::vector<std::string> titles;
+    titles.reserve(count);
+    for(auto i = 0; i < count; ++i) {
+        titles.push_back("user@host: ~/projects/cxwm/src - vim manager.cpp [" + std::to_string(i) + "]");
+    }
+    return titles;
+}
+
+/// xcb_query_text_extents takes 16-bit characters
+auto to_char2b(const std::string& text) -> std::vector<xcb_char2b_t>
+{
+    std::vector<xcb_char2b_t> chars;
+    chars.reserve(text.size());
+    for(auto ch : text)
+        chars.push_back(xcb_char2b_t{0, static_cast<std::uint8_t>(ch)});
+    return chars;
+}
+
+int main(int argc, const char** argv)
+{
+    auto count = argc > 1 ? std::atoi(argv[1]) : 10000;
+    auto c = xcb_connect(nullptr, nullptr);
+    if(xcb_connection_has_error(c)) {
+        cx::println("Could not connect to X server. Is DISPLAY set?");
+        return 1;
+    }
+    std::string_view font_name = "7x13";
+    auto font = xcb_generate_id(c);
+    if(cx::x11::X11Resource err = xcb_request_check(c, xcb_open_font_checked(c, font, font_name.size(), font_name.data())); err) {
+        cx::println("Could not open font {}", font_name);
+        return 1;
+    }
+    auto titles = make_titles(count);
+
+    long server_total = 0;
+    auto start = steady_clock::now();
+    for(const auto& title : titles) {
+        auto chars = to_char2b(title);
+        cx::x11::X11Resource extents = xcb_query_text_extents_reply(c, xcb_query_text_extents(c, font, chars.size(), chars.data()), nullptr);
+        server_total += extents ? extents->overall_width : 0;
+    }
+    auto server_time = duration_cast<microseconds>(steady_clock::now() - start).count();
+
+    start = steady_clock::now();
+    auto metrics = cx::draw::FontMetrics::query(c, font);
+    long local_total = 0;
+    for(const auto& title : titles) {
+        local_total += metrics->width(title);
+    }
+    auto local_time = duration_cast<microseconds>(steady_clock::now() - start).count();
+
+    cx::println("{} titles", count);
+    cx::println("xcb_query_text_extents: {}us ({} round trips), total width {}", server_time, count, server_total);
+    cx::println("FontMetrics:            {}us (1 round trip), total width {}", local_time, local_total);
+    if(server_total != local_total)
+        cx::println("Widths differ!");
+    xcb_close_font(c, font);
+    xcb_disconnect(c);
+    return server_total == local_total ? 0 : 1;
+}
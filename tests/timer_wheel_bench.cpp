@@ -0,0 +1,110 @@
+// Timer wheel on the reactor. First N timers, due anywhere from 1ms to a minute out, get armed & then all cancelled: what that costs per
+// timer, how many allocations it takes (none), and, after running the loop for a while, how many times the timerfd went off for them
+// (never). Then N timers due within 200ms, every other one cancelled: the rest have to fire, not early, and not much late. Last, a
+// debouncer hit 100 times for each of 1000 keys, which has to run its handler once per key.
+//      ./timer_wheel_bench [timers = 100000]
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+#include <coreutils/core.hpp>
+#include <coreutils/reactor.hpp>
+#include <coreutils/timer_wheel.hpp>
+
+using namespace std::chrono;
+
+static std::atomic<std::size_t> allocations = 0;
+
+void* operator new(std::size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if(auto memory = std::malloc(size))
+        return memory;
+    throw std::bad_alloc{};
+}
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, std::size_t) noexcept { std::free(memory); }
+
+/// Runs the loop until done() or for at most limit
+template<typename Done>
+void run(cx::Reactor& reactor, milliseconds limit, Done done)
+{
+    const auto start = steady_clock::now();
+    while(!done() && steady_clock::now() - start < limit)
+        reactor.run_once(10);
+}
+
+int main(int argc, const char** argv)
+{
+    const auto count = static_cast<std::size_t>(argc > 1 ? std::atoi(argv[1]) : 100000);
+    auto reactor = cx::Reactor::create();
+    auto wheel = cx::TimerWheel::create(*reactor);
+
+    std::size_t fired = 0;
+    std::vector<cx::TimerNode> timers(count);
+    for(auto& timer : timers)
+        timer.on_expiry = [&fired] { ++fired; };
+
+    // Armed & cancelled, without ever going to sleep in between
+    const auto allocations_before = allocations.load();
+    auto start = steady_clock::now();
+    for(std::size_t i = 0; i < count; ++i)
+        wheel->arm(timers[i], milliseconds{1 + (i * 7919) % 60000});
+    auto armed = steady_clock::now();
+    for(auto& timer : timers)
+        wheel->cancel(timer);
+    auto cancelled = steady_clock::now();
+    const auto allocated = allocations.load() - allocations_before;
+    run(*reactor, milliseconds{300}, [] { return false; });
+    cx::println("{} timers armed in {:.1f}ns each, cancelled in {:.1f}ns each, {} allocations; {} wakeups & {} fired in the 300ms after",
+                count, static_cast<double>(duration_cast<nanoseconds>(armed - start).count()) / static_cast<double>(count),
+                static_cast<double>(duration_cast<nanoseconds>(cancelled - armed).count()) / static_cast<double>(count), allocated,
+                wheel->wakeups(), fired);
+    const auto cancelled_ok = wheel->wakeups() == 0 && fired == 0 && allocated == 0;
+
+    // Half of them cancelled, the other half has to fire on time
+    std::vector<steady_clock::time_point> deadlines(count);
+    nanoseconds worst_late{0};
+    nanoseconds total_late{0};
+    std::size_t early = 0;
+    for(std::size_t i = 0; i < count; ++i) {
+        timers[i].on_expiry = [&, i] {
+            ++fired;
+            auto late = steady_clock::now() - deadlines[i];
+            if(late < nanoseconds{0})
+                ++early;
+            worst_late = std::max(worst_late, duration_cast<nanoseconds>(late));
+            total_late += duration_cast<nanoseconds>(late);
+        };
+    }
+    const auto wakeups_before = wheel->wakeups();
+    start = steady_clock::now();
+    for(std::size_t i = 0; i < count; ++i) {
+        const auto delay = microseconds{(i * 7919) % 200000};
+        deadlines[i] = steady_clock::now() + delay;
+        wheel->arm(timers[i], delay);
+    }
+    for(std::size_t i = 0; i < count; i += 2)
+        wheel->cancel(timers[i]);
+    run(*reactor, milliseconds{2000}, [&] { return wheel->pending() == 0; });
+    const auto expected = count / 2;
+    cx::println("{} of {} timers due within 200ms fired, {} early, {:.0f}us late on average, {}us at worst; {} wakeups", fired, expected,
+                early, static_cast<double>(total_late.count()) / 1000.0 / static_cast<double>(std::max<std::size_t>(fired, 1)),
+                duration_cast<microseconds>(worst_late).count(), wheel->wakeups() - wakeups_before);
+    const auto fired_ok = fired == expected && early == 0;
+
+    std::vector<std::size_t> runs(1000);
+    cx::Debouncer debouncer{*wheel, milliseconds{16}, [&runs](std::uint64_t key) { ++runs[key]; }};
+    for(auto round = 0; round < 100; ++round) {
+        for(std::uint64_t key = 0; key < runs.size(); ++key)
+            debouncer.debounce(key);
+    }
+    run(*reactor, milliseconds{500}, [&] { return wheel->pending() == 0; });
+    const auto debounced_ok = std::all_of(runs.begin(), runs.end(), [](auto n) { return n == 1; });
+    cx::println("debouncer: 100000 calls over {} keys, handler ran {} once per key", runs.size(), debounced_ok ? "exactly" : "NOT");
+    return cancelled_ok && fired_ok && debounced_ok ? 0 : 1;
+}